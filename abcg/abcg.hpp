@@ -10,10 +10,25 @@
 #ifndef ABCG_HPP_
 #define ABCG_HPP_
 
+#include "abcg_aabbtree.hpp"
 #include "abcg_application.hpp"
+#include "abcg_collisionmesh.hpp"
+#include "abcg_depthpyramid.hpp"
 #include "abcg_elapsedtimer.hpp"
+#include "abcg_frustum.hpp"
+#include "abcg_geometrypool.hpp"
+#include "abcg_gpuculler.hpp"
 #include "abcg_image.hpp"
+#include "abcg_mesh.hpp"
+#include "abcg_meshlet.hpp"
+#include "abcg_meshoptimizer.hpp"
+#include "abcg_meshsimplifier.hpp"
+#include "abcg_objloader.hpp"
+#include "abcg_occlusionculler.hpp"
+#include "abcg_renderqueue.hpp"
+#include "abcg_streambuffer.hpp"
 #include "abcg_string.hpp"
+#include "abcg_texturestreamer.hpp"
 #include "abcg_trackball.hpp"
 
 #endif
\ No newline at end of file
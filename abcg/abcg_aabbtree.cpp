@@ -0,0 +1,356 @@
+/**
+ * @file abcg_aabbtree.cpp
+ * @brief Definition of abcg::AABBTree class members.
+ *
+ * Insertion and balancing follow Box2D's b2DynamicTree by Erin Catto.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_aabbtree.hpp"
+
+#include <algorithm>
+#include <cppitertools/itertools.hpp>
+#include <glm/common.hpp>
+#include <glm/matrix.hpp>
+
+/**
+ * @brief Returns the axis-aligned box that bounds this box after a
+ * transformation.
+ *
+ * @param matrix Affine transformation matrix.
+ *
+ * @return Bounding box of the transformed box.
+ */
+abcg::AABB abcg::AABB::transform(const glm::mat4& matrix) const {
+  // The extents along each axis are the absolute values of the
+  // transformed axes weighted by the original extents (Arvo, "Transforming
+  // Axis-Aligned Bounding Boxes", Graphics Gems, 1990)
+  const auto center{(boundsMin + boundsMax) * 0.5f};
+  const auto extents{(boundsMax - boundsMin) * 0.5f};
+  const glm::vec3 newCenter{matrix * glm::vec4{center, 1.0f}};
+  glm::vec3 newExtents{};
+  for (const auto axis : iter::range(3)) {
+    newExtents += glm::abs(glm::vec3{matrix[axis]}) * extents[axis];
+  }
+  return {.boundsMin = newCenter - newExtents,
+          .boundsMax = newCenter + newExtents};
+}
+
+/**
+ * @brief Returns the smallest box that contains this box and another.
+ *
+ * @param other Other box.
+ *
+ * @return Union of the boxes.
+ */
+abcg::AABB abcg::AABB::merge(const AABB& other) const {
+  return {.boundsMin = glm::min(boundsMin, other.boundsMin),
+          .boundsMax = glm::max(boundsMax, other.boundsMax)};
+}
+
+/**
+ * @brief Tests whether another box is inside this one.
+ *
+ * @param other Other box.
+ *
+ * @return true if the other box is entirely inside.
+ */
+bool abcg::AABB::contains(const AABB& other) const {
+  return glm::all(glm::lessThanEqual(boundsMin, other.boundsMin)) &&
+         glm::all(glm::lessThanEqual(other.boundsMax, boundsMax));
+}
+
+/**
+ * @brief Returns the surface area of the box.
+ */
+float abcg::AABB::getSurfaceArea() const {
+  const auto size{boundsMax - boundsMin};
+  return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+}
+
+/**
+ * @brief Adds an object to the tree.
+ *
+ * @param box Bounding box of the object.
+ * @param userData Value returned by query() when the object is visible.
+ *
+ * @return Proxy that identifies the object in the tree.
+ */
+std::size_t abcg::AABBTree::insert(const AABB& box, std::size_t userData) {
+  const auto leaf{allocateNode()};
+  auto& node{m_nodes.at(leaf)};
+  node.box = {.boundsMin = box.boundsMin - m_margin,
+              .boundsMax = box.boundsMax + m_margin};
+  node.userData = userData;
+  node.height = 0;
+  insertLeaf(leaf);
+  ++m_leafCount;
+  return leaf;
+}
+
+/**
+ * @brief Removes an object from the tree.
+ *
+ * @param proxy Proxy returned by insert().
+ */
+void abcg::AABBTree::remove(std::size_t proxy) {
+  removeLeaf(proxy);
+  freeNode(proxy);
+  --m_leafCount;
+}
+
+/**
+ * @brief Updates the bounding box of an object.
+ *
+ * The tree only changes if the new box is not inside the enlarged box of
+ * the object.
+ *
+ * @param proxy Proxy returned by insert().
+ * @param box New bounding box of the object.
+ *
+ * @return true if the object was reinserted.
+ */
+bool abcg::AABBTree::move(std::size_t proxy, const AABB& box) {
+  if (m_nodes.at(proxy).box.contains(box)) return false;
+
+  removeLeaf(proxy);
+  m_nodes.at(proxy).box = {.boundsMin = box.boundsMin - m_margin,
+                           .boundsMax = box.boundsMax + m_margin};
+  insertLeaf(proxy);
+  return true;
+}
+
+/**
+ * @brief Removes all objects.
+ */
+void abcg::AABBTree::clear() {
+  m_nodes.clear();
+  m_root = nullProxy;
+  m_freeList = nullProxy;
+  m_leafCount = 0;
+}
+
+/**
+ * @brief Finds the objects whose enlarged boxes intersect a frustum.
+ *
+ * Subtrees entirely inside the frustum are added without further tests.
+ *
+ * @param frustum View frustum, in the same space as the boxes.
+ * @param userData Values given to insert() of the objects found. Cleared
+ * first.
+ */
+void abcg::AABBTree::query(const Frustum& frustum,
+                           std::vector<std::size_t>& userData) const {
+  userData.clear();
+  if (m_root == nullProxy) return;
+
+  m_stack.clear();
+  m_stack.emplace_back(m_root, false);
+  while (!m_stack.empty()) {
+    auto [index, inside]{m_stack.back()};
+    m_stack.pop_back();
+    const auto& node{m_nodes.at(index)};
+
+    if (!inside) {
+      const auto containment{
+          frustum.testBox(node.box.boundsMin, node.box.boundsMax)};
+      if (containment == Frustum::Containment::Outside) continue;
+      inside = containment == Frustum::Containment::Inside;
+    }
+
+    if (node.isLeaf()) {
+      userData.push_back(node.userData);
+    } else {
+      m_stack.emplace_back(node.child1, inside);
+      m_stack.emplace_back(node.child2, inside);
+    }
+  }
+}
+
+/**
+ * @brief Returns the height of the tree. 0 if empty or with a single
+ * object.
+ */
+int abcg::AABBTree::getHeight() const {
+  return m_root == nullProxy ? 0 : m_nodes.at(m_root).height;
+}
+
+std::size_t abcg::AABBTree::allocateNode() {
+  if (m_freeList == nullProxy) {
+    m_nodes.emplace_back();
+    return m_nodes.size() - 1;
+  }
+  const auto index{m_freeList};
+  m_freeList = m_nodes.at(index).parent;
+  m_nodes.at(index) = {};
+  return index;
+}
+
+void abcg::AABBTree::freeNode(std::size_t node) {
+  m_nodes.at(node) = {.box = {},
+                      .parent = m_freeList,
+                      .child1 = nullProxy,
+                      .child2 = nullProxy,
+                      .height = -1,
+                      .userData = 0};
+  m_freeList = node;
+}
+
+// Inserts a leaf next to the node whose merged box costs the least surface
+// area, counting the growth of the boxes of the ancestors
+void abcg::AABBTree::insertLeaf(std::size_t leaf) {
+  if (m_root == nullProxy) {
+    m_root = leaf;
+    m_nodes.at(leaf).parent = nullProxy;
+    return;
+  }
+
+  const auto leafBox{m_nodes.at(leaf).box};
+  auto index{m_root};
+  while (!m_nodes.at(index).isLeaf()) {
+    const auto& node{m_nodes.at(index)};
+    const auto area{node.box.getSurfaceArea()};
+    const auto combinedArea{node.box.merge(leafBox).getSurfaceArea()};
+
+    // Cost of making a new parent for this node and the leaf
+    const auto cost{2.0f * combinedArea};
+    // Minimum cost of pushing the leaf further down
+    const auto inheritanceCost{2.0f * (combinedArea - area)};
+
+    auto descendCost{[&](std::size_t child) {
+      const auto& childBox{m_nodes.at(child).box};
+      const auto mergedArea{childBox.merge(leafBox).getSurfaceArea()};
+      if (m_nodes.at(child).isLeaf()) return mergedArea + inheritanceCost;
+      return mergedArea - childBox.getSurfaceArea() + inheritanceCost;
+    }};
+    const auto cost1{descendCost(node.child1)};
+    const auto cost2{descendCost(node.child2)};
+
+    if (cost < cost1 && cost < cost2) break;
+    index = cost1 < cost2 ? node.child1 : node.child2;
+  }
+
+  const auto sibling{index};
+  const auto oldParent{m_nodes.at(sibling).parent};
+  const auto newParent{allocateNode()};
+  auto& parent{m_nodes.at(newParent)};
+  parent.parent = oldParent;
+  parent.box = leafBox.merge(m_nodes.at(sibling).box);
+  parent.height = m_nodes.at(sibling).height + 1;
+  parent.child1 = sibling;
+  parent.child2 = leaf;
+  m_nodes.at(sibling).parent = newParent;
+  m_nodes.at(leaf).parent = newParent;
+
+  if (oldParent == nullProxy) {
+    m_root = newParent;
+  } else {
+    replaceChild(oldParent, sibling, newParent);
+  }
+
+  refit(newParent);
+}
+
+// Detaches a leaf and replaces its parent with its sibling
+void abcg::AABBTree::removeLeaf(std::size_t leaf) {
+  if (leaf == m_root) {
+    m_root = nullProxy;
+    return;
+  }
+
+  const auto parent{m_nodes.at(leaf).parent};
+  const auto grandParent{m_nodes.at(parent).parent};
+  const auto sibling{m_nodes.at(parent).child1 == leaf
+                         ? m_nodes.at(parent).child2
+                         : m_nodes.at(parent).child1};
+  freeNode(parent);
+  m_nodes.at(sibling).parent = grandParent;
+
+  if (grandParent == nullProxy) {
+    m_root = sibling;
+  } else {
+    replaceChild(grandParent, parent, sibling);
+    refit(grandParent);
+  }
+}
+
+// Rebalances a node and its ancestors and updates their boxes and heights
+void abcg::AABBTree::refit(std::size_t node) {
+  for (auto index{node}; index != nullProxy;) {
+    index = balance(index);
+    auto& current{m_nodes.at(index)};
+    const auto& child1{m_nodes.at(current.child1)};
+    const auto& child2{m_nodes.at(current.child2)};
+    current.height = 1 + std::max(child1.height, child2.height);
+    current.box = child1.box.merge(child2.box);
+    index = current.parent;
+  }
+}
+
+// Rotates the taller child of a node up if the heights of its children
+// differ by more than 1. Returns the node that took its place
+std::size_t abcg::AABBTree::balance(std::size_t indexA) {
+  auto& nodeA{m_nodes.at(indexA)};
+  if (nodeA.isLeaf() || nodeA.height < 2) return indexA;
+
+  const auto indexB{nodeA.child1};
+  const auto indexC{nodeA.child2};
+  auto& nodeB{m_nodes.at(indexB)};
+  auto& nodeC{m_nodes.at(indexC)};
+  const auto heightDifference{nodeC.height - nodeB.height};
+
+  // Moves up the child at indexUp, keeping the other child of A. Its
+  // taller grandchild stays with it and the other one goes to A
+  auto rotate{[&](std::size_t indexUp, bool upIsChild2) {
+    auto& nodeUp{m_nodes.at(indexUp)};
+    const auto indexF{nodeUp.child1};
+    const auto indexG{nodeUp.child2};
+    auto& nodeF{m_nodes.at(indexF)};
+    auto& nodeG{m_nodes.at(indexG)};
+    const auto indexKept{upIsChild2 ? indexB : indexC};
+
+    nodeUp.child1 = indexA;
+    nodeUp.parent = nodeA.parent;
+    nodeA.parent = indexUp;
+    if (nodeUp.parent == nullProxy) {
+      m_root = indexUp;
+    } else {
+      replaceChild(nodeUp.parent, indexA, indexUp);
+    }
+
+    const auto fTaller{nodeF.height > nodeG.height};
+    const auto indexStays{fTaller ? indexF : indexG};
+    const auto indexMoves{fTaller ? indexG : indexF};
+    nodeUp.child2 = indexStays;
+    if (upIsChild2) {
+      nodeA.child2 = indexMoves;
+    } else {
+      nodeA.child1 = indexMoves;
+    }
+    m_nodes.at(indexMoves).parent = indexA;
+
+    const auto& kept{m_nodes.at(indexKept)};
+    const auto& moves{m_nodes.at(indexMoves)};
+    const auto& stays{m_nodes.at(indexStays)};
+    nodeA.box = kept.box.merge(moves.box);
+    nodeA.height = 1 + std::max(kept.height, moves.height);
+    nodeUp.box = nodeA.box.merge(stays.box);
+    nodeUp.height = 1 + std::max(nodeA.height, stays.height);
+    return indexUp;
+  }};
+
+  if (heightDifference > 1) return rotate(indexC, true);
+  if (heightDifference < -1) return rotate(indexB, false);
+  return indexA;
+}
+
+void abcg::AABBTree::replaceChild(std::size_t parent, std::size_t oldChild,
+                                  std::size_t newChild) {
+  auto& node{m_nodes.at(parent)};
+  if (node.child1 == oldChild) {
+    node.child1 = newChild;
+  } else {
+    node.child2 = newChild;
+  }
+}
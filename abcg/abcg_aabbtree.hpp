@@ -0,0 +1,112 @@
+/**
+ * @file abcg_aabbtree.hpp
+ * @brief abcg::AABBTree header file.
+ *
+ * Declaration of abcg::AABBTree class and its bounding box type.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_AABBTREE_HPP_
+#define ABCG_AABBTREE_HPP_
+
+#include <cstddef>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "abcg_frustum.hpp"
+
+namespace abcg {
+struct AABB;
+class AABBTree;
+}  // namespace abcg
+
+/**
+ * @brief Axis-aligned bounding box.
+ */
+struct abcg::AABB {
+  glm::vec3 boundsMin{};
+  glm::vec3 boundsMax{};
+
+  [[nodiscard]] AABB transform(const glm::mat4& matrix) const;
+  [[nodiscard]] AABB merge(const AABB& other) const;
+  [[nodiscard]] bool contains(const AABB& other) const;
+  [[nodiscard]] float getSurfaceArea() const;
+};
+
+/**
+ * @brief abcg::AABBTree class.
+ *
+ * Dynamic bounding volume hierarchy of axis-aligned boxes, for culling the
+ * objects of a scene against the view frustum without testing each one.
+ *
+ * Each object is a leaf whose box is enlarged by a margin, so objects that
+ * move a little don't change the tree. Leaves are inserted next to the
+ * node that least increases the total surface area of the tree, and the
+ * tree is kept balanced with rotations as in Box2D's b2DynamicTree.
+ */
+class abcg::AABBTree {
+ public:
+  /**
+   * @brief Proxy returned for no object.
+   */
+  static constexpr std::size_t nullProxy{
+      std::numeric_limits<std::size_t>::max()};
+
+  AABBTree() = default;
+  explicit AABBTree(float margin) : m_margin{margin} {}
+
+  [[nodiscard]] std::size_t insert(const AABB& box, std::size_t userData);
+  void remove(std::size_t proxy);
+  bool move(std::size_t proxy, const AABB& box);
+  void clear();
+
+  void query(const Frustum& frustum, std::vector<std::size_t>& userData) const;
+
+  [[nodiscard]] std::size_t getUserData(std::size_t proxy) const {
+    return m_nodes.at(proxy).userData;
+  }
+  [[nodiscard]] const AABB& getFatBox(std::size_t proxy) const {
+    return m_nodes.at(proxy).box;
+  }
+  [[nodiscard]] std::size_t size() const { return m_leafCount; }
+  [[nodiscard]] int getHeight() const;
+
+ private:
+  struct Node {
+    AABB box;
+    // Next free node if the node is in the free list
+    std::size_t parent{nullProxy};
+    std::size_t child1{nullProxy};
+    std::size_t child2{nullProxy};
+    // 0 for leaves, -1 for free nodes
+    int height{-1};
+    std::size_t userData{};
+
+    [[nodiscard]] bool isLeaf() const { return child1 == nullProxy; }
+  };
+
+  float m_margin{0.1f};
+  std::vector<Node> m_nodes;
+  std::size_t m_root{nullProxy};
+  std::size_t m_freeList{nullProxy};
+  std::size_t m_leafCount{};
+
+  // Nodes left to visit by query(), and whether they are known to be
+  // inside the frustum
+  mutable std::vector<std::pair<std::size_t, bool>> m_stack;
+
+  [[nodiscard]] std::size_t allocateNode();
+  void freeNode(std::size_t node);
+  void insertLeaf(std::size_t leaf);
+  void removeLeaf(std::size_t leaf);
+  void refit(std::size_t node);
+  [[nodiscard]] std::size_t balance(std::size_t node);
+  void replaceChild(std::size_t parent, std::size_t oldChild,
+                    std::size_t newChild);
+};
+
+#endif
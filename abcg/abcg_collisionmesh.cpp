@@ -0,0 +1,176 @@
+/**
+ * @file abcg_collisionmesh.cpp
+ * @brief Definition of abcg::CollisionMesh class members.
+ *
+ * The ray-triangle test is the one of Moller and Trumbore, "Fast, Minimum
+ * Storage Ray/Triangle Intersection", Journal of Graphics Tools, 1997. The
+ * closest point on a triangle follows Ericson, "Real-Time Collision
+ * Detection", 2005, section 5.1.5.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_collisionmesh.hpp"
+
+#include <algorithm>
+#include <cppitertools/itertools.hpp>
+#include <glm/geometric.hpp>
+#include <limits>
+#include <utility>
+
+namespace {
+// Point of the triangle abc closest to p
+glm::vec3 closestPointOnTriangle(const glm::vec3& p, const glm::vec3& a,
+                                 const glm::vec3& b, const glm::vec3& c) {
+  const auto ab{b - a};
+  const auto ac{c - a};
+  const auto ap{p - a};
+  const auto d1{glm::dot(ab, ap)};
+  const auto d2{glm::dot(ac, ap)};
+  if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+  const auto bp{p - b};
+  const auto d3{glm::dot(ab, bp)};
+  const auto d4{glm::dot(ac, bp)};
+  if (d3 >= 0.0f && d4 <= d3) return b;
+
+  const auto vc{d1 * d4 - d3 * d2};
+  if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+    return a + ab * (d1 / (d1 - d3));
+  }
+
+  const auto cp{p - c};
+  const auto d5{glm::dot(ab, cp)};
+  const auto d6{glm::dot(ac, cp)};
+  if (d6 >= 0.0f && d5 <= d6) return c;
+
+  const auto vb{d5 * d2 - d1 * d6};
+  if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+    return a + ac * (d2 / (d2 - d6));
+  }
+
+  const auto va{d3 * d6 - d5 * d4};
+  if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f) {
+    return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+  }
+
+  const auto denominator{1.0f / (va + vb + vc)};
+  return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+}  // namespace
+
+/**
+ * @brief Constructs a collision mesh from a triangle list.
+ *
+ * @param positions Vertex positions.
+ * @param indices Indices of the triangles into positions.
+ */
+abcg::CollisionMesh::CollisionMesh(std::vector<glm::vec3> positions,
+                                   std::vector<GLuint> indices)
+    : m_positions{std::move(positions)}, m_indices{std::move(indices)} {
+  m_positions.shrink_to_fit();
+  m_indices.shrink_to_fit();
+  if (m_positions.empty()) return;
+
+  m_boundsMin = m_boundsMax = m_positions.front();
+  for (const auto& position : m_positions) {
+    m_boundsMin = glm::min(m_boundsMin, position);
+    m_boundsMax = glm::max(m_boundsMax, position);
+  }
+}
+
+/**
+ * @brief Finds the nearest intersection of a ray with the triangles.
+ *
+ * Both faces of the triangles are hit.
+ *
+ * @param origin Origin of the ray.
+ * @param direction Direction of the ray. Distances are in units of its
+ * length.
+ *
+ * @return Distance from the origin to the nearest hit, or no value if the
+ * ray misses all triangles.
+ */
+std::optional<float> abcg::CollisionMesh::intersectRay(
+    const glm::vec3& origin, const glm::vec3& direction) const {
+  if (empty()) return std::nullopt;
+
+  // Slab test against the bounding box
+  auto entryDistance{0.0f};
+  auto exitDistance{std::numeric_limits<float>::max()};
+  for (const auto axis : iter::range(3)) {
+    const auto inverse{1.0f / direction[axis]};
+    auto t0{(m_boundsMin[axis] - origin[axis]) * inverse};
+    auto t1{(m_boundsMax[axis] - origin[axis]) * inverse};
+    if (t0 > t1) std::swap(t0, t1);
+    entryDistance = std::max(entryDistance, t0);
+    exitDistance = std::min(exitDistance, t1);
+    if (entryDistance > exitDistance) return std::nullopt;
+  }
+
+  auto nearest{std::numeric_limits<float>::max()};
+  auto hit{false};
+  for (const auto offset : iter::range<std::size_t>(0, m_indices.size(), 3)) {
+    const auto& a{m_positions.at(m_indices.at(offset + 0))};
+    const auto& b{m_positions.at(m_indices.at(offset + 1))};
+    const auto& c{m_positions.at(m_indices.at(offset + 2))};
+    const auto ab{b - a};
+    const auto ac{c - a};
+    const auto p{glm::cross(direction, ac)};
+    const auto determinant{glm::dot(ab, p)};
+    if (determinant == 0.0f) continue;
+
+    const auto inverse{1.0f / determinant};
+    const auto s{origin - a};
+    const auto u{glm::dot(s, p) * inverse};
+    if (u < 0.0f || u > 1.0f) continue;
+    const auto q{glm::cross(s, ab)};
+    const auto v{glm::dot(direction, q) * inverse};
+    if (v < 0.0f || u + v > 1.0f) continue;
+
+    const auto t{glm::dot(ac, q) * inverse};
+    if (t >= 0.0f && t <= nearest) {
+      nearest = t;
+      hit = true;
+    }
+  }
+  if (!hit) return std::nullopt;
+  return nearest;
+}
+
+/**
+ * @brief Tests whether a sphere touches any triangle.
+ *
+ * @param center Center of the sphere.
+ * @param radius Radius of the sphere.
+ *
+ * @return true if the distance from the center to a triangle is at most
+ * radius.
+ */
+bool abcg::CollisionMesh::intersectsSphere(const glm::vec3& center,
+                                           float radius) const {
+  if (empty()) return false;
+
+  // Distance to the bounding box
+  const auto outside{glm::max(m_boundsMin - center, center - m_boundsMax)};
+  if (glm::length(glm::max(outside, glm::vec3{0})) > radius) return false;
+
+  const auto squaredRadius{radius * radius};
+  for (const auto offset : iter::range<std::size_t>(0, m_indices.size(), 3)) {
+    const auto closest{closestPointOnTriangle(
+        center, m_positions.at(m_indices.at(offset + 0)),
+        m_positions.at(m_indices.at(offset + 1)),
+        m_positions.at(m_indices.at(offset + 2)))};
+    const auto difference{closest - center};
+    if (glm::dot(difference, difference) <= squaredRadius) return true;
+  }
+  return false;
+}
+
+/**
+ * @brief Number of bytes allocated for the positions and indices.
+ */
+std::size_t abcg::CollisionMesh::getMemoryUsage() const {
+  return m_positions.capacity() * sizeof(glm::vec3) +
+         m_indices.capacity() * sizeof(GLuint);
+}
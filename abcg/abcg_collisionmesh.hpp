@@ -0,0 +1,59 @@
+/**
+ * @file abcg_collisionmesh.hpp
+ * @brief abcg::CollisionMesh header file.
+ *
+ * Declaration of abcg::CollisionMesh class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_COLLISIONMESH_HPP_
+#define ABCG_COLLISIONMESH_HPP_
+
+#include <cstddef>
+#include <glm/vec3.hpp>
+#include <optional>
+#include <vector>
+
+#include "abcg_external.hpp"
+
+namespace abcg {
+class CollisionMesh;
+}  // namespace abcg
+
+/**
+ * @brief abcg::CollisionMesh class.
+ *
+ * Positions and triangles of a mesh without the other vertex attributes,
+ * for ray casts and collision tests on the CPU once the render data lives
+ * only on the GPU.
+ */
+class abcg::CollisionMesh {
+ public:
+  CollisionMesh() = default;
+  CollisionMesh(std::vector<glm::vec3> positions, std::vector<GLuint> indices);
+
+  [[nodiscard]] std::optional<float> intersectRay(
+      const glm::vec3& origin, const glm::vec3& direction) const;
+  [[nodiscard]] bool intersectsSphere(const glm::vec3& center,
+                                      float radius) const;
+
+  [[nodiscard]] bool empty() const { return m_indices.empty(); }
+  [[nodiscard]] const std::vector<glm::vec3>& getPositions() const {
+    return m_positions;
+  }
+  [[nodiscard]] const std::vector<GLuint>& getIndices() const {
+    return m_indices;
+  }
+  [[nodiscard]] std::size_t getMemoryUsage() const;
+
+ private:
+  std::vector<glm::vec3> m_positions;
+  std::vector<GLuint> m_indices;
+
+  // Axis-aligned bounding box of the positions, for early rejection
+  glm::vec3 m_boundsMin{};
+  glm::vec3 m_boundsMax{};
+};
+
+#endif
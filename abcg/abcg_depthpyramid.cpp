@@ -0,0 +1,151 @@
+/**
+ * @file abcg_depthpyramid.cpp
+ * @brief Definition of abcg::DepthPyramid class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_depthpyramid.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cppitertools/itertools.hpp>
+#include <gsl/gsl>
+
+namespace {
+// Work group size of the reduction shader in each dimension
+constexpr GLuint groupSize{8};
+}  // namespace
+
+/**
+ * @brief Returns whether the pyramid can be built, which requires compute
+ * shaders and image load/store, core in OpenGL 4.3.
+ */
+bool abcg::DepthPyramid::isSupported() {
+#if defined(__EMSCRIPTEN__)
+  return false;
+#else
+  return GLEW_VERSION_4_3;
+#endif
+}
+
+/**
+ * @brief Sets up the compute program that builds the levels.
+ *
+ * @param program Compute program with the level and depthTex uniform
+ * variables.
+ */
+void abcg::DepthPyramid::initializeGL(GLuint program) {
+  terminateGL();
+
+  m_program = program;
+  m_levelLocation = glGetUniformLocation(program, "level");
+  glUseProgram(program);
+  glUniform1i(glGetUniformLocation(program, "depthTex"), 0);
+  glUseProgram(0);
+}
+
+/**
+ * @brief Deletes the textures and the framebuffer. The program is not
+ * deleted.
+ */
+void abcg::DepthPyramid::terminateGL() {
+  deleteTextures();
+  m_size = {};
+  m_numLevels = 0;
+}
+
+/**
+ * @brief Creates the textures for a new size of the default framebuffer.
+ *
+ * The pyramid is invalid until the next update().
+ *
+ * @param width Width of the framebuffer in pixels.
+ * @param height Height of the framebuffer in pixels.
+ */
+void abcg::DepthPyramid::resize(int width, int height) {
+  deleteTextures();
+  m_size = {std::max(width, 1), std::max(height, 1)};
+  // std::bit_width returns int or unsigned depending on the library
+  m_numLevels = gsl::narrow_cast<int>(std::bit_width(
+      static_cast<unsigned int>(std::max(m_size.x, m_size.y))));
+
+#if !defined(__EMSCRIPTEN__)
+  glGenTextures(1, &m_depthTexture);
+  glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+  glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH24_STENCIL8, m_size.x, m_size.y);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+  glGenTextures(1, &m_pyramid);
+  glBindTexture(GL_TEXTURE_2D, m_pyramid);
+  glTexStorage2D(GL_TEXTURE_2D, m_numLevels, GL_R32F, m_size.x, m_size.y);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  GL_NEAREST_MIPMAP_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glGenFramebuffers(1, &m_framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT,
+                         GL_TEXTURE_2D, m_depthTexture, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+#endif
+}
+
+/**
+ * @brief Builds the pyramid from the depth buffer of the default
+ * framebuffer.
+ *
+ * Must be called after the scene of the frame is drawn. Changes the
+ * texture and sampler bound to texture unit 0 and the images bound to
+ * units 0 and 1.
+ *
+ * @param viewProjMatrix Product of the projection and view matrices the
+ * scene was drawn with.
+ */
+void abcg::DepthPyramid::update(const glm::mat4& viewProjMatrix) {
+  if (m_pyramid == 0) return;
+
+#if !defined(__EMSCRIPTEN__)
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_framebuffer);
+  glBlitFramebuffer(0, 0, m_size.x, m_size.y, 0, 0, m_size.x, m_size.y,
+                    GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  glUseProgram(m_program);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+  glBindSampler(0, 0);
+  for (const auto level : iter::range(m_numLevels)) {
+    const auto width{static_cast<GLuint>(std::max(m_size.x >> level, 1))};
+    const auto height{static_cast<GLuint>(std::max(m_size.y >> level, 1))};
+    glUniform1i(m_levelLocation, level);
+    glBindImageTexture(0, m_pyramid, std::max(level - 1, 0), GL_FALSE, 0,
+                       GL_READ_ONLY, GL_R32F);
+    glBindImageTexture(1, m_pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY,
+                       GL_R32F);
+    glDispatchCompute((width + groupSize - 1) / groupSize,
+                      (height + groupSize - 1) / groupSize, 1);
+    // Each level reads the one written before
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+  }
+  glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+#endif
+
+  m_viewProjMatrix = viewProjMatrix;
+  m_valid = true;
+}
+
+void abcg::DepthPyramid::deleteTextures() {
+  glDeleteFramebuffers(1, &m_framebuffer);
+  glDeleteTextures(1, &m_pyramid);
+  glDeleteTextures(1, &m_depthTexture);
+  m_framebuffer = 0;
+  m_pyramid = 0;
+  m_depthTexture = 0;
+  m_valid = false;
+}
@@ -0,0 +1,85 @@
+/**
+ * @file abcg_depthpyramid.hpp
+ * @brief abcg::DepthPyramid header file.
+ *
+ * Declaration of abcg::DepthPyramid class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_DEPTHPYRAMID_HPP_
+#define ABCG_DEPTHPYRAMID_HPP_
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+
+#include "abcg_external.hpp"
+
+namespace abcg {
+class DepthPyramid;
+}  // namespace abcg
+
+/**
+ * @brief abcg::DepthPyramid class.
+ *
+ * Hierarchical depth buffer (Hi-Z) of a frame, used by abcg::GPUCuller to
+ * find objects hidden behind others without reading anything back.
+ *
+ * update() copies the depth buffer of the default framebuffer, resolving
+ * it if multisampled, to a texture, and builds a single-channel float mip
+ * chain from it with a compute shader. Each texel of a level is the
+ * farthest depth of the texels it covers in the level below, so a box
+ * whose nearest depth is farther than the texels under it is occluded.
+ *
+ * The program given to initializeGL() must be a compute shader with 8x8
+ * work groups that writes the level given by the uniform variable level
+ * to the image at unit 1, reading the level below from the image at unit
+ * 0, or from the depth texture depthTex if level is 0.
+ *
+ * The default framebuffer must have a 24-bit depth buffer with an 8-bit
+ * stencil buffer, as abcg::OpenGLSettings requests by default, as the
+ * copy is done with glBlitFramebuffer. Requires OpenGL 4.3.
+ */
+class abcg::DepthPyramid {
+ public:
+  [[nodiscard]] static bool isSupported();
+
+  void initializeGL(GLuint program);
+  void terminateGL();
+
+  void resize(int width, int height);
+  void update(const glm::mat4& viewProjMatrix);
+
+  [[nodiscard]] GLuint getTexture() const { return m_pyramid; }
+  [[nodiscard]] glm::ivec2 getSize() const { return m_size; }
+  [[nodiscard]] int getNumLevels() const { return m_numLevels; }
+  /**
+   * @brief Returns the view-projection matrix of the frame of the last
+   * update().
+   */
+  [[nodiscard]] const glm::mat4& getViewProjMatrix() const {
+    return m_viewProjMatrix;
+  }
+  /**
+   * @brief Returns whether update() was called since the last resize().
+   */
+  [[nodiscard]] bool isValid() const { return m_valid; }
+
+ private:
+  GLuint m_program{};
+  GLint m_levelLocation{-1};
+
+  // Single-sampled copy of the depth buffer and the framebuffer to blit to
+  GLuint m_depthTexture{};
+  GLuint m_framebuffer{};
+  GLuint m_pyramid{};
+
+  glm::ivec2 m_size{};
+  int m_numLevels{};
+  glm::mat4 m_viewProjMatrix{1.0f};
+  bool m_valid{false};
+
+  void deleteTextures();
+};
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * @file abcg_frustum.cpp
+ * @brief Definition of abcg::Frustum class members.
+ *
+ * The planes are extracted from the rows of the matrix as described by
+ * Gribb and Hartmann, "Fast Extraction of Viewing Frustum Planes from the
+ * World-View-Projection Matrix", 2001.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_frustum.hpp"
+
+#include <cppitertools/itertools.hpp>
+#include <glm/common.hpp>
+#include <glm/geometric.hpp>
+#include <glm/matrix.hpp>
+#include <limits>
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ABCG_FRUSTUM_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+/**
+ * @brief Constructs the frustum of a projection matrix.
+ *
+ * @param matrix Projection matrix, possibly multiplied by view and model
+ * matrices. The clip volume is the OpenGL one, with z in [-w, w].
+ */
+abcg::Frustum::Frustum(const glm::mat4& matrix) {
+  // glm matrices are column-major, so the rows are the columns of the
+  // transpose
+  const auto rows{glm::transpose(matrix)};
+  for (const auto axis : iter::range<std::size_t>(3)) {
+    const auto& row{rows[static_cast<glm::length_t>(axis)]};
+    m_planes.at(axis * 2) = rows[3] + row;
+    m_planes.at(axis * 2 + 1) = rows[3] - row;
+  }
+  for (auto& plane : m_planes) {
+    plane /= glm::length(glm::vec3{plane});
+  }
+
+  for (auto&& [index, plane] : iter::enumerate(m_planes)) {
+    m_normalX.at(index) = plane.x;
+    m_normalY.at(index) = plane.y;
+    m_normalZ.at(index) = plane.z;
+    m_distance.at(index) = plane.w;
+  }
+  m_distance.at(6) = std::numeric_limits<float>::max();
+  m_distance.at(7) = std::numeric_limits<float>::max();
+}
+
+/**
+ * @brief Tests whether a sphere is at least partially inside the frustum.
+ *
+ * The test is conservative: spheres close to the corners of the frustum
+ * may be reported as intersecting while being outside.
+ *
+ * @param center Center of the sphere.
+ * @param radius Radius of the sphere.
+ *
+ * @return false if the sphere is certainly outside.
+ */
+bool abcg::Frustum::intersectsSphere(const glm::vec3& center,
+                                     float radius) const {
+  for (const auto& plane : m_planes) {
+    if (glm::dot(glm::vec3{plane}, center) + plane.w < -radius) return false;
+  }
+  return true;
+}
+
+/**
+ * @brief Tests an axis-aligned box against the frustum.
+ *
+ * For each plane, the box is reduced to the projection of its half extents
+ * on the plane normal, so only its center is tested. Four planes are
+ * tested at once with SSE where available. As with spheres, boxes close to
+ * the corners of the frustum may be reported as intersecting while being
+ * outside.
+ *
+ * @param boxMin Minimum corner of the box.
+ * @param boxMax Maximum corner of the box.
+ *
+ * @return Containment::Outside if the box is certainly outside,
+ * Containment::Inside if it is entirely inside, and
+ * Containment::Intersecting otherwise.
+ */
+abcg::Frustum::Containment abcg::Frustum::testBox(
+    const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+  const auto center{(boxMin + boxMax) * 0.5f};
+  const auto extents{(boxMax - boxMin) * 0.5f};
+  auto intersecting{false};
+
+#if defined(ABCG_FRUSTUM_USE_SSE)
+  const auto centerX{_mm_set1_ps(center.x)};
+  const auto centerY{_mm_set1_ps(center.y)};
+  const auto centerZ{_mm_set1_ps(center.z)};
+  const auto extentX{_mm_set1_ps(extents.x)};
+  const auto extentY{_mm_set1_ps(extents.y)};
+  const auto extentZ{_mm_set1_ps(extents.z)};
+  const auto signMask{_mm_set1_ps(-0.0f)};
+  const auto zero{_mm_setzero_ps()};
+  for (const auto first : {0, 4}) {
+    const auto normalX{_mm_load_ps(m_normalX.data() + first)};
+    const auto normalY{_mm_load_ps(m_normalY.data() + first)};
+    const auto normalZ{_mm_load_ps(m_normalZ.data() + first)};
+    const auto distance{_mm_add_ps(
+        _mm_add_ps(_mm_mul_ps(normalX, centerX), _mm_mul_ps(normalY, centerY)),
+        _mm_add_ps(_mm_mul_ps(normalZ, centerZ),
+                   _mm_load_ps(m_distance.data() + first)))};
+    const auto radius{
+        _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(signMask, normalX),
+                                         extentX),
+                              _mm_mul_ps(_mm_andnot_ps(signMask, normalY),
+                                         extentY)),
+                   _mm_mul_ps(_mm_andnot_ps(signMask, normalZ), extentZ))};
+    if (_mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), zero)) !=
+        0) {
+      return Containment::Outside;
+    }
+    if (_mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), zero)) !=
+        0) {
+      intersecting = true;
+    }
+  }
+#else
+  for (const auto& plane : m_planes) {
+    const glm::vec3 normal{plane};
+    const auto distance{glm::dot(normal, center) + plane.w};
+    const auto radius{glm::dot(glm::abs(normal), extents)};
+    if (distance + radius < 0.0f) return Containment::Outside;
+    if (distance - radius < 0.0f) intersecting = true;
+  }
+#endif
+
+  return intersecting ? Containment::Intersecting : Containment::Inside;
+}
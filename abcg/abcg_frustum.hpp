@@ -0,0 +1,69 @@
+/**
+ * @file abcg_frustum.hpp
+ * @brief abcg::Frustum header file.
+ *
+ * Declaration of abcg::Frustum class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_FRUSTUM_HPP_
+#define ABCG_FRUSTUM_HPP_
+
+#include <array>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+
+namespace abcg {
+class Frustum;
+}  // namespace abcg
+
+/**
+ * @brief abcg::Frustum class.
+ *
+ * The six planes of the view volume of a projection matrix, in the space
+ * the matrix transforms from. Built from a model-view-projection matrix,
+ * the planes are in model space, so bounding volumes can be tested without
+ * being transformed.
+ *
+ * A default-constructed frustum contains everything.
+ */
+class abcg::Frustum {
+ public:
+  /**
+   * @brief Result of testing a bounding volume against the frustum.
+   */
+  enum class Containment { Outside, Intersecting, Inside };
+
+  Frustum() = default;
+  explicit Frustum(const glm::mat4& matrix);
+
+  [[nodiscard]] bool intersectsSphere(const glm::vec3& center,
+                                      float radius) const;
+  [[nodiscard]] Containment testBox(const glm::vec3& boxMin,
+                                    const glm::vec3& boxMax) const;
+  [[nodiscard]] bool intersectsBox(const glm::vec3& boxMin,
+                                   const glm::vec3& boxMax) const {
+    return testBox(boxMin, boxMax) != Containment::Outside;
+  }
+
+  [[nodiscard]] const std::array<glm::vec4, 6>& getPlanes() const {
+    return m_planes;
+  }
+
+ private:
+  // Left, right, bottom, top, near and far planes. The normals point
+  // inwards and are normalized, so the plane equation gives distances
+  std::array<glm::vec4, 6> m_planes{};
+
+  // The same planes with each component in its own array, so that boxes
+  // are tested against 4 planes at once. The last 2 planes are padding
+  // that contains everything
+  alignas(16) std::array<float, 8> m_normalX{};
+  alignas(16) std::array<float, 8> m_normalY{};
+  alignas(16) std::array<float, 8> m_normalZ{};
+  alignas(16) std::array<float, 8> m_distance{};
+};
+
+#endif
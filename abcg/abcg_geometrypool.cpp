@@ -0,0 +1,262 @@
+/**
+ * @file abcg_geometrypool.cpp
+ * @brief Definition of abcg::GeometryPool class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_geometrypool.hpp"
+
+#include <algorithm>
+#include <cppitertools/itertools.hpp>
+
+namespace {
+// Offsets of 32-bit indices must be multiples of 4
+std::size_t alignIndexBytes(std::size_t bytes) { return (bytes + 3) / 4 * 4; }
+}  // namespace
+
+/**
+ * @brief Reserves ranges of vertices and indices for a mesh.
+ *
+ * The buffers of the arena grow if needed. Their contents are kept, but
+ * setupVAO() must have been called for the VAO to be set up again.
+ *
+ * @param format Layout of the vertices.
+ * @param texCoordType Type of the texture coordinates in the layout.
+ * @param vertexCount Number of vertices.
+ * @param indexBytes Size of the indices in bytes.
+ *
+ * @return Handle of the allocation.
+ */
+std::size_t abcg::GeometryPool::allocate(VertexFormat format,
+                                         GLenum texCoordType,
+                                         std::size_t vertexCount,
+                                         std::size_t indexBytes) {
+  const auto arenaIndex{getArena(format, texCoordType)};
+  auto& arena{m_arenas.at(arenaIndex)};
+  const Allocation allocation{
+      .arena = arenaIndex,
+      .firstVertex = arena.vertices.allocate(vertexCount),
+      .vertexCount = vertexCount,
+      .indexOffset = arena.indices.allocate(alignIndexBytes(indexBytes)),
+      .indexBytes = indexBytes};
+  reserve(arena);
+
+  if (m_freeAllocations.empty()) {
+    m_allocations.push_back(allocation);
+    return m_allocations.size() - 1;
+  }
+  const auto handle{m_freeAllocations.back()};
+  m_freeAllocations.pop_back();
+  m_allocations.at(handle) = allocation;
+  return handle;
+}
+
+/**
+ * @brief Copies the vertices and indices of a mesh to its ranges.
+ *
+ * @param allocation Handle returned by allocate().
+ * @param vertices Vertices in the layout of the arena.
+ * @param indices Indices, as many bytes as given to allocate().
+ */
+void abcg::GeometryPool::upload(std::size_t allocation, const void* vertices,
+                                const void* indices) {
+  const auto& ranges{m_allocations.at(allocation)};
+  const auto& arena{m_arenas.at(ranges.arena)};
+
+  // The copy target doesn't change the EBO of the bound VAO
+  glBindBuffer(GL_COPY_WRITE_BUFFER, arena.VBO);
+  glBufferSubData(
+      GL_COPY_WRITE_BUFFER,
+      static_cast<GLintptr>(ranges.firstVertex * arena.vertexSize),
+      static_cast<GLsizeiptr>(ranges.vertexCount * arena.vertexSize),
+      vertices);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, arena.EBO);
+  glBufferSubData(GL_COPY_WRITE_BUFFER,
+                  static_cast<GLintptr>(ranges.indexOffset),
+                  static_cast<GLsizeiptr>(ranges.indexBytes), indices);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+/**
+ * @brief Frees the ranges of a mesh so that other meshes can use them.
+ *
+ * @param allocation Handle returned by allocate(). Invalid afterwards.
+ */
+void abcg::GeometryPool::release(std::size_t allocation) {
+  auto& ranges{m_allocations.at(allocation)};
+  auto& arena{m_arenas.at(ranges.arena)};
+  arena.vertices.release(ranges.firstVertex, ranges.vertexCount);
+  arena.indices.release(ranges.indexOffset,
+                        alignIndexBytes(ranges.indexBytes));
+  ranges = {};
+  m_freeAllocations.push_back(allocation);
+}
+
+/**
+ * @brief Binds the buffers of every arena to the attributes of a program.
+ *
+ * Attributes are matched by name as in abcg::Mesh::setupVAO(). The VAOs
+ * are set up again for this program whenever the buffers grow.
+ *
+ * @param program Shader program.
+ */
+void abcg::GeometryPool::setupVAO(GLuint program) {
+  m_program = program;
+  for (const auto& arena : m_arenas) {
+    setupVAO(arena);
+  }
+}
+
+/**
+ * @brief Releases the buffers and VAOs of all arenas.
+ *
+ * Meshes stored in the pool can't be drawn afterwards.
+ */
+void abcg::GeometryPool::destroy() {
+  for (auto& arena : m_arenas) {
+    glDeleteBuffers(1, &arena.EBO);
+    glDeleteBuffers(1, &arena.VBO);
+    glDeleteVertexArrays(1, &arena.VAO);
+  }
+  m_arenas.clear();
+  m_allocations.clear();
+  m_freeAllocations.clear();
+  m_program = 0;
+}
+
+/**
+ * @brief Returns the total size of the buffers of all arenas in bytes.
+ */
+std::size_t abcg::GeometryPool::getBufferSize() const {
+  std::size_t size{};
+  for (const auto& arena : m_arenas) {
+    size += arena.vertexCapacity + arena.indexCapacity;
+  }
+  return size;
+}
+
+std::size_t abcg::GeometryPool::FreeList::allocate(std::size_t size) {
+  if (size == 0) return end;
+
+  for (auto it{ranges.begin()}; it != ranges.end(); ++it) {
+    auto& [offset, available]{*it};
+    if (available < size) continue;
+    const auto first{offset};
+    offset += size;
+    available -= size;
+    if (available == 0) ranges.erase(it);
+    return first;
+  }
+
+  const auto first{end};
+  end += size;
+  return first;
+}
+
+void abcg::GeometryPool::FreeList::release(std::size_t offset,
+                                           std::size_t size) {
+  if (size == 0) return;
+
+  auto next{std::lower_bound(ranges.begin(), ranges.end(),
+                             std::pair{offset, std::size_t{}})};
+  auto it{ranges.emplace(next, offset, size)};
+
+  // Merge with the following and the preceding free ranges
+  if (auto following{std::next(it)};
+      following != ranges.end() && it->first + it->second == following->first) {
+    it->second += following->second;
+    ranges.erase(following);
+  }
+  if (it != ranges.begin()) {
+    if (auto preceding{std::prev(it)};
+        preceding->first + preceding->second == it->first) {
+      preceding->second += it->second;
+      it = std::prev(ranges.erase(it));
+    }
+  }
+
+  // A free range at the end shrinks the used part of the buffer
+  if (it->first + it->second == end) {
+    end = it->first;
+    ranges.erase(it);
+  }
+}
+
+// Index of the arena of a vertex layout, created if needed
+std::size_t abcg::GeometryPool::getArena(VertexFormat format,
+                                         GLenum texCoordType) {
+  const auto it{std::find_if(
+      m_arenas.begin(), m_arenas.end(), [&](const Arena& arena) {
+        return arena.format == format && arena.texCoordType == texCoordType;
+      })};
+  if (it != m_arenas.end()) {
+    return static_cast<std::size_t>(std::distance(m_arenas.begin(), it));
+  }
+
+  Arena arena;
+  arena.format = format;
+  arena.texCoordType = texCoordType;
+  arena.vertexSize = Mesh::getVertexSize(format);
+  glGenVertexArrays(1, &arena.VAO);
+  m_arenas.push_back(arena);
+  return m_arenas.size() - 1;
+}
+
+// Grows the buffers of an arena to fit its ranges, copying their contents
+void abcg::GeometryPool::reserve(Arena& arena) {
+  auto grown{false};
+  auto grow{[&grown](GLenum target, GLuint& buffer, std::size_t& capacity,
+                     std::size_t required) {
+    if (required <= capacity) return;
+
+    const auto newCapacity{std::max({required, capacity * 2, m_minBufferSize})};
+    GLuint newBuffer{};
+    glGenBuffers(1, &newBuffer);
+    glBindBuffer(target, newBuffer);
+    glBufferData(target, static_cast<GLsizeiptr>(newCapacity), nullptr,
+                 GL_STATIC_DRAW);
+    if (capacity > 0) {
+      glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+      glCopyBufferSubData(GL_COPY_READ_BUFFER, target, 0, 0,
+                          static_cast<GLsizeiptr>(capacity));
+      glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    }
+    glBindBuffer(target, 0);
+
+    glDeleteBuffers(1, &buffer);
+    buffer = newBuffer;
+    capacity = newCapacity;
+    grown = true;
+  }};
+
+  // No VAO must be bound while the EBO is bound
+  glBindVertexArray(0);
+  grow(GL_ARRAY_BUFFER, arena.VBO, arena.vertexCapacity,
+       arena.vertices.end * arena.vertexSize);
+  grow(GL_ELEMENT_ARRAY_BUFFER, arena.EBO, arena.indexCapacity,
+       arena.indices.end);
+  if (grown) setupVAO(arena);
+}
+
+// Binds the EBO of an arena to its VAO, and the VBO to the attributes of
+// the program of the last setupVAO() call, if any
+void abcg::GeometryPool::setupVAO(const Arena& arena) const {
+  glBindVertexArray(arena.VAO);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, arena.EBO);
+
+  if (m_program != 0) {
+    // Attributes of a previous program may be enabled
+    GLint maxAttributes{};
+    glGetIntegerv(GL_MAX_VERTEX_ATTRIBS, &maxAttributes);
+    for (const auto location : iter::range(maxAttributes)) {
+      glDisableVertexAttribArray(static_cast<GLuint>(location));
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, arena.VBO);
+    Mesh::bindVertexAttributes(m_program, arena.format, arena.texCoordType);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+
+  glBindVertexArray(0);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file abcg_geometrypool.hpp
+ * @brief abcg::GeometryPool header file.
+ *
+ * Declaration of abcg::GeometryPool class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_GEOMETRYPOOL_HPP_
+#define ABCG_GEOMETRYPOOL_HPP_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "abcg_external.hpp"
+#include "abcg_mesh.hpp"
+
+namespace abcg {
+class GeometryPool;
+}  // namespace abcg
+
+/**
+ * @brief abcg::GeometryPool class.
+ *
+ * Vertex and index buffers shared by many instances of abcg::Mesh.
+ *
+ * Meshes with the same vertex layout are stored in the same arena, which
+ * has one VBO, one EBO and one VAO, so drawing them doesn't switch VAOs.
+ * Each mesh is a range of vertices and a range of indices of its arena.
+ * Ranges are allocated first fit and freed ranges are reused, and the
+ * buffers grow by copying when they are full.
+ *
+ * Indices are relative to the first vertex of the mesh and are drawn with
+ * glDrawElementsBaseVertex, so meshes with up to 65535 vertices keep
+ * 16-bit indices. WebGL 2 has no base vertex draws, so there the indices
+ * are made absolute when uploaded and are always 32-bit.
+ *
+ * The pool must outlive the meshes stored in it.
+ */
+class abcg::GeometryPool {
+ public:
+  /**
+   * @brief Ranges of a mesh in the buffers of its arena.
+   */
+  struct Allocation {
+    std::size_t arena{};
+    std::size_t firstVertex{};
+    std::size_t vertexCount{};
+    // In bytes, multiple of 4
+    std::size_t indexOffset{};
+    std::size_t indexBytes{};
+  };
+
+  [[nodiscard]] std::size_t allocate(VertexFormat format, GLenum texCoordType,
+                                     std::size_t vertexCount,
+                                     std::size_t indexBytes);
+  void upload(std::size_t allocation, const void* vertices,
+              const void* indices);
+  void release(std::size_t allocation);
+  void setupVAO(GLuint program);
+  void destroy();
+
+  [[nodiscard]] const Allocation& getAllocation(std::size_t allocation) const {
+    return m_allocations.at(allocation);
+  }
+  [[nodiscard]] GLuint getVAO(std::size_t allocation) const {
+    return m_arenas.at(m_allocations.at(allocation).arena).VAO;
+  }
+  [[nodiscard]] std::size_t getNumArenas() const { return m_arenas.size(); }
+  [[nodiscard]] std::size_t getBufferSize() const;
+
+ private:
+  // First-fit allocator of ranges of a buffer. Free ranges are sorted by
+  // offset and merged with their neighbors
+  struct FreeList {
+    std::vector<std::pair<std::size_t, std::size_t>> ranges;
+    // End of the last allocated range
+    std::size_t end{};
+
+    [[nodiscard]] std::size_t allocate(std::size_t size);
+    void release(std::size_t offset, std::size_t size);
+  };
+
+  struct Arena {
+    VertexFormat format{VertexFormat::Full};
+    GLenum texCoordType{GL_FLOAT};
+    std::size_t vertexSize{};
+    GLuint VBO{};
+    GLuint EBO{};
+    GLuint VAO{};
+    // Sizes of the buffers in bytes
+    std::size_t vertexCapacity{};
+    std::size_t indexCapacity{};
+    // Ranges of vertices and of bytes of indices
+    FreeList vertices;
+    FreeList indices;
+  };
+
+  // Smallest buffers created, in bytes
+  static constexpr std::size_t m_minBufferSize{1024 * 1024};
+
+  std::vector<Arena> m_arenas;
+  std::vector<Allocation> m_allocations;
+  // Allocations that were freed and can be reused
+  std::vector<std::size_t> m_freeAllocations;
+  // Program of the last setupVAO() call, to set up VAOs again after their
+  // buffers grow
+  GLuint m_program{};
+
+  [[nodiscard]] std::size_t getArena(VertexFormat format, GLenum texCoordType);
+  void reserve(Arena& arena);
+  void setupVAO(const Arena& arena) const;
+};
+
+#endif
@@ -0,0 +1,308 @@
+/**
+ * @file abcg_gpuculler.cpp
+ * @brief Definition of abcg::GPUCuller class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_gpuculler.hpp"
+
+#include <algorithm>
+#include <cppitertools/itertools.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+namespace {
+// Number of invocations of a work group of the culling shader
+constexpr GLuint groupSize{64};
+
+// The number of draws can be read from a buffer with ARB_indirect_parameters
+bool hasIndirectParameters() {
+#if defined(__EMSCRIPTEN__)
+  return false;
+#else
+  return GLEW_ARB_indirect_parameters;
+#endif
+}
+}  // namespace
+
+/**
+ * @brief Returns whether objects can be culled and drawn on the GPU.
+ *
+ * Compute shaders are core in OpenGL 4.3, and gl_BaseInstanceARB requires
+ * ARB_shader_draw_parameters.
+ */
+bool abcg::GPUCuller::isSupported() {
+#if defined(__EMSCRIPTEN__)
+  return false;
+#else
+  return GLEW_VERSION_4_3 && GLEW_ARB_shader_draw_parameters;
+#endif
+}
+
+/**
+ * @brief Sets up the compute program that culls the objects.
+ *
+ * @param program Compute program with the firstObject, objectCount,
+ * viewProjMatrix, useDepthPyramid, pyramidViewProjMatrix, pyramidLevels
+ * and depthPyramid uniform variables.
+ */
+void abcg::GPUCuller::initializeGL(GLuint program) {
+  terminateGL();
+
+  m_program = program;
+  m_firstObjectLocation = glGetUniformLocation(program, "firstObject");
+  m_objectCountLocation = glGetUniformLocation(program, "objectCount");
+  m_viewProjMatrixLocation = glGetUniformLocation(program, "viewProjMatrix");
+  m_useDepthPyramidLocation = glGetUniformLocation(program, "useDepthPyramid");
+  m_pyramidViewProjMatrixLocation =
+      glGetUniformLocation(program, "pyramidViewProjMatrix");
+  m_pyramidLevelsLocation = glGetUniformLocation(program, "pyramidLevels");
+  glUseProgram(program);
+  glUniform1i(glGetUniformLocation(program, "depthPyramid"), 0);
+  glUseProgram(0);
+}
+
+/**
+ * @brief Removes the objects and deletes the buffers. The program is not
+ * deleted.
+ */
+void abcg::GPUCuller::terminateGL() {
+  clear();
+  for (auto* buffer :
+       {&m_objectBuffer, &m_drawBuffer, &m_commandBuffer, &m_counterBuffer}) {
+    glDeleteBuffers(1, buffer);
+    *buffer = 0;
+  }
+}
+
+/**
+ * @brief Adds the objects of a mesh that doesn't move.
+ *
+ * Objects are one range of indices per chunk and submesh, with the
+ * bounding box of the chunk, or one per submesh with the bounding box of
+ * the mesh. The mesh must keep its buffers while it is drawn.
+ *
+ * @param mesh Mesh with buffers created.
+ * @param modelMatrix Model matrix of the mesh.
+ * @param lod Level of detail drawn.
+ */
+void abcg::GPUCuller::addMesh(const Mesh& mesh, const glm::mat4& modelMatrix,
+                              int lod) {
+  auto it{std::find_if(m_groups.begin(), m_groups.end(),
+                       [&mesh](const Group& group) {
+                         return group.VAO == mesh.m_VAO &&
+                                group.indexType == mesh.m_indexType;
+                       })};
+  auto& group{it != m_groups.end()
+                  ? *it
+                  : m_groups.emplace_back(Group{.VAO = mesh.m_VAO,
+                                                .indexType = mesh.m_indexType,
+                                                .objects = {},
+                                                .draws = {},
+                                                .firstObject = 0})};
+
+  const glm::mat3 normalMatrix{glm::inverseTranspose(glm::mat3{modelMatrix})};
+  auto addObject{[&](const AABB& bounds, std::size_t firstIndex,
+                     std::size_t indexCount, const Material& material) {
+    const auto box{bounds.transform(modelMatrix)};
+    group.objects.push_back(
+        {.boundsMin = glm::vec4{box.boundsMin, 1.0f},
+         .boundsMax = glm::vec4{box.boundsMax, 1.0f},
+         .count = static_cast<GLuint>(indexCount),
+         .firstIndex = static_cast<GLuint>(mesh.m_firstIndex + firstIndex),
+         .baseVertex = mesh.m_baseVertex,
+         .padding = 0});
+    group.draws.push_back(
+        {.modelMatrix = modelMatrix,
+         .normalMatrix = {glm::vec4{normalMatrix[0], 0.0f},
+                          glm::vec4{normalMatrix[1], 0.0f},
+                          glm::vec4{normalMatrix[2], 0.0f}},
+         .Ka = material.Ka,
+         .Kd = material.Kd,
+         .Ks = material.Ks,
+         .shininess = material.shininess,
+         .diffuseLayer = material.diffuseLayer,
+         .padding = {}});
+    ++m_numObjects;
+  }};
+
+  const AABB meshBounds{.boundsMin = mesh.m_boundsMin,
+                        .boundsMax = mesh.m_boundsMax};
+  auto isBefore{[](const Meshlet& meshlet, std::size_t index) {
+    return meshlet.firstIndex < index;
+  }};
+  for (const auto& submesh : mesh.getLODSubmeshes(lod)) {
+    const auto& material{mesh.m_materials.at(submesh.materialIndex)};
+    if (mesh.m_chunks.empty()) {
+      addObject(meshBounds, submesh.firstIndex, submesh.indexCount, material);
+      continue;
+    }
+
+    // Inside a submesh, the meshlets of a chunk are contiguous, and so are
+    // their indices
+    auto first{std::lower_bound(mesh.m_meshlets.begin(),
+                                mesh.m_meshlets.end(), submesh.firstIndex,
+                                isBefore)};
+    const auto last{std::lower_bound(first, mesh.m_meshlets.end(),
+                                     submesh.firstIndex + submesh.indexCount,
+                                     isBefore)};
+    while (first != last) {
+      const auto chunk{first->chunk};
+      const auto end{std::find_if(first, last, [chunk](const Meshlet& m) {
+        return m.chunk != chunk;
+      })};
+      const auto& back{*std::prev(end)};
+      addObject(mesh.m_chunks.at(chunk), first->firstIndex,
+                back.firstIndex + back.indexCount - first->firstIndex,
+                material);
+      first = end;
+    }
+  }
+  m_dirty = true;
+}
+
+/**
+ * @brief Removes all objects. The buffers are kept for reuse.
+ */
+void abcg::GPUCuller::clear() {
+  m_groups.clear();
+  m_numObjects = 0;
+  m_dirty = true;
+}
+
+/**
+ * @brief Culls the objects and writes the draw commands of the visible
+ * ones.
+ *
+ * Must be called before draw() in each frame. Nothing is read back. The
+ * texture and sampler bound to texture unit 0 are changed.
+ *
+ * @param viewProjMatrix Product of the projection and view matrices.
+ * @param depthPyramid Depth pyramid of the previous frame, or nullptr to
+ * only cull against the view frustum. Ignored if not valid.
+ */
+void abcg::GPUCuller::cull(const glm::mat4& viewProjMatrix,
+                           const DepthPyramid* depthPyramid) {
+  if (m_dirty) upload();
+  if (m_numObjects == 0) return;
+
+#if !defined(__EMSCRIPTEN__)
+  // Counters start at zero, and so do the commands if all of them are
+  // drawn
+  glBindBuffer(GL_COPY_WRITE_BUFFER, m_counterBuffer);
+  glClearBufferData(GL_COPY_WRITE_BUFFER, GL_R32UI, GL_RED_INTEGER,
+                    GL_UNSIGNED_INT, nullptr);
+  if (!hasIndirectParameters()) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_commandBuffer);
+    glClearBufferData(GL_COPY_WRITE_BUFFER, GL_R32UI, GL_RED_INTEGER,
+                      GL_UNSIGNED_INT, nullptr);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+  glUseProgram(m_program);
+  glUniformMatrix4fv(m_viewProjMatrixLocation, 1, GL_FALSE,
+                     &viewProjMatrix[0][0]);
+  const auto useDepthPyramid{depthPyramid != nullptr &&
+                             depthPyramid->isValid()};
+  glUniform1i(m_useDepthPyramidLocation, useDepthPyramid ? 1 : 0);
+  if (useDepthPyramid) {
+    glUniformMatrix4fv(m_pyramidViewProjMatrixLocation, 1, GL_FALSE,
+                       &depthPyramid->getViewProjMatrix()[0][0]);
+    glUniform1i(m_pyramidLevelsLocation, depthPyramid->getNumLevels());
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depthPyramid->getTexture());
+    glBindSampler(0, 0);
+  }
+
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, objectBufferBinding,
+                   m_objectBuffer);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, commandBufferBinding,
+                   m_commandBuffer);
+  for (const auto index : iter::range(m_groups.size())) {
+    const auto& group{m_groups.at(index)};
+    const auto count{static_cast<GLuint>(group.objects.size())};
+    glBindBufferRange(GL_ATOMIC_COUNTER_BUFFER, 0, m_counterBuffer,
+                      static_cast<GLintptr>(index * sizeof(GLuint)),
+                      sizeof(GLuint));
+    glUniform1ui(m_firstObjectLocation,
+                 static_cast<GLuint>(group.firstObject));
+    glUniform1ui(m_objectCountLocation, count);
+    glDispatchCompute((count + groupSize - 1) / groupSize, 1, 1);
+  }
+
+  // The commands and the counters are read by the draw calls
+  glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+  if (useDepthPyramid) glBindTexture(GL_TEXTURE_2D, 0);
+  glUseProgram(0);
+#endif
+}
+
+/**
+ * @brief Draws the objects found visible by the last cull().
+ *
+ * The program used to draw must be in use, with its uniform variables and
+ * textures set. The VAO binding is changed.
+ *
+ * @param mode Primitive type.
+ */
+void abcg::GPUCuller::draw(GLenum mode) const {
+  if (m_numObjects == 0) return;
+
+#if !defined(__EMSCRIPTEN__)
+  const auto countFromBuffer{hasIndirectParameters()};
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, drawBufferBinding, m_drawBuffer);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+  if (countFromBuffer) glBindBuffer(GL_PARAMETER_BUFFER_ARB, m_counterBuffer);
+  for (const auto index : iter::range(m_groups.size())) {
+    const auto& group{m_groups.at(index)};
+    const auto* offset{reinterpret_cast<const void*>(
+        group.firstObject * sizeof(IndirectCommand))};
+    const auto maxCount{static_cast<GLsizei>(group.objects.size())};
+    glBindVertexArray(group.VAO);
+    if (countFromBuffer) {
+      glMultiDrawElementsIndirectCountARB(
+          mode, group.indexType, offset,
+          static_cast<GLintptr>(index * sizeof(GLuint)), maxCount, 0);
+    } else {
+      glMultiDrawElementsIndirect(mode, group.indexType, offset, maxCount, 0);
+    }
+  }
+  glBindVertexArray(0);
+  if (countFromBuffer) glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+#else
+  static_cast<void>(mode);
+#endif
+}
+
+// Writes the objects and draws of all groups, one group after the other,
+// and sizes the command and counter buffers to match
+void abcg::GPUCuller::upload() {
+  m_dirty = false;
+  if (m_numObjects == 0) return;
+
+  std::vector<Object> objects;
+  std::vector<RenderQueue::IndirectDraw> draws;
+  objects.reserve(m_numObjects);
+  draws.reserve(m_numObjects);
+  for (auto& group : m_groups) {
+    group.firstObject = objects.size();
+    objects.insert(objects.end(), group.objects.begin(), group.objects.end());
+    draws.insert(draws.end(), group.draws.begin(), group.draws.end());
+  }
+
+#if !defined(__EMSCRIPTEN__)
+  auto write{[](GLuint& buffer, std::size_t size, const void* data) {
+    if (buffer == 0) glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(size), data,
+                 data != nullptr ? GL_STATIC_DRAW : GL_DYNAMIC_COPY);
+  }};
+  write(m_objectBuffer, objects.size() * sizeof(Object), objects.data());
+  write(m_drawBuffer, draws.size() * sizeof(RenderQueue::IndirectDraw),
+        draws.data());
+  write(m_commandBuffer, objects.size() * sizeof(IndirectCommand), nullptr);
+  write(m_counterBuffer, m_groups.size() * sizeof(GLuint), nullptr);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+#endif
+}
@@ -0,0 +1,135 @@
+/**
+ * @file abcg_gpuculler.hpp
+ * @brief abcg::GPUCuller header file.
+ *
+ * Declaration of abcg::GPUCuller class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_GPUCULLER_HPP_
+#define ABCG_GPUCULLER_HPP_
+
+#include <cstddef>
+#include <glm/mat4x4.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+
+#include "abcg_depthpyramid.hpp"
+#include "abcg_external.hpp"
+#include "abcg_mesh.hpp"
+#include "abcg_renderqueue.hpp"
+
+namespace abcg {
+class GPUCuller;
+}  // namespace abcg
+
+/**
+ * @brief abcg::GPUCuller class.
+ *
+ * Culls static geometry on the GPU and draws what is left without the CPU
+ * ever knowing which objects are visible.
+ *
+ * Meshes added are split in objects, one per chunk and submesh, or per
+ * submesh if the mesh has no chunks, with their bounding boxes in world
+ * space. Every frame, cull() runs a compute shader over the objects that
+ * tests each box against the view frustum and, if given, against the
+ * abcg::DepthPyramid of the previous frame. The draw commands of the
+ * objects that pass are compacted in an indirect buffer through an atomic
+ * counter, and draw() issues a single glMultiDrawElementsIndirect call per
+ * VAO and index type. With ARB_indirect_parameters, the number of draws
+ * is read from the counter. Otherwise, the commands are zeroed before
+ * culling and the unused ones draw nothing.
+ *
+ * The program given to initializeGL() must be a compute shader with work
+ * groups of 64 invocations, reading the objects from the storage buffer
+ * at objectBufferBinding and writing the commands to the one at
+ * commandBufferBinding, with the counter at atomic counter binding 0.
+ *
+ * The program used to draw reads the model matrix and the material of
+ * each object from the storage buffer at drawBufferBinding, laid out as
+ * abcg::RenderQueue::IndirectDraw, at index gl_BaseInstanceARB. The
+ * normal matrix there is in world space, so the view matrix is applied in
+ * the shader.
+ *
+ * Objects tested against the depth pyramid of the previous frame may
+ * appear one frame late when the camera moves quickly. Requires OpenGL
+ * 4.3 and ARB_shader_draw_parameters.
+ */
+class abcg::GPUCuller {
+ public:
+  static constexpr GLuint drawBufferBinding{0};
+  static constexpr GLuint objectBufferBinding{1};
+  static constexpr GLuint commandBufferBinding{2};
+
+  [[nodiscard]] static bool isSupported();
+
+  void initializeGL(GLuint program);
+  void terminateGL();
+
+  void addMesh(const Mesh& mesh, const glm::mat4& modelMatrix, int lod = 0);
+  void clear();
+
+  void cull(const glm::mat4& viewProjMatrix,
+            const DepthPyramid* depthPyramid = nullptr);
+  void draw(GLenum mode = GL_TRIANGLES) const;
+
+  [[nodiscard]] std::size_t getNumObjects() const { return m_numObjects; }
+  /**
+   * @brief Returns the number of glMultiDrawElementsIndirect calls issued
+   * by draw().
+   */
+  [[nodiscard]] std::size_t getNumDrawCalls() const { return m_groups.size(); }
+
+ private:
+  // Layout of the objects in the storage buffer (std430)
+  struct Object {
+    glm::vec4 boundsMin{};
+    glm::vec4 boundsMax{};
+    GLuint count{};
+    GLuint firstIndex{};
+    GLint baseVertex{};
+    GLuint padding{};
+  };
+
+  struct IndirectCommand {
+    GLuint count{};
+    GLuint instanceCount{};
+    GLuint firstIndex{};
+    GLint baseVertex{};
+    GLuint baseInstance{};
+  };
+
+  // Objects drawn by the same call. Their commands and their entries in
+  // the buffers start at firstObject once uploaded
+  struct Group {
+    GLuint VAO{};
+    GLenum indexType{};
+    std::vector<Object> objects;
+    std::vector<RenderQueue::IndirectDraw> draws;
+    std::size_t firstObject{};
+  };
+
+  GLuint m_program{};
+  GLint m_firstObjectLocation{-1};
+  GLint m_objectCountLocation{-1};
+  GLint m_viewProjMatrixLocation{-1};
+  GLint m_useDepthPyramidLocation{-1};
+  GLint m_pyramidViewProjMatrixLocation{-1};
+  GLint m_pyramidLevelsLocation{-1};
+
+  std::vector<Group> m_groups;
+  std::size_t m_numObjects{};
+  // The objects changed since the buffers were last written
+  bool m_dirty{false};
+
+  GLuint m_objectBuffer{};
+  GLuint m_drawBuffer{};
+  GLuint m_commandBuffer{};
+  // One counter per group
+  GLuint m_counterBuffer{};
+
+  void upload();
+};
+
+#endif
@@ -9,9 +9,15 @@
 
 #include <fmt/core.h>
 
+#include <algorithm>
 #include <cppitertools/itertools.hpp>
+#include <cstring>
 #include <fstream>
+#include <future>
+#include <glm/vec2.hpp>
 #include <gsl/gsl>
+#include <memory>
+#include <numeric>
 #include <vector>
 
 #include "SDL_image.h"
@@ -38,6 +44,174 @@ void flipY(gsl::not_null<SDL_Surface*> surface) {
   }
 }
 
+namespace {
+using SurfacePtr = std::unique_ptr<SDL_Surface, decltype(&SDL_FreeSurface)>;
+
+bool hasAlphaChannel(GLenum internalFormat) {
+  switch (internalFormat) {
+    case GL_RGBA:
+    case GL_RGBA8:
+    case GL_SRGB8_ALPHA8:
+#if !defined(__EMSCRIPTEN__)
+    case GL_COMPRESSED_RGBA:
+    case GL_COMPRESSED_SRGB_ALPHA:
+#endif
+      return true;
+    default:
+      return false;
+  }
+}
+
+#if defined(__EMSCRIPTEN__)
+// No worker threads without pthreads: decode lazily on the calling thread
+constexpr auto decodeLaunchPolicy{std::launch::deferred};
+#else
+constexpr auto decodeLaunchPolicy{std::launch::async};
+#endif
+
+// Decodes, converts, resizes and flips an image. Safe to be called from a
+// worker thread as it doesn't touch the OpenGL context. A width or height of
+// 0 keeps the size of the image
+SurfacePtr decodeImage(std::string path, bool withAlpha, int width,
+                       int height) {
+  // Copy file data into buffer
+  std::ifstream input(path, std::ios::binary);
+  if (!input) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to open texture file {}", path))};
+  }
+  std::vector<char> buffer((std::istreambuf_iterator<char>(input)),
+                           std::istreambuf_iterator<char>());
+
+  // Load the bitmap from the buffer
+  SurfacePtr surface{
+      IMG_Load_RW(SDL_RWFromConstMem(buffer.data(),
+                                     static_cast<int>(buffer.size())),
+                  1),
+      SDL_FreeSurface};
+  if (!surface) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        fmt::format("Failed to load texture file {}", path))};
+  }
+
+  // Enforce RGB/RGBA
+  auto pixelFormat{withAlpha ? SDL_PIXELFORMAT_RGBA32 : SDL_PIXELFORMAT_RGB24};
+  SurfacePtr formattedSurface{
+      SDL_ConvertSurfaceFormat(surface.get(), pixelFormat, 0),
+      SDL_FreeSurface};
+  surface.reset();
+  if (!formattedSurface) {
+    throw abcg::Exception{abcg::Exception::SDL(
+        fmt::format("Failed to convert texture file {}", path))};
+  }
+
+  // Resize to the requested resolution
+  if (width > 0 && height > 0 &&
+      (formattedSurface->w != width || formattedSurface->h != height)) {
+    SurfacePtr resizedSurface{
+        SDL_CreateRGBSurfaceWithFormat(0, width, height,
+                                       formattedSurface->format->BitsPerPixel,
+                                       pixelFormat),
+        SDL_FreeSurface};
+    if (!resizedSurface) {
+      throw abcg::Exception{abcg::Exception::SDL(
+          fmt::format("Failed to resize texture file {}", path))};
+    }
+    SDL_SetSurfaceBlendMode(formattedSurface.get(), SDL_BLENDMODE_NONE);
+    SDL_BlitScaled(formattedSurface.get(), nullptr, resizedSurface.get(),
+                   nullptr);
+    formattedSurface = std::move(resizedSurface);
+  }
+
+  // Flip horizontally
+  flipY(formattedSurface.get());
+
+  return formattedSurface;
+}
+
+// Immutable texture storage is core in OpenGL 4.2 and OpenGL ES 3.0
+bool hasTextureStorage() {
+#if defined(__EMSCRIPTEN__)
+  return true;
+#else
+  return GLEW_VERSION_4_2 || GLEW_ARB_texture_storage;
+#endif
+}
+
+// Sized equivalent of an internal format, or 0 if there is none
+GLenum sizedFormat(GLenum internalFormat) {
+  switch (internalFormat) {
+    case GL_RGB:
+      return GL_RGB8;
+    case GL_RGBA:
+      return GL_RGBA8;
+    case GL_RGB8:
+    case GL_RGBA8:
+    case GL_SRGB8:
+    case GL_SRGB8_ALPHA8:
+      return internalFormat;
+    default:
+      return 0;
+  }
+}
+
+GLsizei mipLevelCount(int width, int height) {
+  GLsizei levels{1};
+  for (auto size{std::max(width, height)}; size > 1; size /= 2) ++levels;
+  return levels;
+}
+
+// Allocates the storage of the currently bound GL_TEXTURE_2D or
+// GL_TEXTURE_CUBE_MAP. The internal format must have a sized equivalent.
+// Falls back to mutable storage with the same levels when immutable storage
+// is not available for this context
+void allocateTexture2D(GLenum target, GLsizei levels, GLenum internalFormat,
+                       int width, int height) {
+  if (hasTextureStorage()) {
+    glTexStorage2D(target, levels, sizedFormat(internalFormat), width,
+                   height);
+    return;
+  }
+
+  const GLenum format{hasAlphaChannel(internalFormat) ? GLenum{GL_RGBA}
+                                                      : GLenum{GL_RGB}};
+  const auto numFaces{target == GL_TEXTURE_CUBE_MAP ? 6 : 1};
+  for (auto level : iter::range(levels)) {
+    for (auto face : iter::range(numFaces)) {
+      const auto faceTarget{target == GL_TEXTURE_CUBE_MAP
+                                ? GL_TEXTURE_CUBE_MAP_POSITIVE_X +
+                                      static_cast<GLenum>(face)
+                                : target};
+      glTexImage2D(faceTarget, level, static_cast<GLint>(internalFormat),
+                   std::max(1, width >> level), std::max(1, height >> level),
+                   0, format, GL_UNSIGNED_BYTE, nullptr);
+    }
+  }
+  glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
+
+// Same as allocateTexture2D for the currently bound GL_TEXTURE_2D_ARRAY
+void allocateTextureArray(GLsizei levels, GLenum internalFormat, int width,
+                          int height, int layers) {
+  if (hasTextureStorage()) {
+    glTexStorage3D(GL_TEXTURE_2D_ARRAY, levels, internalFormat, width, height,
+                   layers);
+    return;
+  }
+
+  for (auto level : iter::range(levels)) {
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, level,
+                 static_cast<GLint>(internalFormat),
+                 std::max(1, width >> level), std::max(1, height >> level),
+                 layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+  }
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levels - 1);
+}
+
+// Samplers shared by all textures, created on demand
+std::vector<std::pair<abcg::opengl::SamplerSettings, GLuint>> samplerCache;
+}  // namespace
+
 GLuint abcg::opengl::loadTexture(std::string_view path, bool generateMipmaps) {
   GLuint textureID{};
 
@@ -72,9 +246,16 @@ GLuint abcg::opengl::loadTexture(std::string_view path, bool generateMipmaps) {
     // Generate the texture
     glGenTextures(1, &textureID);
     glBindTexture(GL_TEXTURE_2D, textureID);
-    glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(format),
-                 formattedSurface->w, formattedSurface->h, 0, format,
-                 GL_UNSIGNED_BYTE, formattedSurface->pixels);
+    allocateTexture2D(
+        GL_TEXTURE_2D,
+        generateMipmaps
+            ? mipLevelCount(formattedSurface->w, formattedSurface->h)
+            : 1,
+        format == GL_RGB ? GL_RGB8 : GL_RGBA8, formattedSurface->w,
+        formattedSurface->h);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, formattedSurface->w,
+                    formattedSurface->h, format, GL_UNSIGNED_BYTE,
+                    formattedSurface->pixels);
 
     SDL_FreeSurface(formattedSurface);
 
@@ -106,40 +287,66 @@ GLuint abcg::opengl::loadTexture(std::string_view path, bool generateMipmaps) {
 
 GLuint abcg::opengl::loadCubemap(std::array<std::string_view, 6> paths,
                                  bool generateMipmaps) {
+  return loadCubemap(paths, {.generateMipmaps = generateMipmaps});
+}
+
+GLuint abcg::opengl::loadCubemap(std::array<std::string_view, 6> paths,
+                                 const CubemapSettings& settings) {
+  const auto withAlpha{hasAlphaChannel(settings.internalFormat)};
+  const GLenum format{withAlpha ? GLenum{GL_RGBA} : GLenum{GL_RGB}};
+
+  // Decode all faces concurrently
+  std::array<std::future<SurfacePtr>, 6> faces;
+  for (auto&& [index, path] : iter::enumerate(paths)) {
+    faces.at(index) =
+        std::async(decodeLaunchPolicy, decodeImage, std::string{path},
+                   withAlpha, settings.faceSize, settings.faceSize);
+  }
+
   GLuint textureID{};
   glGenTextures(1, &textureID);
   glBindTexture(GL_TEXTURE_CUBE_MAP, textureID);
 
-  for (auto&& [index, path] : iter::enumerate(paths)) {
-    // Copy file data into buffer
-    std::ifstream input(path.data(), std::ios::binary);
-    if (!input) {
-      throw abcg::Exception{abcg::Exception::Runtime(
-          fmt::format("Failed to open texture file {}", path))};
-    }
-    std::vector<char> buffer((std::istreambuf_iterator<char>(input)),
-                             std::istreambuf_iterator<char>());
+  // Unsized and generic compressed formats have no immutable storage. The
+  // driver picks their actual format when the pixels are specified, so each
+  // face is uploaded directly
+  const auto directUpload{sizedFormat(settings.internalFormat) == 0};
 
-    // Load the bitmap
-    if (SDL_Surface * surface{IMG_Load(path.data())}) {
-      // Enforce RGB
-      SDL_Surface* formattedSurface{
-          SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGB24, 0)};
-      SDL_FreeSurface(surface);
+  // Upload the faces in order as soon as each one is ready. Only this part
+  // is serialized on the thread that owns the OpenGL context
+  try {
+    for (auto&& [index, face] : iter::enumerate(faces)) {
+      auto surface{face.get()};
+      const auto faceTarget{GL_TEXTURE_CUBE_MAP_POSITIVE_X +
+                            static_cast<GLenum>(index)};
 
-      // Flip horizontally
-      flipY(formattedSurface);
+      if (directUpload) {
+        glTexImage2D(faceTarget, 0,
+                     static_cast<GLint>(settings.internalFormat), surface->w,
+                     surface->h, 0, format, GL_UNSIGNED_BYTE,
+                     surface->pixels);
+        continue;
+      }
 
-      // Create texture
-      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + static_cast<GLenum>(index),
-                   0, GL_RGB, formattedSurface->w, formattedSurface->h, 0,
-                   GL_RGB, GL_UNSIGNED_BYTE, formattedSurface->pixels);
-
-      SDL_FreeSurface(formattedSurface);
-    } else {
-      throw abcg::Exception{abcg::Exception::Runtime(
-          fmt::format("Failed to load texture file {}", path))};
+      // All faces have the size of the first one
+      if (index == 0) {
+        allocateTexture2D(GL_TEXTURE_CUBE_MAP,
+                          settings.generateMipmaps
+                              ? mipLevelCount(surface->w, surface->h)
+                              : 1,
+                          settings.internalFormat, surface->w, surface->h);
+      }
+      glTexSubImage2D(faceTarget, 0, 0, 0, surface->w, surface->h, format,
+                      GL_UNSIGNED_BYTE, surface->pixels);
+    }
+  } catch (...) {
+    // Wait for the remaining workers before releasing the texture
+    for (auto& face : faces) {
+      if (face.valid()) face.wait();
     }
+    glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+    glDeleteTextures(1, &textureID);
+    throw;
   }
 
   // Set texture wrapping
@@ -152,7 +359,7 @@ GLuint abcg::opengl::loadCubemap(std::array<std::string_view, 6> paths,
   glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
 
   // Generate the mipmap levels
-  if (generateMipmaps) {
+  if (settings.generateMipmaps) {
     glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
 
     // Override minifying filtering
@@ -160,5 +367,378 @@ GLuint abcg::opengl::loadCubemap(std::array<std::string_view, 6> paths,
                     GL_LINEAR_MIPMAP_LINEAR);
   }
 
+  glBindTexture(GL_TEXTURE_CUBE_MAP, 0);
+
+  return textureID;
+}
+
+/**
+ * @brief Decodes an image and builds its full mipmap chain on the CPU.
+ *
+ * Levels are RGBA8, flipped to match the OpenGL texture coordinate
+ * convention, and computed with a 2x2 box filter down to 1x1. Element 0 is
+ * the base level. This function doesn't use the OpenGL context and can run
+ * on a worker thread.
+ *
+ * @param path Path to the image file.
+ * @param width Width the image is resized to. 0 keeps the size of the
+ * image.
+ * @param height Height the image is resized to. 0 keeps the size of the
+ * image.
+ *
+ * @return Mipmap levels, from largest to smallest.
+ *
+ * @throw abcg::Exception if the image cannot be loaded.
+ */
+std::vector<abcg::opengl::ImageLevel> abcg::opengl::loadMipChain(
+    std::string_view path, int width, int height) {
+  const auto surface{decodeImage(std::string{path}, true, width, height)};
+  const auto bytesPerPixel{4};
+
+  std::vector<ImageLevel> levels;
+  ImageLevel base{.width = surface->w, .height = surface->h};
+  const auto rowSize{static_cast<size_t>(base.width) * bytesPerPixel};
+  base.pixels.resize(rowSize * static_cast<size_t>(base.height));
+  for (auto y : iter::range(base.height)) {
+    std::memcpy(&base.pixels.at(static_cast<size_t>(y) * rowSize),
+                static_cast<const std::byte*>(surface->pixels) +
+                    static_cast<size_t>(y) *
+                        static_cast<size_t>(surface->pitch),
+                rowSize);
+  }
+  levels.push_back(std::move(base));
+
+  while (levels.back().width > 1 || levels.back().height > 1) {
+    const auto& source{levels.back()};
+    ImageLevel level{.width = std::max(1, source.width / 2),
+                     .height = std::max(1, source.height / 2)};
+    level.pixels.resize(static_cast<size_t>(level.width) *
+                        static_cast<size_t>(level.height) * bytesPerPixel);
+
+    auto texel{[&source](int x, int y, int channel) {
+      x = std::min(x, source.width - 1);
+      y = std::min(y, source.height - 1);
+      return std::to_integer<unsigned>(
+          source.pixels[(static_cast<size_t>(y) *
+                             static_cast<size_t>(source.width) +
+                         static_cast<size_t>(x)) *
+                            bytesPerPixel +
+                        static_cast<size_t>(channel)]);
+    }};
+    for (auto y : iter::range(level.height)) {
+      for (auto x : iter::range(level.width)) {
+        for (auto channel : iter::range(bytesPerPixel)) {
+          const auto sum{texel(2 * x, 2 * y, channel) +
+                         texel(2 * x + 1, 2 * y, channel) +
+                         texel(2 * x, 2 * y + 1, channel) +
+                         texel(2 * x + 1, 2 * y + 1, channel)};
+          level.pixels[(static_cast<size_t>(y) *
+                            static_cast<size_t>(level.width) +
+                        static_cast<size_t>(x)) *
+                           bytesPerPixel +
+                       static_cast<size_t>(channel)] =
+              static_cast<std::byte>((sum + 2) / 4);
+        }
+      }
+    }
+    levels.push_back(std::move(level));
+  }
+
+  return levels;
+}
+
+/**
+ * @brief Returns a sampler object shared by all callers with equal settings.
+ *
+ * Samplers are created on first use and cached until destroySamplers() is
+ * called. Binding them with glBindSampler once per texture unit replaces
+ * the per-texture filtering and wrapping state, so quality presets can be
+ * changed without touching the textures.
+ *
+ * @param settings Filtering, wrapping and anisotropy of the sampler.
+ *
+ * @return Sampler name.
+ */
+GLuint abcg::opengl::getSampler(const SamplerSettings& settings) {
+  for (const auto& [cachedSettings, samplerID] : samplerCache) {
+    if (cachedSettings == settings) return samplerID;
+  }
+
+  GLuint samplerID{};
+  glGenSamplers(1, &samplerID);
+  glSamplerParameteri(samplerID, GL_TEXTURE_MIN_FILTER,
+                      static_cast<GLint>(settings.minFilter));
+  glSamplerParameteri(samplerID, GL_TEXTURE_MAG_FILTER,
+                      static_cast<GLint>(settings.magFilter));
+  glSamplerParameteri(samplerID, GL_TEXTURE_WRAP_S,
+                      static_cast<GLint>(settings.wrap));
+  glSamplerParameteri(samplerID, GL_TEXTURE_WRAP_T,
+                      static_cast<GLint>(settings.wrap));
+  glSamplerParameteri(samplerID, GL_TEXTURE_WRAP_R,
+                      static_cast<GLint>(settings.wrap));
+
+#if !defined(__EMSCRIPTEN__)
+  if (settings.maxAnisotropy > 1.0f && (GLEW_ARB_texture_filter_anisotropic ||
+                                        GLEW_EXT_texture_filter_anisotropic)) {
+    GLfloat maxSupported{};
+    glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxSupported);
+    glSamplerParameterf(samplerID, GL_TEXTURE_MAX_ANISOTROPY_EXT,
+                        std::min(settings.maxAnisotropy, maxSupported));
+  }
+#endif
+
+  samplerCache.emplace_back(settings, samplerID);
+
+  return samplerID;
+}
+
+/**
+ * @brief Deletes the samplers created by getSampler().
+ *
+ * Must be called before the OpenGL context is destroyed.
+ */
+void abcg::opengl::destroySamplers() {
+  for (const auto& [settings, samplerID] : samplerCache) {
+    glDeleteSamplers(1, &samplerID);
+  }
+  samplerCache.clear();
+}
+
+/**
+ * @brief Creates a GL_TEXTURE_2D_ARRAY with one layer per image.
+ *
+ * Images are decoded concurrently and resized to layerSize x layerSize RGBA
+ * layers. The layer of each image is its index in paths, so materials can
+ * refer to a layer instead of binding a texture of their own.
+ *
+ * @param paths Paths to the image files.
+ * @param layerSize Width and height of each layer.
+ * @param generateMipmaps Whether to generate the mipmap levels.
+ *
+ * @return Texture name of the array.
+ *
+ * @throw abcg::Exception if an image cannot be loaded.
+ */
+GLuint abcg::opengl::loadTextureArray(const std::vector<std::string>& paths,
+                                      int layerSize, bool generateMipmaps) {
+  if (paths.empty() || layerSize <= 0) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Invalid texture array parameters")};
+  }
+
+  std::vector<std::future<SurfacePtr>> layers;
+  layers.reserve(paths.size());
+  for (const auto& path : paths) {
+    layers.push_back(std::async(decodeLaunchPolicy, decodeImage, path, true,
+                                layerSize, layerSize));
+  }
+
+  GLuint textureID{};
+  glGenTextures(1, &textureID);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, textureID);
+  allocateTextureArray(
+      generateMipmaps ? mipLevelCount(layerSize, layerSize) : 1, GL_RGBA8,
+      layerSize, layerSize, static_cast<int>(paths.size()));
+
+  try {
+    for (auto&& [index, layer] : iter::enumerate(layers)) {
+      auto surface{layer.get()};
+      glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, static_cast<GLint>(index),
+                      layerSize, layerSize, 1, GL_RGBA, GL_UNSIGNED_BYTE,
+                      surface->pixels);
+    }
+  } catch (...) {
+    for (auto& layer : layers) {
+      if (layer.valid()) layer.wait();
+    }
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    glDeleteTextures(1, &textureID);
+    throw;
+  }
+
+  // Set texture filtering
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  // Generate the mipmap levels
+  if (generateMipmaps) {
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+
+    // Override minifying filtering
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+  }
+
+  // Set texture wrapping
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
   return textureID;
 }
+
+/**
+ * @brief Packs a list of images into a single padded texture atlas.
+ *
+ * Images keep their resolution and are packed into rows (shelves) sorted by
+ * height. Each image is surrounded by padding texels that replicate its
+ * borders to reduce bleeding under linear filtering and mipmapping.
+ *
+ * @param paths Paths to the image files.
+ * @param padding Number of border texels around each image.
+ * @param generateMipmaps Whether to generate the mipmap levels.
+ *
+ * @return Atlas texture and the UV remap table, in the same order as paths.
+ *
+ * @throw abcg::Exception if an image cannot be loaded or the atlas doesn't
+ * fit in GL_MAX_TEXTURE_SIZE.
+ */
+abcg::opengl::TextureAtlas abcg::opengl::loadTextureAtlas(
+    const std::vector<std::string>& paths, int padding, bool generateMipmaps) {
+  if (paths.empty() || padding < 0) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Invalid texture atlas parameters")};
+  }
+
+  std::vector<std::future<SurfacePtr>> pendingImages;
+  pendingImages.reserve(paths.size());
+  for (const auto& path : paths) {
+    pendingImages.push_back(
+        std::async(decodeLaunchPolicy, decodeImage, path, true, 0, 0));
+  }
+  std::vector<SurfacePtr> images;
+  images.reserve(paths.size());
+  for (auto& image : pendingImages) {
+    images.push_back(image.get());
+  }
+
+  // Place tallest images first
+  std::vector<size_t> order(images.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&images](size_t lhs, size_t rhs) {
+    return images[lhs]->h > images[rhs]->h;
+  });
+
+  GLint maxTextureSize{};
+  glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+
+  // Start from the smallest power of two that can hold the total area and
+  // grow until every image fits
+  size_t area{};
+  int widest{};
+  for (const auto& image : images) {
+    area += static_cast<size_t>(image->w + 2 * padding) *
+            static_cast<size_t>(image->h + 2 * padding);
+    widest = std::max(widest, image->w + 2 * padding);
+  }
+  int atlasWidth{1};
+  while (static_cast<size_t>(atlasWidth) * static_cast<size_t>(atlasWidth) <
+             area ||
+         atlasWidth < widest) {
+    atlasWidth *= 2;
+  }
+  int atlasHeight{atlasWidth};
+
+  std::vector<glm::ivec2> offsets(images.size());
+  auto pack{[&]() {
+    int x{};
+    int y{};
+    int shelfHeight{};
+    for (auto index : order) {
+      const auto cellWidth{images[index]->w + 2 * padding};
+      const auto cellHeight{images[index]->h + 2 * padding};
+      if (x + cellWidth > atlasWidth) {
+        x = 0;
+        y += shelfHeight;
+        shelfHeight = 0;
+      }
+      if (y + cellHeight > atlasHeight) return false;
+      offsets[index] = {x + padding, y + padding};
+      x += cellWidth;
+      shelfHeight = std::max(shelfHeight, cellHeight);
+    }
+    return true;
+  }};
+  // The size is checked before the first attempt too, as a single image
+  // may already be larger than the limit
+  while (true) {
+    if (atlasWidth > maxTextureSize || atlasHeight > maxTextureSize) {
+      throw abcg::Exception{abcg::Exception::Runtime(fmt::format(
+          "Texture atlas exceeds the maximum texture size of {}",
+          maxTextureSize))};
+    }
+    if (pack()) break;
+    if (atlasHeight < atlasWidth) {
+      atlasHeight *= 2;
+    } else {
+      atlasWidth *= 2;
+    }
+  }
+
+  // Copy the images, replicating their borders into the padding
+  const auto bytesPerPixel{4};
+  std::vector<std::byte> atlasPixels(static_cast<size_t>(atlasWidth) *
+                                     static_cast<size_t>(atlasHeight) *
+                                     bytesPerPixel);
+  TextureAtlas atlas{.width = atlasWidth, .height = atlasHeight};
+  atlas.uvTransforms.resize(images.size());
+  for (auto&& [index, image] : iter::enumerate(images)) {
+    const auto& offset{offsets.at(index)};
+    const auto* source{static_cast<const std::byte*>(image->pixels)};
+    for (auto y : iter::range(-padding, image->h + padding)) {
+      const auto sourceY{std::clamp(y, 0, image->h - 1)};
+      for (auto x : iter::range(-padding, image->w + padding)) {
+        const auto sourceX{std::clamp(x, 0, image->w - 1)};
+        std::memcpy(
+            &atlasPixels.at(
+                (static_cast<size_t>(offset.y + y) *
+                     static_cast<size_t>(atlasWidth) +
+                 static_cast<size_t>(offset.x + x)) *
+                bytesPerPixel),
+            source +
+                static_cast<size_t>(sourceY) *
+                    static_cast<size_t>(image->pitch) +
+                static_cast<size_t>(sourceX) * bytesPerPixel,
+            bytesPerPixel);
+      }
+    }
+
+    atlas.uvTransforms.at(index) = {
+        static_cast<float>(image->w) / static_cast<float>(atlasWidth),
+        static_cast<float>(image->h) / static_cast<float>(atlasHeight),
+        static_cast<float>(offset.x) / static_cast<float>(atlasWidth),
+        static_cast<float>(offset.y) / static_cast<float>(atlasHeight)};
+  }
+  images.clear();
+
+  glGenTextures(1, &atlas.textureID);
+  glBindTexture(GL_TEXTURE_2D, atlas.textureID);
+  allocateTexture2D(GL_TEXTURE_2D,
+                    generateMipmaps ? mipLevelCount(atlasWidth, atlasHeight)
+                                    : 1,
+                    GL_RGBA8, atlasWidth, atlasHeight);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, atlasWidth, atlasHeight, GL_RGBA,
+                  GL_UNSIGNED_BYTE, atlasPixels.data());
+
+  // Set texture filtering
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  // Generate the mipmap levels
+  if (generateMipmaps) {
+    glGenerateMipmap(GL_TEXTURE_2D);
+
+    // Override minifying filtering
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                    GL_LINEAR_MIPMAP_LINEAR);
+  }
+
+  // Set texture wrapping
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  return atlas;
+}
@@ -10,13 +10,92 @@
 
 #include <abcg_external.hpp>
 #include <array>
+#include <cstddef>
+#include <glm/vec4.hpp>
+#include <string>
 #include <string_view>
+#include <vector>
+
+namespace abcg::opengl {
+struct CubemapSettings;
+struct ImageLevel;
+struct SamplerSettings;
+struct TextureAtlas;
+}  // namespace abcg::opengl
+
+/**
+ * @brief Settings used for creating a cube map texture.
+ *
+ */
+struct abcg::opengl::CubemapSettings {
+  // Width and height of each face. If 0, the size of the images is used
+  int faceSize{0};
+  bool generateMipmaps{true};
+  // Internal format. E.g., GL_RGB8, GL_SRGB8, GL_RGBA8, GL_SRGB8_ALPHA8 or,
+  // on desktop OpenGL, a generic compressed format such as GL_COMPRESSED_RGB
+  // or GL_COMPRESSED_SRGB
+  GLenum internalFormat{GL_RGB};
+};
+
+/**
+ * @brief CPU copy of one mipmap level of an RGBA8 image.
+ */
+struct abcg::opengl::ImageLevel {
+  int width{};
+  int height{};
+  std::vector<std::byte> pixels{};
+};
+
+/**
+ * @brief Settings of a shared sampler object.
+ *
+ * A sampler bound to a texture unit overrides the filtering and wrapping
+ * parameters of the textures bound to the same unit.
+ */
+struct abcg::opengl::SamplerSettings {
+  GLenum minFilter{GL_LINEAR_MIPMAP_LINEAR};
+  GLenum magFilter{GL_LINEAR};
+  GLenum wrap{GL_REPEAT};
+  // Values above 1 enable anisotropic filtering, clamped to the maximum
+  // supported. Ignored if the extension is not available
+  float maxAnisotropy{1.0f};
+
+  bool operator==(const SamplerSettings&) const = default;
+};
+
+/**
+ * @brief Texture atlas built from a list of images.
+ *
+ * Each image is placed in its own padded region of a single GL_TEXTURE_2D.
+ * uvTransforms[i] maps the texture coordinates of the i-th image to atlas
+ * coordinates as uv * xy + zw. Texture coordinates must be in [0, 1] since
+ * repeat wrapping is not available inside an atlas.
+ */
+struct abcg::opengl::TextureAtlas {
+  GLuint textureID{};
+  int width{};
+  int height{};
+  std::vector<glm::vec4> uvTransforms{};
+};
 
 namespace abcg::opengl {
 [[nodiscard]] GLuint loadTexture(std::string_view path,
                                  bool generateMipmaps = true);
 [[nodiscard]] GLuint loadCubemap(std::array<std::string_view, 6> paths,
                                  bool generateMipmaps = true);
+[[nodiscard]] GLuint loadCubemap(std::array<std::string_view, 6> paths,
+                                 const CubemapSettings& settings);
+[[nodiscard]] std::vector<ImageLevel> loadMipChain(std::string_view path,
+                                                  int width = 0,
+                                                  int height = 0);
+[[nodiscard]] GLuint getSampler(const SamplerSettings& settings);
+void destroySamplers();
+[[nodiscard]] GLuint loadTextureArray(const std::vector<std::string>& paths,
+                                      int layerSize,
+                                      bool generateMipmaps = true);
+[[nodiscard]] TextureAtlas loadTextureAtlas(
+    const std::vector<std::string>& paths, int padding = 4,
+    bool generateMipmaps = true);
 }  // namespace abcg::opengl
 
 #endif
\ No newline at end of file
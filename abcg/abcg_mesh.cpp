@@ -0,0 +1,2003 @@
+/**
+ * @file abcg_mesh.cpp
+ * @brief Definition of abcg::Mesh class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_mesh.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cppitertools/itertools.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <glm/gtc/packing.hpp>
+#include <glm/matrix.hpp>
+#include <glm/packing.hpp>
+#include <gsl/gsl>
+#include <numeric>
+#include <thread>
+#include <utility>
+
+#include "abcg_exception.hpp"
+#include "abcg_frustum.hpp"
+#include "abcg_geometrypool.hpp"
+#include "abcg_meshlet.hpp"
+#include "abcg_meshoptimizer.hpp"
+#include "abcg_meshsimplifier.hpp"
+#include "abcg_objloader.hpp"
+#include "abcg_renderqueue.hpp"
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+#define ABCG_MESH_USE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define ABCG_MESH_USE_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace {
+#if defined(__EMSCRIPTEN__)
+// No worker threads without pthreads: run the tasks in sequence
+constexpr auto parallelLaunchPolicy{std::launch::deferred};
+#else
+constexpr auto parallelLaunchPolicy{std::launch::async};
+#endif
+
+// Increment when the layout of the cache file or the way the cached data
+// is computed changes
+constexpr std::uint32_t cacheVersion{6};
+constexpr std::array<char, 4> cacheMagic{'A', 'B', 'C', 'M'};
+
+struct CacheHeader {
+  std::array<char, 4> magic{cacheMagic};
+  std::uint32_t version{cacheVersion};
+  std::uint32_t vertexSize{sizeof(abcg::Vertex)};
+  std::uint32_t hasNormals{};
+  std::uint32_t hasTexCoords{};
+  // Whether the mesh was processed by the callback given to loadObj()
+  std::uint32_t processed{};
+  // Identification of the source OBJ file
+  std::uint64_t sourceSize{};
+  std::int64_t sourceTime{};
+  std::uint64_t vertexCount{};
+  std::uint64_t indexCount{};
+  std::uint64_t submeshCount{};
+  std::uint64_t materialCount{};
+  std::uint64_t materialFileCount{};
+  std::uint64_t levelCount{};
+  std::uint64_t meshletCount{};
+  std::uint64_t chunkCount{};
+  glm::vec3 boundsMin{};
+  glm::vec3 boundsMax{};
+};
+
+// Identification of an MTL file referenced by the OBJ file, followed by
+// its name relative to the directory of the OBJ file. Files not found
+// when the OBJ file was parsed are recorded too, so that creating them
+// also invalidates the cache
+struct CacheMaterialFile {
+  std::uint64_t size{};
+  std::int64_t time{};
+  std::uint32_t found{};
+  std::uint32_t nameSize{};
+};
+
+struct CacheSubmesh {
+  std::uint64_t firstIndex{};
+  std::uint64_t indexCount{};
+  std::uint64_t materialIndex{};
+};
+
+// Followed by the ranges of the level, one CacheSubmesh per submesh of the
+// full mesh
+struct CacheLevel {
+  float error{};
+  std::uint32_t padding{};
+};
+
+struct CacheMeshlet {
+  std::uint64_t firstIndex{};
+  std::uint64_t indexCount{};
+  std::uint64_t chunk{};
+  glm::vec3 center{};
+  float radius{};
+  glm::vec3 coneAxis{};
+  float coneCutoff{};
+};
+
+struct CacheChunk {
+  glm::vec3 boundsMin{};
+  glm::vec3 boundsMax{};
+};
+
+// Followed by the texture paths, relative to the directory of the OBJ file
+struct CacheMaterial {
+  glm::vec4 Ka{};
+  glm::vec4 Kd{};
+  glm::vec4 Ks{};
+  float shininess{};
+  std::uint32_t diffuseTexturePathSize{};
+  std::uint32_t normalTexturePathSize{};
+};
+
+// Read-only view of a whole file. The file is memory-mapped on POSIX
+// systems and read into memory elsewhere
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path) {
+#if defined(ABCG_MESH_USE_MMAP)
+    const auto fd{open(path.c_str(), O_RDONLY)};
+    if (fd < 0) return;
+    struct stat status {};
+    if (fstat(fd, &status) == 0 && status.st_size > 0) {
+      const auto size{static_cast<std::size_t>(status.st_size)};
+      if (auto* mapping{mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)};
+          mapping != MAP_FAILED) {
+        m_data = {static_cast<const std::byte*>(mapping), size};
+      }
+    }
+    close(fd);
+#else
+    std::ifstream input(path, std::ios::binary);
+    if (!input) return;
+    m_buffer.assign(std::istreambuf_iterator<char>(input),
+                    std::istreambuf_iterator<char>());
+    m_data = {reinterpret_cast<const std::byte*>(m_buffer.data()),
+              m_buffer.size()};
+#endif
+  }
+
+  ~MappedFile() {
+#if defined(ABCG_MESH_USE_MMAP)
+    if (!m_data.empty()) {
+      munmap(const_cast<std::byte*>(m_data.data()), m_data.size());
+    }
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  [[nodiscard]] gsl::span<const std::byte> getData() const { return m_data; }
+
+ private:
+  gsl::span<const std::byte> m_data;
+#if !defined(ABCG_MESH_USE_MMAP)
+  std::vector<char> m_buffer;
+#endif
+};
+
+// Sequential reader with bounds checking over a byte range
+class BlobReader {
+ public:
+  explicit BlobReader(gsl::span<const std::byte> data) : m_data{data} {}
+
+  // Number of whole values of type T left to read
+  template <typename T>
+  [[nodiscard]] std::size_t available() const {
+    return (m_data.size() - m_offset) / sizeof(T);
+  }
+
+  template <typename T>
+  [[nodiscard]] bool read(T* values, std::size_t count) {
+    if (count > available<T>()) return false;
+    std::memcpy(values, m_data.data() + m_offset, count * sizeof(T));
+    m_offset += count * sizeof(T);
+    return true;
+  }
+
+  template <typename T>
+  [[nodiscard]] bool read(T& value) {
+    return read(&value, 1);
+  }
+
+  // Counts read from the file are checked against its size before
+  // anything is allocated, so that a corrupt count fails instead of
+  // throwing std::bad_alloc
+  template <typename T>
+  [[nodiscard]] bool read(std::vector<T>& values, std::uint64_t count) {
+    if (count > available<T>()) return false;
+    values.resize(gsl::narrow_cast<std::size_t>(count));
+    return read(values.data(), values.size());
+  }
+
+  [[nodiscard]] bool read(std::string& value, std::uint64_t size) {
+    if (size > available<char>()) return false;
+    value.resize(gsl::narrow_cast<std::size_t>(size));
+    return read(value.data(), value.size());
+  }
+
+ private:
+  gsl::span<const std::byte> m_data;
+  std::size_t m_offset{};
+};
+
+// Deduplicates vertices that are equal in all attributes. Attributes are
+// compared after quantization, so that the hash and the comparison agree.
+// Uses a flat table with linear probing sized for the worst case of one
+// vertex per corner, so it never grows
+class VertexWelder {
+ public:
+  explicit VertexWelder(std::size_t maxVertices)
+      : m_slots(std::bit_ceil(std::max<std::size_t>(2 * maxVertices, 16)),
+                emptySlot) {
+    m_keys.reserve(maxVertices);
+  }
+
+  // Returns the index of the vertex, appending it to vertices if new
+  GLuint weld(const abcg::Vertex& vertex, std::vector<abcg::Vertex>& vertices) {
+    const auto key{makeKey(vertex)};
+    const auto mask{m_slots.size() - 1};
+    for (auto slot{hashKey(key) & mask};; slot = (slot + 1) & mask) {
+      auto& index{m_slots[slot]};
+      if (index == emptySlot) {
+        index = static_cast<GLuint>(vertices.size());
+        m_keys.push_back(key);
+        vertices.push_back(vertex);
+        return index;
+      }
+      if (m_keys[index] == key) return index;
+    }
+  }
+
+ private:
+  using Key = std::array<std::uint32_t, 8>;
+  static constexpr GLuint emptySlot{~GLuint{}};
+
+  std::vector<GLuint> m_slots;
+  std::vector<Key> m_keys;
+
+  // Rounds off the 4 least significant bits of the mantissa. -0 becomes 0
+  static std::uint32_t quantize(float value) {
+    if (value == 0.0f) return 0;
+    return (std::bit_cast<std::uint32_t>(value) + 0x8U) & ~0xFU;
+  }
+
+  static Key makeKey(const abcg::Vertex& vertex) {
+    return {quantize(vertex.position.x), quantize(vertex.position.y),
+            quantize(vertex.position.z), quantize(vertex.normal.x),
+            quantize(vertex.normal.y),   quantize(vertex.normal.z),
+            quantize(vertex.texCoord.x), quantize(vertex.texCoord.y)};
+  }
+
+  static std::size_t hashKey(const Key& key) {
+    std::uint64_t hash{0xcbf29ce484222325ULL};
+    for (const auto word : key) {
+      hash = (hash ^ word) * 0x100000001b3ULL;
+    }
+    return gsl::narrow_cast<std::size_t>(hash ^ (hash >> 32));
+  }
+};
+
+// Vertex of VertexFormat::Compact
+struct CompactVertex {
+  // Half floats. The last one is padding
+  std::array<std::uint16_t, 4> position{};
+  // Signed normalized 10-bit x, y, z and 2-bit w
+  std::uint32_t normal{};
+  std::uint32_t tangent{};
+  // Normalized unsigned shorts or half floats
+  std::array<std::uint16_t, 2> texCoord{};
+};
+static_assert(sizeof(CompactVertex) == 20);
+
+std::vector<CompactVertex> packVertices(
+    const std::vector<abcg::Vertex>& vertices, bool normalizedTexCoords) {
+  std::vector<CompactVertex> packed;
+  packed.reserve(vertices.size());
+  for (const auto& vertex : vertices) {
+    CompactVertex compact;
+    const auto position{glm::packHalf4x16(glm::vec4{vertex.position, 1.0f})};
+    std::memcpy(compact.position.data(), &position, sizeof(position));
+    compact.normal = glm::packSnorm3x10_1x2(glm::vec4{vertex.normal, 0.0f});
+    compact.tangent = glm::packSnorm3x10_1x2(vertex.tangent);
+    const auto texCoord{normalizedTexCoords
+                            ? glm::packUnorm2x16(vertex.texCoord)
+                            : glm::packHalf2x16(vertex.texCoord)};
+    std::memcpy(compact.texCoord.data(), &texCoord, sizeof(texCoord));
+    packed.push_back(compact);
+  }
+  return packed;
+}
+
+// Floats between consecutive vertices in the vertex array
+constexpr std::size_t vertexStride{sizeof(abcg::Vertex) / sizeof(float)};
+
+// Per-thread sums of vectors of each vertex, stored as vec4. Each thread
+// adds the contribution of its own range of triangles to its own copy, so
+// no synchronization is needed
+class PartialSums {
+ public:
+  PartialSums(std::size_t numThreads, std::size_t numVertices,
+              std::size_t vectorsPerVertex)
+      : m_sums(numThreads * numVertices * vectorsPerVertex * 4, 0.0f),
+        m_stride{numVertices * vectorsPerVertex * 4},
+        m_numThreads{numThreads}, m_vectorsPerVertex{vectorsPerVertex} {}
+
+  [[nodiscard]] float* get(std::size_t thread, std::size_t vector) {
+    return m_sums.data() + thread * m_stride + vector * 4;
+  }
+  [[nodiscard]] std::size_t getVertexStride() const {
+    return m_vectorsPerVertex * 4;
+  }
+
+  // Sum of a vector of a vertex over all threads
+  [[nodiscard]] glm::vec3 reduce(std::size_t vertex,
+                                 std::size_t vector) const {
+    glm::vec3 sum{};
+    auto offset{(vertex * m_vectorsPerVertex + vector) * 4};
+    for ([[maybe_unused]] const auto thread : iter::range(m_numThreads)) {
+      sum += glm::vec3{m_sums[offset], m_sums[offset + 1],
+                       m_sums[offset + 2]};
+      offset += m_stride;
+    }
+    return sum;
+  }
+
+ private:
+  std::vector<float> m_sums;
+  std::size_t m_stride{};
+  std::size_t m_numThreads{};
+  std::size_t m_vectorsPerVertex{};
+};
+
+// Smaller meshes are not worth splitting across threads
+constexpr std::size_t minTrianglesPerThread{32768};
+
+std::size_t getNumThreads(std::size_t numTriangles) {
+  const auto numThreads{std::max(1U, std::thread::hardware_concurrency())};
+  return std::clamp<std::size_t>(numTriangles / minTrianglesPerThread, 1,
+                                 numThreads);
+}
+
+// Calls task with each thread index in [0, numThreads). The first index
+// runs on the calling thread
+void runConcurrently(std::size_t numThreads,
+                     const std::function<void(std::size_t)>& task) {
+  std::vector<std::future<void>> futures;
+  futures.reserve(numThreads);
+  for (const auto thread : iter::range<std::size_t>(1, numThreads)) {
+    futures.push_back(std::async(parallelLaunchPolicy, task, thread));
+  }
+  task(0);
+  for (auto& future : futures) future.get();
+}
+
+// Range [first, last) of the part of count items processed by a thread
+std::pair<std::size_t, std::size_t> getThreadRange(std::size_t count,
+                                                   std::size_t thread,
+                                                   std::size_t numThreads) {
+  return {count * thread / numThreads, count * (thread + 1) / numThreads};
+}
+
+// Where the vectors of a triangle are added to: a vec4 of each vertex,
+// with the given number of floats between vertices
+struct Accumulator {
+  float* sums{};
+  std::size_t stride{};
+};
+
+#if defined(ABCG_MESH_USE_SSE)
+// Attribute of a corner of four consecutive triangles, one triangle per
+// lane. Reads four floats from each vertex
+void gather(const float* attribute, const GLuint* corners, std::size_t corner,
+            __m128& x, __m128& y, __m128& z, __m128& w) {
+  auto r0{_mm_loadu_ps(attribute + corners[corner] * vertexStride)};
+  auto r1{_mm_loadu_ps(attribute + corners[corner + 3] * vertexStride)};
+  auto r2{_mm_loadu_ps(attribute + corners[corner + 6] * vertexStride)};
+  auto r3{_mm_loadu_ps(attribute + corners[corner + 9] * vertexStride)};
+  _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+  x = r0;
+  y = r1;
+  z = r2;
+  w = r3;
+}
+
+// Adds the vectors (x, y, z) of four consecutive triangles, one triangle
+// per lane, to their vertices
+void scatterAdd(const Accumulator& accumulator, const GLuint* corners,
+                __m128 x, __m128 y, __m128 z) {
+  auto w{_mm_setzero_ps()};
+  _MM_TRANSPOSE4_PS(x, y, z, w);
+  auto add{[&](std::size_t lane, __m128 vector) {
+    for (const auto corner : iter::range<std::size_t>(3)) {
+      auto* sum{accumulator.sums +
+                corners[lane * 3 + corner] * accumulator.stride};
+      _mm_storeu_ps(sum, _mm_add_ps(_mm_loadu_ps(sum), vector));
+    }
+  }};
+  add(0, x);
+  add(1, y);
+  add(2, z);
+  add(3, w);
+}
+#endif
+
+// Adds a vector of a triangle to its vertices
+void scatterAdd(const Accumulator& accumulator, const GLuint* corners,
+                const glm::vec3& vector) {
+  for (const auto corner : iter::range<std::size_t>(3)) {
+    auto* sum{accumulator.sums + corners[corner] * accumulator.stride};
+    sum[0] += vector.x;
+    sum[1] += vector.y;
+    sum[2] += vector.z;
+  }
+}
+
+// Adds the face normals of a range of triangles to the vertices. The
+// normals are not normalized, so they are weighted by the face areas
+void accumulateNormals(const GLuint* indices, std::size_t first,
+                       std::size_t last,
+                       const std::vector<abcg::Vertex>& vertices,
+                       const Accumulator& normals) {
+  auto triangle{first};
+#if defined(ABCG_MESH_USE_SSE)
+  const auto* positions{&vertices.front().position.x};
+  // Four triangles at a time
+  for (; triangle + 4 <= last; triangle += 4) {
+    const auto* corners{indices + triangle * 3};
+    __m128 ax;
+    __m128 ay;
+    __m128 az;
+    __m128 bx;
+    __m128 by;
+    __m128 bz;
+    __m128 cx;
+    __m128 cy;
+    __m128 cz;
+    __m128 unused;
+    gather(positions, corners, 0, ax, ay, az, unused);
+    gather(positions, corners, 1, bx, by, bz, unused);
+    gather(positions, corners, 2, cx, cy, cz, unused);
+
+    const auto e1x{_mm_sub_ps(bx, ax)};
+    const auto e1y{_mm_sub_ps(by, ay)};
+    const auto e1z{_mm_sub_ps(bz, az)};
+    const auto e2x{_mm_sub_ps(cx, bx)};
+    const auto e2y{_mm_sub_ps(cy, by)};
+    const auto e2z{_mm_sub_ps(cz, bz)};
+
+    // Cross product
+    scatterAdd(normals, corners,
+               _mm_sub_ps(_mm_mul_ps(e1y, e2z), _mm_mul_ps(e1z, e2y)),
+               _mm_sub_ps(_mm_mul_ps(e1z, e2x), _mm_mul_ps(e1x, e2z)),
+               _mm_sub_ps(_mm_mul_ps(e1x, e2y), _mm_mul_ps(e1y, e2x)));
+  }
+#endif
+  for (; triangle < last; ++triangle) {
+    const auto* corners{indices + triangle * 3};
+    const auto& a{vertices[corners[0]].position};
+    const auto& b{vertices[corners[1]].position};
+    const auto& c{vertices[corners[2]].position};
+    scatterAdd(normals, corners, glm::cross(b - a, c - b));
+  }
+}
+
+// Adds the face tangents and bitangents of a range of triangles to the
+// vertices
+void accumulateTangents(const GLuint* indices, std::size_t first,
+                        std::size_t last,
+                        const std::vector<abcg::Vertex>& vertices,
+                        const Accumulator& tangents,
+                        const Accumulator& bitangents) {
+  auto triangle{first};
+#if defined(ABCG_MESH_USE_SSE)
+  const auto* positions{&vertices.front().position.x};
+  const auto* texCoords{&vertices.front().texCoord.s};
+  // Four triangles at a time
+  for (; triangle + 4 <= last; triangle += 4) {
+    const auto* corners{indices + triangle * 3};
+    __m128 ax;
+    __m128 ay;
+    __m128 az;
+    __m128 bx;
+    __m128 by;
+    __m128 bz;
+    __m128 cx;
+    __m128 cy;
+    __m128 cz;
+    __m128 as;
+    __m128 at;
+    __m128 bs;
+    __m128 bt;
+    __m128 cs;
+    __m128 ct;
+    __m128 unused;
+    gather(positions, corners, 0, ax, ay, az, unused);
+    gather(positions, corners, 1, bx, by, bz, unused);
+    gather(positions, corners, 2, cx, cy, cz, unused);
+    gather(texCoords, corners, 0, as, at, unused, unused);
+    gather(texCoords, corners, 1, bs, bt, unused, unused);
+    gather(texCoords, corners, 2, cs, ct, unused, unused);
+
+    const auto e1x{_mm_sub_ps(bx, ax)};
+    const auto e1y{_mm_sub_ps(by, ay)};
+    const auto e1z{_mm_sub_ps(bz, az)};
+    const auto e2x{_mm_sub_ps(cx, ax)};
+    const auto e2y{_mm_sub_ps(cy, ay)};
+    const auto e2z{_mm_sub_ps(cz, az)};
+    const auto d1s{_mm_sub_ps(bs, as)};
+    const auto d1t{_mm_sub_ps(bt, at)};
+    const auto d2s{_mm_sub_ps(cs, as)};
+    const auto d2t{_mm_sub_ps(ct, at)};
+
+    const auto r{_mm_div_ps(
+        _mm_set1_ps(1.0f),
+        _mm_sub_ps(_mm_mul_ps(d1s, d2t), _mm_mul_ps(d2s, d1t)))};
+
+    // tangent = (e1 * d2t - e2 * d1t) * r
+    // bitangent = (e2 * d1s - e1 * d2s) * r
+    auto combine{[r](__m128 u, __m128 uWeight, __m128 v, __m128 vWeight) {
+      return _mm_mul_ps(
+          _mm_sub_ps(_mm_mul_ps(u, uWeight), _mm_mul_ps(v, vWeight)), r);
+    }};
+    scatterAdd(tangents, corners, combine(e1x, d2t, e2x, d1t),
+               combine(e1y, d2t, e2y, d1t), combine(e1z, d2t, e2z, d1t));
+    scatterAdd(bitangents, corners, combine(e2x, d1s, e1x, d2s),
+               combine(e2y, d1s, e1y, d2s), combine(e2z, d1s, e1z, d2s));
+  }
+#endif
+  for (; triangle < last; ++triangle) {
+    const auto* corners{indices + triangle * 3};
+    const auto& a{vertices[corners[0]]};
+    const auto& b{vertices[corners[1]]};
+    const auto& c{vertices[corners[2]]};
+    const auto e1{b.position - a.position};
+    const auto e2{c.position - a.position};
+    const auto d1{b.texCoord - a.texCoord};
+    const auto d2{c.texCoord - a.texCoord};
+    const auto r{1.0f / (d1.s * d2.t - d2.s * d1.t)};
+    scatterAdd(tangents, corners, (e1 * d2.t - e2 * d1.t) * r);
+    scatterAdd(bitangents, corners, (e2 * d1.s - e1 * d2.s) * r);
+  }
+}
+
+// Size and modification time of the source file. False if unavailable
+bool getSourceIdentity(std::string_view path, std::uint64_t& size,
+                       std::int64_t& time) {
+  std::error_code error;
+  size = std::filesystem::file_size(path, error);
+  if (error) return false;
+  // The clock representation is wider than 64 bits on some platforms
+  time = gsl::narrow_cast<std::int64_t>(
+      std::filesystem::last_write_time(path, error)
+          .time_since_epoch()
+          .count());
+  return !error;
+}
+}  // namespace
+
+/**
+ * @brief Loads a triangle mesh from a Wavefront OBJ file.
+ *
+ * Vertices are deduplicated and faces are grouped by material into
+ * submeshes. Materials are read from the MTL files found in the directory of
+ * the OBJ file. Vertex normals are computed if the file doesn't have them,
+ * and tangents are computed if the file has texture coordinates.
+ *
+ * If useCache is true, the result is read from the binary cache file when
+ * it is up to date, and the cache file is written otherwise. Failing to
+ * write the cache is not an error.
+ *
+ * If process is given, it is called with the parsed mesh before the cache
+ * file is written, and what it computes, including levels of detail,
+ * meshlets and chunks, is cached as well. It is not called when the cache
+ * is read. The cache file doesn't identify the processing steps, so it must
+ * be deleted when they change.
+ *
+ * @param path Path to the OBJ file.
+ * @param useCache Whether to use the binary cache file.
+ * @param process Processing steps applied to the parsed mesh, such as
+ * standardize(), optimize(), generateLODs() and buildMeshlets(). They must
+ * not release the CPU-side data.
+ *
+ * @throw abcg::Exception if the file cannot be parsed.
+ */
+void abcg::Mesh::loadObj(std::string_view path, bool useCache,
+                         const std::function<void(Mesh&)>& process) {
+#if defined(__EMSCRIPTEN__)
+  // There is no persistent file system to keep the cache
+  useCache = false;
+#endif
+  const auto cachePath{
+      std::filesystem::path{path}.replace_extension(".abcgmesh").string()};
+  const auto processed{static_cast<bool>(process)};
+  if (useCache && readCache(cachePath, path, processed)) return;
+
+  const auto materialFiles{parseObj(path)};
+  computeBounds();
+  if (processed) process(*this);
+
+  if (useCache) writeCache(cachePath, path, materialFiles, processed);
+}
+
+// Parses the OBJ file, deduplicates vertices and groups faces by material.
+// Returns the names of the MTL files referenced, relative to the directory
+// of the OBJ file
+std::vector<std::string> abcg::Mesh::parseObj(std::string_view path) {
+  auto basePath{std::filesystem::path{path}.parent_path().string() + "/"};
+
+  const auto data{loadObjData(path)};
+
+  if (!data.warning.empty()) {
+    fmt::print("Warning: {}\n", data.warning);
+  }
+
+  const auto& attrib{data.attrib};
+
+  m_vertices.clear();
+  m_indices.clear();
+  m_materials.clear();
+  m_submeshes.clear();
+  m_levels.clear();
+  m_meshlets.clear();
+  m_chunks.clear();
+  m_collisionMesh = {};
+
+  m_hasCPUData = true;
+  m_hasNormals = false;
+  m_hasTexCoords = false;
+
+  for (const auto& mat : data.materials) {
+    Material material;
+    material.Ka = glm::vec4(mat.ambient[0], mat.ambient[1], mat.ambient[2], 1);
+    material.Kd = glm::vec4(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2], 1);
+    material.Ks =
+        glm::vec4(mat.specular[0], mat.specular[1], mat.specular[2], 1);
+    material.shininess = mat.shininess;
+
+    if (!mat.diffuse_texname.empty() &&
+        std::filesystem::exists(basePath + mat.diffuse_texname)) {
+      material.diffuseTexturePath = basePath + mat.diffuse_texname;
+    }
+
+    const auto& normalTexname{mat.normal_texname.empty() ? mat.bump_texname
+                                                         : mat.normal_texname};
+    if (!normalTexname.empty() &&
+        std::filesystem::exists(basePath + normalTexname)) {
+      material.normalTexturePath = basePath + normalTexname;
+    }
+
+    m_materials.push_back(material);
+  }
+
+  // Faces without a material use default values, stored after the
+  // materials of the file
+  const auto defaultMaterialIndex{m_materials.size()};
+
+  // Indices grouped by material
+  std::vector<std::vector<GLuint>> materialIndices(m_materials.size() + 1);
+
+  // Upper bound of the number of unique vertices
+  VertexWelder welder{data.indices.size()};
+
+  // Loop over indices
+  for (const auto offset : iter::range(data.indices.size())) {
+    // Access to vertex
+    const auto& index{data.indices.at(offset)};
+
+    // Vertex position
+    std::size_t startIndex{static_cast<size_t>(3 * index.vertex_index)};
+    float vx{attrib.vertices.at(startIndex + 0)};
+    float vy{attrib.vertices.at(startIndex + 1)};
+    float vz{attrib.vertices.at(startIndex + 2)};
+
+    // Vertex normal
+    float nx{};
+    float ny{};
+    float nz{};
+    if (index.normal_index >= 0) {
+      m_hasNormals = true;
+      startIndex = static_cast<size_t>(3 * index.normal_index);
+      nx = attrib.normals.at(startIndex + 0);
+      ny = attrib.normals.at(startIndex + 1);
+      nz = attrib.normals.at(startIndex + 2);
+    }
+
+    // Vertex texture coordinates
+    float tu{};
+    float tv{};
+    if (index.texcoord_index >= 0) {
+      m_hasTexCoords = true;
+      startIndex = static_cast<size_t>(2 * index.texcoord_index);
+      tu = attrib.texcoords.at(startIndex + 0);
+      tv = attrib.texcoords.at(startIndex + 1);
+    }
+
+    Vertex vertex{};
+    vertex.position = {vx, vy, vz};
+    vertex.normal = {nx, ny, nz};
+    vertex.texCoord = {tu, tv};
+
+    const auto vertexIndex{welder.weld(vertex, m_vertices)};
+
+    // Material of the face (faces are triangulated)
+    const auto materialID{data.materialIDs.at(offset / 3)};
+    const auto materialIndex{materialID < 0
+                                 ? defaultMaterialIndex
+                                 : static_cast<std::size_t>(materialID)};
+    materialIndices.at(materialIndex).push_back(vertexIndex);
+  }
+
+  // Concatenate the indices of each material
+  if (!materialIndices.back().empty()) {
+    m_materials.emplace_back();
+  }
+  for (auto&& [materialIndex, indices] : iter::enumerate(materialIndices)) {
+    if (indices.empty()) continue;
+    m_submeshes.push_back({.firstIndex = m_indices.size(),
+                           .indexCount = indices.size(),
+                           .materialIndex = materialIndex});
+    m_indices.insert(m_indices.end(), indices.begin(), indices.end());
+  }
+
+  if (!m_hasNormals) {
+    computeNormals();
+  }
+
+  if (m_hasTexCoords) {
+    computeTangents();
+  }
+
+  return data.materialFiles;
+}
+
+/**
+ * @brief Centers the mesh at the origin and scales it to a unit diagonal.
+ *
+ * After scaling, the bounding box diagonal has length 2.
+ *
+ * @param offset Translation applied after centering and scaling.
+ */
+void abcg::Mesh::standardize(const glm::vec3& offset) {
+  // Center to origin and normalize largest bound to [-1, 1]
+  const auto center{(m_boundsMin + m_boundsMax) / 2.0f};
+  const auto scaling{2.0f / glm::length(m_boundsMax - m_boundsMin)};
+  for (auto& vertex : m_vertices) {
+    vertex.position = (vertex.position - center) * scaling + offset;
+  }
+
+  m_boundsMin = (m_boundsMin - center) * scaling + offset;
+  m_boundsMax = (m_boundsMax - center) * scaling + offset;
+}
+
+void abcg::Mesh::computeBounds() {
+  m_boundsMin = glm::vec3(std::numeric_limits<float>::max());
+  m_boundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+  for (const auto& vertex : m_vertices) {
+    m_boundsMin = glm::min(m_boundsMin, vertex.position);
+    m_boundsMax = glm::max(m_boundsMax, vertex.position);
+  }
+}
+
+/**
+ * @brief Computes smooth vertex normals from the face normals.
+ *
+ * Face normals are weighted by the face areas. Large meshes are processed
+ * on multiple threads.
+ */
+void abcg::Mesh::computeNormals() {
+  const auto numTriangles{static_cast<std::size_t>(getNumTriangles())};
+  const auto numVertices{m_vertices.size()};
+  const auto numThreads{getNumThreads(numTriangles)};
+
+  // Accumulate face normals on vertices
+  PartialSums partialSums{numThreads, numVertices, 1};
+  runConcurrently(numThreads, [&](std::size_t thread) {
+    const auto [first, last]{getThreadRange(numTriangles, thread, numThreads)};
+    accumulateNormals(
+        m_indices.data(), first, last, m_vertices,
+        {partialSums.get(thread, 0), partialSums.getVertexStride()});
+  });
+
+  // Normalize
+  runConcurrently(numThreads, [&](std::size_t thread) {
+    const auto [first, last]{getThreadRange(numVertices, thread, numThreads)};
+    for (const auto index : iter::range(first, last)) {
+      m_vertices[index].normal = glm::normalize(partialSums.reduce(index, 0));
+    }
+  });
+
+  m_hasNormals = true;
+}
+
+/**
+ * @brief Computes per-vertex tangents and handedness from the texture
+ * coordinates.
+ *
+ * Large meshes are processed on multiple threads.
+ */
+void abcg::Mesh::computeTangents() {
+  const auto numTriangles{static_cast<std::size_t>(getNumTriangles())};
+  const auto numVertices{m_vertices.size()};
+  const auto numThreads{getNumThreads(numTriangles)};
+
+  // Accumulate face tangents and bitangents on vertices
+  PartialSums partialSums{numThreads, numVertices, 2};
+  runConcurrently(numThreads, [&](std::size_t thread) {
+    const auto [first, last]{getThreadRange(numTriangles, thread, numThreads)};
+    const auto stride{partialSums.getVertexStride()};
+    accumulateTangents(m_indices.data(), first, last, m_vertices,
+                       {partialSums.get(thread, 0), stride},
+                       {partialSums.get(thread, 1), stride});
+  });
+
+  runConcurrently(numThreads, [&](std::size_t thread) {
+    const auto [first, last]{getThreadRange(numVertices, thread, numThreads)};
+    for (const auto index : iter::range(first, last)) {
+      auto& vertex{m_vertices[index]};
+      const auto& n{vertex.normal};
+      const auto t{partialSums.reduce(index, 0)};
+      const auto bitangent{partialSums.reduce(index, 1)};
+
+      // Orthogonalize t with respect to n
+      const auto tangent{t - n * glm::dot(n, t)};
+      vertex.tangent = glm::vec4(glm::normalize(tangent), 0);
+
+      // Compute handedness of re-orthogonalized basis
+      const auto b{glm::cross(n, t)};
+      const auto handedness{glm::dot(b, bitangent)};
+      vertex.tangent.w = (handedness < 0.0f) ? -1.0f : 1.0f;
+    }
+  });
+}
+
+/**
+ * @brief Reorders triangles and vertices for faster rendering.
+ *
+ * The triangles of each submesh are reordered for the post-transform
+ * vertex cache and then sorted in clusters to reduce overdraw. Vertices are
+ * then renumbered in the order they are first used. Meshlets are
+ * discarded. Must be called before createBuffers().
+ *
+ * @param cacheSize Number of entries of the target vertex cache.
+ */
+void abcg::Mesh::optimize(int cacheSize) {
+  m_meshlets.clear();
+  m_chunks.clear();
+  std::vector<GLuint> indices;
+  for (const auto lod : iter::range(getNumLODs())) {
+    for (const auto& submesh : getLODSubmeshes(lod)) {
+      const auto first{m_indices.begin() +
+                       static_cast<std::ptrdiff_t>(submesh.firstIndex)};
+      const auto last{first +
+                      static_cast<std::ptrdiff_t>(submesh.indexCount)};
+      indices.assign(first, last);
+      optimizeVertexCache(indices, m_vertices.size(), cacheSize);
+      optimizeOverdraw(indices, m_vertices, cacheSize);
+      std::copy(indices.begin(), indices.end(), first);
+    }
+  }
+  optimizeVertexFetch(m_indices, m_vertices);
+}
+
+/**
+ * @brief Measures the vertex cache efficiency of the index order.
+ *
+ * @param cacheSize Number of entries of the simulated FIFO cache.
+ *
+ * @return ACMR and ATVR of the whole index buffer.
+ */
+abcg::VertexCacheStatistics abcg::Mesh::getVertexCacheStatistics(
+    int cacheSize) const {
+  return analyzeVertexCache(m_indices, m_vertices.size(), cacheSize);
+}
+
+/**
+ * @brief Generates simplified levels of detail.
+ *
+ * Each level is simplified from the full mesh to about reduction times the
+ * triangles of the previous level, keeping the material boundaries. Levels
+ * stop when the triangle count can no longer be reduced without exceeding
+ * maxError. Previous levels and meshlets are discarded. Must be called
+ * before createBuffers().
+ *
+ * @param maxLevels Maximum number of levels besides the full mesh.
+ * @param reduction Ratio between the triangle counts of consecutive levels.
+ * @param maxError Largest error allowed, relative to the bounding box
+ * diagonal.
+ */
+void abcg::Mesh::generateLODs(int maxLevels, float reduction,
+                              float maxError) {
+  m_indices.resize(static_cast<std::size_t>(getNumTriangles()) * 3);
+  m_levels.clear();
+  m_meshlets.clear();
+  m_chunks.clear();
+
+  auto ratio{1.0f};
+  auto previousIndexCount{m_indices.size()};
+  auto previousError{0.0f};
+  std::vector<GLuint> indices;
+  for ([[maybe_unused]] const auto level : iter::range(maxLevels)) {
+    ratio *= reduction;
+
+    LevelOfDetail lod{.submeshes = {}, .error = previousError};
+    std::vector<GLuint> lodIndices;
+    for (const auto& submesh : m_submeshes) {
+      const auto first{m_indices.begin() +
+                       static_cast<std::ptrdiff_t>(submesh.firstIndex)};
+      const auto last{first +
+                      static_cast<std::ptrdiff_t>(submesh.indexCount)};
+      indices.assign(first, last);
+      const auto targetIndexCount{
+          static_cast<std::size_t>(
+              static_cast<float>(submesh.indexCount / 3) * ratio) *
+          3};
+      lod.error = std::max(
+          lod.error,
+          simplifyMesh(indices, m_vertices, targetIndexCount, maxError));
+      optimizeVertexCache(indices, m_vertices.size());
+
+      lod.submeshes.push_back(
+          {.firstIndex = m_indices.size() + lodIndices.size(),
+           .indexCount = indices.size(),
+           .materialIndex = submesh.materialIndex});
+      lodIndices.insert(lodIndices.end(), indices.begin(), indices.end());
+    }
+
+    // Stop when the reduction stalls
+    if (static_cast<float>(lodIndices.size()) >
+        static_cast<float>(previousIndexCount) * (1.0f + reduction) / 2.0f) {
+      break;
+    }
+
+    previousIndexCount = lodIndices.size();
+    previousError = lod.error;
+    m_indices.insert(m_indices.end(), lodIndices.begin(), lodIndices.end());
+    m_levels.push_back(std::move(lod));
+  }
+}
+
+/**
+ * @brief Chooses the coarsest level of detail with an error too small to
+ * be seen.
+ *
+ * Switching to a coarser level requires the error to be below a smaller
+ * limit than staying at the current one. This avoids alternating between
+ * levels when the size on screen stays close to a switch point.
+ *
+ * @param projectedSize Size of the bounding box diagonal on screen, in
+ * pixels.
+ * @param currentLOD Level drawn in the previous frame.
+ * @param maxPixelError Largest error allowed on screen, in pixels.
+ * @param hysteresis Fraction of maxPixelError subtracted from the limit of
+ * levels coarser than the current one.
+ *
+ * @return Level to draw.
+ */
+int abcg::Mesh::selectLOD(float projectedSize, int currentLOD,
+                          float maxPixelError, float hysteresis) const {
+  for (auto lod{getNumLODs() - 1}; lod > 0; --lod) {
+    const auto limit{lod > currentLOD ? maxPixelError * (1.0f - hysteresis)
+                                      : maxPixelError};
+    if (getLODError(lod) * projectedSize <= limit) return lod;
+  }
+  return 0;
+}
+
+/**
+ * @brief Splits the submeshes of all levels of detail in meshlets for
+ * renderCulled().
+ *
+ * Triangles are reordered inside each submesh so that each meshlet is a
+ * contiguous range of indices. Must be called after optimize() and
+ * generateLODs(), which discard the meshlets, and before createBuffers().
+ * Chunks are discarded.
+ *
+ * @param maxTriangles Maximum number of triangles of a meshlet.
+ */
+void abcg::Mesh::buildMeshlets(std::size_t maxTriangles) {
+  m_meshlets.clear();
+  m_chunks.clear();
+
+  std::vector<GLuint> indices;
+  for (const auto lod : iter::range(getNumLODs())) {
+    for (const auto& submesh : getLODSubmeshes(lod)) {
+      const auto first{m_indices.begin() +
+                       static_cast<std::ptrdiff_t>(submesh.firstIndex)};
+      const auto last{first +
+                      static_cast<std::ptrdiff_t>(submesh.indexCount)};
+      indices.assign(first, last);
+      for (auto meshlet :
+           abcg::buildMeshlets(indices, m_vertices, maxTriangles)) {
+        meshlet.firstIndex += submesh.firstIndex;
+        m_meshlets.push_back(meshlet);
+      }
+      std::copy(indices.begin(), indices.end(), first);
+    }
+  }
+
+  std::sort(m_meshlets.begin(), m_meshlets.end(),
+            [](const auto& a, const auto& b) {
+              return a.firstIndex < b.firstIndex;
+            });
+}
+
+/**
+ * @brief Groups the meshlets in chunks with their own bounding boxes.
+ *
+ * The chunk with the most meshlets is split at the median of the meshlet
+ * centers along its longest axis until there are count chunks or no chunk
+ * can be split. Meshlets of all levels of detail are grouped together, so
+ * a chunk covers the same region at every level. Inside each submesh, the
+ * meshlets are then sorted by chunk, moving their triangles in the index
+ * buffer, so that the visible meshlets of a chunk make few ranges.
+ *
+ * Builds meshlets with the default size first if there are none. Must be
+ * called before createBuffers().
+ *
+ * @param count Maximum number of chunks.
+ *
+ * @throw abcg::Exception if the CPU-side data was released.
+ */
+void abcg::Mesh::buildChunks(std::size_t count) {
+  if (!m_hasCPUData) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        "Mesh data was released and must be loaded again")};
+  }
+  if (m_meshlets.empty()) buildMeshlets();
+  m_chunks.clear();
+  if (m_meshlets.empty()) return;
+
+  // Meshlets of each chunk
+  std::vector<std::vector<std::size_t>> chunks(1);
+  chunks.front().resize(m_meshlets.size());
+  std::iota(chunks.front().begin(), chunks.front().end(), 0);
+  while (chunks.size() < count) {
+    auto largest{std::max_element(
+        chunks.begin(), chunks.end(),
+        [](const auto& a, const auto& b) { return a.size() < b.size(); })};
+    if (largest->size() < 2) break;
+
+    glm::vec3 centersMin{std::numeric_limits<float>::max()};
+    glm::vec3 centersMax{std::numeric_limits<float>::lowest()};
+    for (const auto meshlet : *largest) {
+      centersMin = glm::min(centersMin, m_meshlets.at(meshlet).center);
+      centersMax = glm::max(centersMax, m_meshlets.at(meshlet).center);
+    }
+    const auto size{centersMax - centersMin};
+    const auto axis{size.x >= size.y && size.x >= size.z ? 0
+                    : size.y >= size.z                   ? 1
+                                                         : 2};
+
+    const auto middle{largest->begin() +
+                      static_cast<std::ptrdiff_t>(largest->size() / 2)};
+    std::nth_element(largest->begin(), middle, largest->end(),
+                     [this, axis](std::size_t a, std::size_t b) {
+                       return m_meshlets.at(a).center[axis] <
+                              m_meshlets.at(b).center[axis];
+                     });
+    std::vector<std::size_t> upper(middle, largest->end());
+    largest->erase(middle, largest->end());
+    chunks.push_back(std::move(upper));
+  }
+
+  for (auto&& [chunk, meshlets] : iter::enumerate(chunks)) {
+    AABB bounds{.boundsMin = glm::vec3{std::numeric_limits<float>::max()},
+                .boundsMax = glm::vec3{std::numeric_limits<float>::lowest()}};
+    for (const auto index : meshlets) {
+      auto& meshlet{m_meshlets.at(index)};
+      meshlet.chunk = chunk;
+      for (const auto offset : iter::range(meshlet.indexCount)) {
+        const auto& position{
+            m_vertices.at(m_indices.at(meshlet.firstIndex + offset)).position};
+        bounds.boundsMin = glm::min(bounds.boundsMin, position);
+        bounds.boundsMax = glm::max(bounds.boundsMax, position);
+      }
+    }
+    m_chunks.push_back(bounds);
+  }
+
+  // Sort the meshlets of each submesh by chunk and move their indices
+  std::vector<GLuint> indices;
+  for (const auto lod : iter::range(getNumLODs())) {
+    for (const auto& submesh : getLODSubmeshes(lod)) {
+      auto isBefore{[](const Meshlet& meshlet, std::size_t index) {
+        return meshlet.firstIndex < index;
+      }};
+      const auto first{std::lower_bound(m_meshlets.begin(), m_meshlets.end(),
+                                        submesh.firstIndex, isBefore)};
+      const auto last{std::lower_bound(first, m_meshlets.end(),
+                                       submesh.firstIndex + submesh.indexCount,
+                                       isBefore)};
+      std::stable_sort(first, last, [](const auto& a, const auto& b) {
+        return a.chunk < b.chunk;
+      });
+
+      indices.clear();
+      for (auto meshlet{first}; meshlet != last; ++meshlet) {
+        const auto begin{m_indices.begin() +
+                         static_cast<std::ptrdiff_t>(meshlet->firstIndex)};
+        const auto end{begin +
+                       static_cast<std::ptrdiff_t>(meshlet->indexCount)};
+        meshlet->firstIndex = submesh.firstIndex + indices.size();
+        indices.insert(indices.end(), begin, end);
+      }
+      std::copy(indices.begin(), indices.end(),
+                m_indices.begin() +
+                    static_cast<std::ptrdiff_t>(submesh.firstIndex));
+    }
+  }
+}
+
+/**
+ * @brief Number of triangles of a level of detail.
+ *
+ * @param lod Level of detail. 0 is the full mesh.
+ */
+int abcg::Mesh::getNumTriangles(int lod) const {
+  std::size_t indexCount{};
+  for (const auto& submesh : getLODSubmeshes(lod)) {
+    indexCount += submesh.indexCount;
+  }
+  return static_cast<int>(indexCount / 3);
+}
+
+// Submeshes of a level of detail. Level 0 is the full mesh
+const std::vector<abcg::Submesh>& abcg::Mesh::getLODSubmeshes(int lod) const {
+  return lod == 0 ? m_submeshes
+                  : m_levels.at(static_cast<std::size_t>(lod - 1)).submeshes;
+}
+
+/**
+ * @brief Creates the VBO and EBO from the CPU-side data.
+ *
+ * Previous buffers are released. setupVAO() must be called again
+ * afterwards.
+ *
+ * @param format Layout of the vertices in the VBO.
+ *
+ * @throw abcg::Exception if the CPU-side data was released.
+ */
+void abcg::Mesh::createBuffers(VertexFormat format) {
+  if (!m_hasCPUData) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        "Mesh data was released and must be loaded again")};
+  }
+
+  deleteBuffers();
+
+  // Generate VBO
+  m_vertexFormat = format;
+  m_texCoordType = getTexCoordType(format);
+  glGenBuffers(1, &m_VBO);
+  glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+  if (format == VertexFormat::Compact) {
+    const auto vertices{
+        packVertices(m_vertices, m_texCoordType == GL_UNSIGNED_SHORT)};
+    m_vertexBufferSize = sizeof(CompactVertex) * vertices.size();
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(m_vertexBufferSize), vertices.data(),
+                 GL_STATIC_DRAW);
+  } else {
+    m_vertexBufferSize = sizeof(Vertex) * m_vertices.size();
+    glBufferData(GL_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(m_vertexBufferSize),
+                 m_vertices.data(), GL_STATIC_DRAW);
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // Generate EBO. 0xFFFF is left out of 16-bit indices as it is the
+  // primitive restart index in WebGL 2
+  glGenBuffers(1, &m_EBO);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+  if (m_vertices.size() <= std::numeric_limits<GLushort>::max()) {
+    m_indexType = GL_UNSIGNED_SHORT;
+    const std::vector<GLushort> indices(m_indices.begin(), m_indices.end());
+    m_indexBufferSize = sizeof(GLushort) * indices.size();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(m_indexBufferSize), indices.data(),
+                 GL_STATIC_DRAW);
+  } else {
+    m_indexType = GL_UNSIGNED_INT;
+    m_indexBufferSize = sizeof(GLuint) * m_indices.size();
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                 static_cast<GLsizeiptr>(m_indexBufferSize), m_indices.data(),
+                 GL_STATIC_DRAW);
+  }
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+}
+
+/**
+ * @brief Stores the vertices and indices in the shared buffers of a pool.
+ *
+ * Previous buffers are released. The mesh is drawn with the VAO of the
+ * arena of its vertex layout, which is set up by
+ * abcg::GeometryPool::setupVAO() or by setupVAO() of any mesh in the pool.
+ *
+ * @param pool Geometry pool, which must outlive the mesh.
+ * @param format Layout of the vertices in the VBO.
+ *
+ * @throw abcg::Exception if the CPU-side data was released.
+ */
+void abcg::Mesh::createBuffers(GeometryPool& pool, VertexFormat format) {
+  if (!m_hasCPUData) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        "Mesh data was released and must be loaded again")};
+  }
+
+  deleteBuffers();
+  glDeleteVertexArrays(1, &m_VAO);
+
+  // Compact texture coordinates are always half floats, which fit any
+  // mesh, so that all meshes of a format share the same arena
+  m_vertexFormat = format;
+  m_texCoordType = format == VertexFormat::Compact ? GL_HALF_FLOAT : GL_FLOAT;
+  m_vertexBufferSize = getVertexSize(format) * m_vertices.size();
+#if defined(__EMSCRIPTEN__)
+  // Without base vertex draws, indices are offset by the first vertex of
+  // the mesh in the pool, which is only known after allocating
+  m_indexType = GL_UNSIGNED_INT;
+#else
+  m_indexType = m_vertices.size() <= std::numeric_limits<GLushort>::max()
+                    ? GL_UNSIGNED_SHORT
+                    : GL_UNSIGNED_INT;
+#endif
+  const auto indexSize{m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort)
+                                                        : sizeof(GLuint)};
+  m_indexBufferSize = indexSize * m_indices.size();
+
+  m_pool = &pool;
+  m_poolAllocation = pool.allocate(format, m_texCoordType, m_vertices.size(),
+                                   m_indexBufferSize);
+  const auto& allocation{pool.getAllocation(m_poolAllocation)};
+  m_VAO = pool.getVAO(m_poolAllocation);
+  m_firstIndex = allocation.indexOffset / indexSize;
+
+  std::vector<CompactVertex> compactVertices;
+  if (format == VertexFormat::Compact) {
+    compactVertices =
+        packVertices(m_vertices, m_texCoordType == GL_UNSIGNED_SHORT);
+  }
+  const void* vertices{format == VertexFormat::Compact
+                           ? static_cast<const void*>(compactVertices.data())
+                           : static_cast<const void*>(m_vertices.data())};
+
+#if defined(__EMSCRIPTEN__)
+  m_baseVertex = 0;
+  std::vector<GLuint> indices(m_indices);
+  for (auto& index : indices) {
+    index += static_cast<GLuint>(allocation.firstVertex);
+  }
+  pool.upload(m_poolAllocation, vertices, indices.data());
+#else
+  m_baseVertex = static_cast<GLint>(allocation.firstVertex);
+  if (m_indexType == GL_UNSIGNED_SHORT) {
+    const std::vector<GLushort> indices(m_indices.begin(), m_indices.end());
+    pool.upload(m_poolAllocation, vertices, indices.data());
+  } else {
+    pool.upload(m_poolAllocation, vertices, m_indices.data());
+  }
+#endif
+}
+
+/**
+ * @brief Creates the VAO binding the buffers to the attributes of a program.
+ *
+ * Attributes are matched by name: inPosition, inNormal, inTexCoord and
+ * inTangent. Attributes not used by the program are skipped.
+ *
+ * For a mesh stored in an abcg::GeometryPool, the VAOs of the pool are set
+ * up instead.
+ *
+ * @param program Shader program.
+ */
+void abcg::Mesh::setupVAO(GLuint program) {
+  if (m_pool) {
+    m_pool->setupVAO(program);
+    return;
+  }
+
+  // Release previous VAO
+  glDeleteVertexArrays(1, &m_VAO);
+
+  // Create VAO
+  glGenVertexArrays(1, &m_VAO);
+  glBindVertexArray(m_VAO);
+
+  // Bind EBO and VBO
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_EBO);
+  glBindBuffer(GL_ARRAY_BUFFER, m_VBO);
+
+  bindVertexAttributes(program, m_vertexFormat, m_texCoordType);
+
+  // End of binding
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+// Size in bytes of a vertex in the VBO
+std::size_t abcg::Mesh::getVertexSize(VertexFormat format) {
+  return format == VertexFormat::Compact ? sizeof(CompactVertex)
+                                         : sizeof(Vertex);
+}
+
+// Sets the attributes of the bound VAO to read vertices of a layout from
+// the bound VBO
+void abcg::Mesh::bindVertexAttributes(GLuint program, VertexFormat format,
+                                      GLenum texCoordType) {
+  const auto compact{format == VertexFormat::Compact};
+  const auto stride{static_cast<GLsizei>(getVertexSize(format))};
+  auto bindAttribute{[program, stride](const GLchar* name, GLint size,
+                                       GLenum type, GLboolean normalized,
+                                       std::size_t offset) {
+    const GLint location{glGetAttribLocation(program, name)};
+    if (location >= 0) {
+      glEnableVertexAttribArray(static_cast<GLuint>(location));
+      glVertexAttribPointer(static_cast<GLuint>(location), size, type,
+                            normalized, stride,
+                            reinterpret_cast<void*>(offset));
+    }
+  }};
+  if (compact) {
+    bindAttribute("inPosition", 3, GL_HALF_FLOAT, GL_FALSE,
+                  offsetof(CompactVertex, position));
+    bindAttribute("inNormal", 4, GL_INT_2_10_10_10_REV, GL_TRUE,
+                  offsetof(CompactVertex, normal));
+    bindAttribute("inTexCoord", 2, texCoordType,
+                  texCoordType == GL_UNSIGNED_SHORT ? GL_TRUE : GL_FALSE,
+                  offsetof(CompactVertex, texCoord));
+    bindAttribute("inTangent", 4, GL_INT_2_10_10_10_REV, GL_TRUE,
+                  offsetof(CompactVertex, tangent));
+  } else {
+    bindAttribute("inPosition", 3, GL_FLOAT, GL_FALSE,
+                  offsetof(Vertex, position));
+    bindAttribute("inNormal", 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, normal));
+    bindAttribute("inTexCoord", 2, GL_FLOAT, GL_FALSE,
+                  offsetof(Vertex, texCoord));
+    bindAttribute("inTangent", 4, GL_FLOAT, GL_FALSE,
+                  offsetof(Vertex, tangent));
+  }
+}
+
+// Type of the texture coordinates in a vertex layout. Normalized 16-bit
+// texture coordinates are more precise than half floats but can't repeat
+// the texture
+GLenum abcg::Mesh::getTexCoordType(VertexFormat format) const {
+  if (format != VertexFormat::Compact) return GL_FLOAT;
+
+  const auto inUnitRange{
+      std::all_of(m_vertices.begin(), m_vertices.end(), [](const auto& v) {
+        return glm::all(glm::greaterThanEqual(v.texCoord, glm::vec2{0})) &&
+               glm::all(glm::lessThanEqual(v.texCoord, glm::vec2{1}));
+      })};
+  return inUnitRange ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT;
+}
+
+/**
+ * @brief Draws the mesh with the currently active program.
+ *
+ * @param bindMaterial Optional function called before drawing each submesh
+ * to set the uniform variables of its material.
+ * @param lod Level of detail. 0 is the full mesh.
+ */
+void abcg::Mesh::render(
+    const std::function<void(const Material&)>& bindMaterial,
+    int lod) const {
+  glBindVertexArray(m_VAO);
+
+  const auto indexSize{m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort)
+                                                        : sizeof(GLuint)};
+  for (const auto& submesh : getLODSubmeshes(lod)) {
+    if (bindMaterial) bindMaterial(m_materials.at(submesh.materialIndex));
+    const auto* offset{reinterpret_cast<void*>(
+        (m_firstIndex + submesh.firstIndex) * indexSize)};
+#if defined(__EMSCRIPTEN__)
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(submesh.indexCount),
+                   m_indexType, offset);
+#else
+    glDrawElementsBaseVertex(GL_TRIANGLES,
+                             static_cast<GLsizei>(submesh.indexCount),
+                             m_indexType, offset, m_baseVertex);
+#endif
+  }
+
+  glBindVertexArray(0);
+}
+
+/**
+ * @brief Draws the meshlets that may be visible with the currently active
+ * program.
+ *
+ * Meshlets outside the view frustum and, optionally, meshlets whose
+ * triangles all face away from the camera are skipped. Consecutive visible
+ * meshlets are merged, and the ranges left in each submesh are drawn with
+ * glMultiDrawElementsBaseVertex, or with a glDrawElements call per range in
+ * WebGL, which doesn't have it. Falls back to render() if there are no
+ * meshlets.
+ *
+ * @param modelViewProjMatrix Product of the projection, view and model
+ * matrices.
+ * @param eyePosition Camera position in model space.
+ * @param bindMaterial Optional function called before drawing each submesh
+ * with visible meshlets to set the uniform variables of its material.
+ * @param lod Level of detail. 0 is the full mesh.
+ * @param cullBackFaces Whether to skip meshlets facing away from the
+ * camera. Only correct for closed meshes or if back faces are culled.
+ */
+void abcg::Mesh::renderCulled(
+    const glm::mat4& modelViewProjMatrix, const glm::vec3& eyePosition,
+    const std::function<void(const Material&)>& bindMaterial, int lod,
+    bool cullBackFaces) const {
+  if (m_meshlets.empty()) {
+    render(bindMaterial, lod);
+    return;
+  }
+
+  glBindVertexArray(m_VAO);
+
+  const Frustum frustum{modelViewProjMatrix};
+  const auto indexSize{m_indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort)
+                                                        : sizeof(GLuint)};
+  std::vector<GLsizei> counts;
+  std::vector<std::size_t> firstIndices;
+  std::vector<const void*> offsets;
+  std::vector<GLint> baseVertices;
+  for (const auto& submesh : getLODSubmeshes(lod)) {
+    getVisibleRanges(submesh, frustum, eyePosition, cullBackFaces, {}, counts,
+                     firstIndices);
+    if (counts.empty()) continue;
+
+    if (bindMaterial) bindMaterial(m_materials.at(submesh.materialIndex));
+    offsets.clear();
+    for (const auto firstIndex : firstIndices) {
+      offsets.push_back(
+          reinterpret_cast<void*>((m_firstIndex + firstIndex) * indexSize));
+    }
+#if defined(__EMSCRIPTEN__)
+    for (const auto range : iter::range(counts.size())) {
+      glDrawElements(GL_TRIANGLES, counts.at(range), m_indexType,
+                     offsets.at(range));
+    }
+#else
+    baseVertices.assign(counts.size(), m_baseVertex);
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), m_indexType,
+                                  offsets.data(),
+                                  static_cast<GLsizei>(counts.size()),
+                                  baseVertices.data());
+#endif
+  }
+
+  glBindVertexArray(0);
+}
+
+/**
+ * @brief Queues the submeshes of the mesh in a render queue.
+ *
+ * Each submesh becomes an item with its material. If meshlets were built,
+ * those outside the view frustum and, optionally, those facing away from
+ * the camera are left out as in renderCulled().
+ *
+ * @param queue Render queue, after abcg::RenderQueue::begin().
+ * @param program Shader program.
+ * @param transform Handle of the model matrix in the queue.
+ * @param lod Level of detail. 0 is the full mesh.
+ * @param cullBackFaces Whether to skip meshlets facing away from the
+ * camera. Only correct for closed meshes or if back faces are culled.
+ * @param pass Render pass of the items.
+ */
+void abcg::Mesh::submit(RenderQueue& queue, GLuint program,
+                        std::size_t transform, int lod, bool cullBackFaces,
+                        RenderPass pass) const {
+  submitMeshlets(queue, program, transform, lod, cullBackFaces, pass, {});
+}
+
+/**
+ * @brief Queues the part of the mesh in a chunk in a render queue.
+ *
+ * As submit(), but only with the meshlets of the chunk, which is also the
+ * point whose depth orders the items.
+ *
+ * @param queue Render queue, after abcg::RenderQueue::begin().
+ * @param program Shader program.
+ * @param transform Handle of the model matrix in the queue.
+ * @param chunk Index of the chunk in getChunks().
+ * @param lod Level of detail. 0 is the full mesh.
+ * @param cullBackFaces Whether to skip meshlets facing away from the
+ * camera. Only correct for closed meshes or if back faces are culled.
+ * @param pass Render pass of the items.
+ */
+void abcg::Mesh::submitChunk(RenderQueue& queue, GLuint program,
+                             std::size_t transform, std::size_t chunk,
+                             int lod, bool cullBackFaces,
+                             RenderPass pass) const {
+  submitMeshlets(queue, program, transform, lod, cullBackFaces, pass, chunk);
+}
+
+// Queues the submeshes, restricted to the meshlets of a chunk if given
+void abcg::Mesh::submitMeshlets(RenderQueue& queue, GLuint program,
+                                std::size_t transform, int lod,
+                                bool cullBackFaces, RenderPass pass,
+                                std::optional<std::size_t> chunk) const {
+  const auto& bounds{chunk ? m_chunks.at(*chunk)
+                           : AABB{.boundsMin = m_boundsMin,
+                                  .boundsMax = m_boundsMax}};
+  DrawItem item{.pass = pass,
+                .program = program,
+                .VAO = m_VAO,
+                .textureTarget = GL_TEXTURE_2D,
+                .texture = 0,
+                .material = nullptr,
+                .mode = GL_TRIANGLES,
+                .indexType = m_indexType,
+                .firstIndex = 0,
+                .indexCount = 0,
+                .baseVertex = m_baseVertex,
+                .transform = transform,
+                .center = (bounds.boundsMin + bounds.boundsMax) / 2.0f};
+
+  if (m_meshlets.empty()) {
+    for (const auto& submesh : getLODSubmeshes(lod)) {
+      item.material = &m_materials.at(submesh.materialIndex);
+      item.firstIndex = m_firstIndex + submesh.firstIndex;
+      item.indexCount = submesh.indexCount;
+      queue.submit(item);
+    }
+    return;
+  }
+
+  const auto modelViewMatrix{queue.getViewMatrix() *
+                             queue.getModelMatrix(transform)};
+  const Frustum frustum{queue.getProjMatrix() * modelViewMatrix};
+  const glm::vec3 eyePosition{glm::inverse(modelViewMatrix)[3]};
+  std::vector<GLsizei> counts;
+  std::vector<std::size_t> firstIndices;
+  for (const auto& submesh : getLODSubmeshes(lod)) {
+    getVisibleRanges(submesh, frustum, eyePosition, cullBackFaces, chunk,
+                     counts, firstIndices);
+    for (auto& firstIndex : firstIndices) {
+      firstIndex += m_firstIndex;
+    }
+    item.material = &m_materials.at(submesh.materialIndex);
+    queue.submit(item, counts, firstIndices);
+  }
+}
+
+// Ranges of indices of the visible meshlets of a submesh, only of a chunk
+// if given. Consecutive visible meshlets are merged in a single range
+void abcg::Mesh::getVisibleRanges(
+    const Submesh& submesh, const Frustum& frustum,
+    const glm::vec3& eyePosition, bool cullBackFaces,
+    std::optional<std::size_t> chunk, std::vector<GLsizei>& counts,
+    std::vector<std::size_t>& firstIndices) const {
+  counts.clear();
+  firstIndices.clear();
+
+  auto isVisible{[&](const Meshlet& meshlet) {
+    if (!frustum.intersectsSphere(meshlet.center, meshlet.radius)) {
+      return false;
+    }
+    if (!cullBackFaces) return true;
+    const auto view{meshlet.center - eyePosition};
+    return glm::dot(view, meshlet.coneAxis) <
+           meshlet.coneCutoff * glm::length(view) + meshlet.radius;
+  }};
+
+  auto isBefore{[](const Meshlet& m, std::size_t index) {
+    return m.firstIndex < index;
+  }};
+  auto first{std::lower_bound(m_meshlets.begin(), m_meshlets.end(),
+                              submesh.firstIndex, isBefore)};
+  auto last{std::lower_bound(first, m_meshlets.end(),
+                             submesh.firstIndex + submesh.indexCount,
+                             isBefore)};
+  if (chunk) {
+    // Meshlets are sorted by chunk inside each submesh
+    first = std::partition_point(first, last, [&chunk](const Meshlet& m) {
+      return m.chunk < *chunk;
+    });
+    last = std::partition_point(first, last, [&chunk](const Meshlet& m) {
+      return m.chunk == *chunk;
+    });
+  }
+
+  auto rangeEnd{submesh.firstIndex};
+  for (auto meshlet{first}; meshlet != last; ++meshlet) {
+    if (!isVisible(*meshlet)) continue;
+    if (!counts.empty() && meshlet->firstIndex == rangeEnd) {
+      counts.back() += static_cast<GLsizei>(meshlet->indexCount);
+    } else {
+      counts.push_back(static_cast<GLsizei>(meshlet->indexCount));
+      firstIndices.push_back(meshlet->firstIndex);
+    }
+    rangeEnd = meshlet->firstIndex + meshlet->indexCount;
+  }
+}
+
+/**
+ * @brief Frees the CPU-side vertices and indices.
+ *
+ * The mesh can still be drawn with the buffers created by createBuffers(),
+ * and setupVAO() can still be called. Processing functions and
+ * createBuffers() can't be used until the mesh is loaded again, which is
+ * fast if the OBJ file is cached.
+ *
+ * @param keepCollisionMesh Whether to keep the positions and triangles of
+ * a level of detail in an abcg::CollisionMesh. Vertices that only differ
+ * in their other attributes are merged.
+ * @param collisionLOD Level of detail of the collision mesh. 0 is the full
+ * mesh.
+ */
+void abcg::Mesh::releaseCPUData(bool keepCollisionMesh, int collisionLOD) {
+  if (!m_hasCPUData) return;
+
+  m_collisionMesh = {};
+  if (keepCollisionMesh) {
+    std::vector<Vertex> positions;
+    std::vector<GLuint> indices;
+    indices.reserve(static_cast<std::size_t>(getNumTriangles(collisionLOD)) *
+                    3);
+    VertexWelder welder{m_vertices.size()};
+    for (const auto& submesh : getLODSubmeshes(collisionLOD)) {
+      for (const auto index : iter::range(
+               submesh.firstIndex, submesh.firstIndex + submesh.indexCount)) {
+        const auto& position{m_vertices.at(m_indices.at(index)).position};
+        indices.push_back(welder.weld({.position = position}, positions));
+      }
+    }
+
+    std::vector<glm::vec3> collisionPositions(positions.size());
+    std::transform(positions.begin(), positions.end(),
+                   collisionPositions.begin(),
+                   [](const Vertex& vertex) { return vertex.position; });
+    m_collisionMesh = CollisionMesh{std::move(collisionPositions),
+                                    std::move(indices)};
+  }
+
+  // Swap with empty vectors to free the memory
+  std::vector<Vertex>{}.swap(m_vertices);
+  std::vector<GLuint>{}.swap(m_indices);
+  m_hasCPUData = false;
+}
+
+/**
+ * @brief Number of bytes allocated for the CPU-side data.
+ *
+ * Includes vertices, indices, submeshes, levels of detail, meshlets,
+ * chunks, materials and the collision mesh.
+ */
+std::size_t abcg::Mesh::getCPUMemoryUsage() const {
+  auto size{m_vertices.capacity() * sizeof(Vertex) +
+            m_indices.capacity() * sizeof(GLuint) +
+            m_submeshes.capacity() * sizeof(Submesh) +
+            m_levels.capacity() * sizeof(LevelOfDetail) +
+            m_meshlets.capacity() * sizeof(Meshlet) +
+            m_chunks.capacity() * sizeof(AABB) +
+            m_materials.capacity() * sizeof(Material) +
+            m_collisionMesh.getMemoryUsage()};
+  for (const auto& level : m_levels) {
+    size += level.submeshes.capacity() * sizeof(Submesh);
+  }
+  for (const auto& material : m_materials) {
+    size += material.diffuseTexturePath.capacity() +
+            material.normalTexturePath.capacity();
+  }
+  return size;
+}
+
+/**
+ * @brief Releases the OpenGL buffers and VAO.
+ *
+ * For a mesh stored in an abcg::GeometryPool, its ranges are freed and the
+ * shared buffers and VAO are kept.
+ */
+void abcg::Mesh::destroy() {
+  deleteBuffers();
+  glDeleteVertexArrays(1, &m_VAO);
+  m_VAO = 0;
+}
+
+// Releases the VBO and EBO, or the ranges of the pool storing the mesh
+void abcg::Mesh::deleteBuffers() {
+  if (m_pool) {
+    m_pool->release(m_poolAllocation);
+    m_pool = nullptr;
+    // The VAO belongs to the pool
+    m_VAO = 0;
+  }
+  glDeleteBuffers(1, &m_EBO);
+  glDeleteBuffers(1, &m_VBO);
+  m_EBO = 0;
+  m_VBO = 0;
+  m_firstIndex = 0;
+  m_baseVertex = 0;
+}
+
+// Reads the mesh from the cache file. Returns false if the file doesn't
+// exist, is invalid, is older than the source file or its MTL files, or was
+// written with or without processing when the other is expected
+bool abcg::Mesh::readCache(const std::string& cachePath,
+                           std::string_view sourcePath, bool processed) {
+  CacheHeader expected{.processed = processed ? 1U : 0U};
+  if (!getSourceIdentity(sourcePath, expected.sourceSize,
+                         expected.sourceTime)) {
+    return false;
+  }
+
+  std::error_code error;
+  if (!std::filesystem::exists(cachePath, error)) return false;
+
+  const MappedFile file{cachePath};
+  BlobReader reader{file.getData()};
+
+  CacheHeader header;
+  if (!reader.read(header) || header.magic != expected.magic ||
+      header.version != expected.version ||
+      header.vertexSize != expected.vertexSize ||
+      header.processed != expected.processed ||
+      header.sourceSize != expected.sourceSize ||
+      header.sourceTime != expected.sourceTime) {
+    return false;
+  }
+
+  const auto basePath{std::filesystem::path{sourcePath}.parent_path()};
+  for ([[maybe_unused]] auto index : iter::range(header.materialFileCount)) {
+    CacheMaterialFile cached;
+    std::string name;
+    if (!reader.read(cached) || !reader.read(name, cached.nameSize)) {
+      return false;
+    }
+    CacheMaterialFile current;
+    current.found = getSourceIdentity((basePath / name).string(),
+                                      current.size, current.time)
+                        ? 1U
+                        : 0U;
+    if (current.found != cached.found ||
+        (current.found != 0 &&
+         (current.size != cached.size || current.time != cached.time))) {
+      return false;
+    }
+  }
+
+  std::vector<Vertex> vertices;
+  std::vector<GLuint> indices;
+  std::vector<CacheSubmesh> submeshes;
+  if (!reader.read(vertices, header.vertexCount) ||
+      !reader.read(indices, header.indexCount) ||
+      !reader.read(submeshes, header.submeshCount) ||
+      header.materialCount > reader.available<CacheMaterial>()) {
+    return false;
+  }
+
+  std::vector<Material> materials;
+  materials.reserve(gsl::narrow_cast<std::size_t>(header.materialCount));
+  for ([[maybe_unused]] auto index : iter::range(header.materialCount)) {
+    CacheMaterial cached;
+    std::string diffuseTexturePath;
+    std::string normalTexturePath;
+    if (!reader.read(cached) ||
+        !reader.read(diffuseTexturePath, cached.diffuseTexturePathSize) ||
+        !reader.read(normalTexturePath, cached.normalTexturePathSize)) {
+      return false;
+    }
+
+    Material material{.Ka = cached.Ka,
+                      .Kd = cached.Kd,
+                      .Ks = cached.Ks,
+                      .shininess = cached.shininess};
+    if (!diffuseTexturePath.empty()) {
+      material.diffuseTexturePath = (basePath / diffuseTexturePath).string();
+    }
+    if (!normalTexturePath.empty()) {
+      material.normalTexturePath = (basePath / normalTexturePath).string();
+    }
+    materials.push_back(material);
+  }
+
+  auto toSubmesh{[](const CacheSubmesh& submesh) {
+    return Submesh{.firstIndex = submesh.firstIndex,
+                   .indexCount = submesh.indexCount,
+                   .materialIndex = submesh.materialIndex};
+  }};
+
+  std::vector<LevelOfDetail> levels;
+  for ([[maybe_unused]] auto index : iter::range(header.levelCount)) {
+    CacheLevel cached;
+    std::vector<CacheSubmesh> levelSubmeshes;
+    if (!reader.read(cached) ||
+        !reader.read(levelSubmeshes, header.submeshCount)) {
+      return false;
+    }
+    submeshes.insert(submeshes.end(), levelSubmeshes.begin(),
+                     levelSubmeshes.end());
+    auto& level{levels.emplace_back()};
+    level.error = cached.error;
+    std::transform(levelSubmeshes.begin(), levelSubmeshes.end(),
+                   std::back_inserter(level.submeshes), toSubmesh);
+  }
+
+  std::vector<CacheMeshlet> meshlets;
+  std::vector<CacheChunk> chunks;
+  if (!reader.read(meshlets, header.meshletCount) ||
+      !reader.read(chunks, header.chunkCount)) {
+    return false;
+  }
+
+  // Reject indices out of range. The submeshes of the levels were appended
+  // to those of the full mesh to be checked too
+  for (const auto& submesh : submeshes) {
+    if (submesh.firstIndex + submesh.indexCount > indices.size() ||
+        submesh.materialIndex >= materials.size()) {
+      return false;
+    }
+  }
+  for (const auto& meshlet : meshlets) {
+    if (meshlet.firstIndex + meshlet.indexCount > indices.size() ||
+        meshlet.chunk >= std::max<std::uint64_t>(chunks.size(), 1)) {
+      return false;
+    }
+  }
+  if (std::any_of(indices.begin(), indices.end(), [&](GLuint index) {
+        return index >= vertices.size();
+      })) {
+    return false;
+  }
+
+  m_vertices = std::move(vertices);
+  m_indices = std::move(indices);
+  m_materials = std::move(materials);
+  m_submeshes.clear();
+  std::transform(submeshes.begin(),
+                 submeshes.begin() +
+                     gsl::narrow_cast<std::ptrdiff_t>(header.submeshCount),
+                 std::back_inserter(m_submeshes), toSubmesh);
+  m_levels = std::move(levels);
+  m_meshlets.clear();
+  for (const auto& meshlet : meshlets) {
+    m_meshlets.push_back(
+        {.firstIndex = gsl::narrow_cast<std::size_t>(meshlet.firstIndex),
+         .indexCount = gsl::narrow_cast<std::size_t>(meshlet.indexCount),
+         .center = meshlet.center,
+         .radius = meshlet.radius,
+         .coneAxis = meshlet.coneAxis,
+         .coneCutoff = meshlet.coneCutoff,
+         .chunk = gsl::narrow_cast<std::size_t>(meshlet.chunk)});
+  }
+  m_chunks.clear();
+  for (const auto& chunk : chunks) {
+    m_chunks.push_back(
+        {.boundsMin = chunk.boundsMin, .boundsMax = chunk.boundsMax});
+  }
+  m_collisionMesh = {};
+  m_boundsMin = header.boundsMin;
+  m_boundsMax = header.boundsMax;
+  m_hasCPUData = true;
+  m_hasNormals = header.hasNormals != 0;
+  m_hasTexCoords = header.hasTexCoords != 0;
+
+  return true;
+}
+
+// Writes the mesh to the cache file. The file is written to a temporary
+// file first so that a partially written cache is never read
+void abcg::Mesh::writeCache(const std::string& cachePath,
+                            std::string_view sourcePath,
+                            const std::vector<std::string>& materialFiles,
+                            bool processed) const {
+  CacheHeader header{.hasNormals = m_hasNormals ? 1U : 0U,
+                     .hasTexCoords = m_hasTexCoords ? 1U : 0U,
+                     .processed = processed ? 1U : 0U,
+                     .vertexCount = m_vertices.size(),
+                     .indexCount = m_indices.size(),
+                     .submeshCount = m_submeshes.size(),
+                     .materialCount = m_materials.size(),
+                     .materialFileCount = materialFiles.size(),
+                     .levelCount = m_levels.size(),
+                     .meshletCount = m_meshlets.size(),
+                     .chunkCount = m_chunks.size(),
+                     .boundsMin = m_boundsMin,
+                     .boundsMax = m_boundsMax};
+  if (!getSourceIdentity(sourcePath, header.sourceSize, header.sourceTime)) {
+    return;
+  }
+
+  const auto temporaryPath{cachePath + ".tmp"};
+  {
+    std::ofstream output(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!output) return;
+
+    auto write{[&output](const auto* values, std::size_t count) {
+      output.write(reinterpret_cast<const char*>(values),
+                   static_cast<std::streamsize>(count * sizeof(*values)));
+    }};
+
+    write(&header, 1);
+
+    const auto basePath{std::filesystem::path{sourcePath}.parent_path()};
+    for (const auto& name : materialFiles) {
+      CacheMaterialFile cached{
+          .nameSize = static_cast<std::uint32_t>(name.size())};
+      cached.found =
+          getSourceIdentity((basePath / name).string(), cached.size,
+                            cached.time)
+              ? 1U
+              : 0U;
+      write(&cached, 1);
+      write(name.data(), name.size());
+    }
+
+    auto writeSubmeshes{[&write](const std::vector<Submesh>& submeshes) {
+      for (const auto& submesh : submeshes) {
+        const CacheSubmesh cached{.firstIndex = submesh.firstIndex,
+                                  .indexCount = submesh.indexCount,
+                                  .materialIndex = submesh.materialIndex};
+        write(&cached, 1);
+      }
+    }};
+
+    write(m_vertices.data(), m_vertices.size());
+    write(m_indices.data(), m_indices.size());
+    writeSubmeshes(m_submeshes);
+
+    auto relativePath{[&basePath](const std::string& path) {
+      return path.empty()
+                 ? std::string{}
+                 : std::filesystem::path{path}.lexically_relative(basePath)
+                       .string();
+    }};
+    for (const auto& material : m_materials) {
+      const auto diffuseTexturePath{
+          relativePath(material.diffuseTexturePath)};
+      const auto normalTexturePath{relativePath(material.normalTexturePath)};
+      const CacheMaterial cached{
+          .Ka = material.Ka,
+          .Kd = material.Kd,
+          .Ks = material.Ks,
+          .shininess = material.shininess,
+          .diffuseTexturePathSize =
+              static_cast<std::uint32_t>(diffuseTexturePath.size()),
+          .normalTexturePathSize =
+              static_cast<std::uint32_t>(normalTexturePath.size())};
+      write(&cached, 1);
+      write(diffuseTexturePath.data(), diffuseTexturePath.size());
+      write(normalTexturePath.data(), normalTexturePath.size());
+    }
+
+    for (const auto& level : m_levels) {
+      const CacheLevel cached{.error = level.error};
+      write(&cached, 1);
+      writeSubmeshes(level.submeshes);
+    }
+    for (const auto& meshlet : m_meshlets) {
+      const CacheMeshlet cached{.firstIndex = meshlet.firstIndex,
+                                .indexCount = meshlet.indexCount,
+                                .chunk = meshlet.chunk,
+                                .center = meshlet.center,
+                                .radius = meshlet.radius,
+                                .coneAxis = meshlet.coneAxis,
+                                .coneCutoff = meshlet.coneCutoff};
+      write(&cached, 1);
+    }
+    for (const auto& chunk : m_chunks) {
+      const CacheChunk cached{.boundsMin = chunk.boundsMin,
+                              .boundsMax = chunk.boundsMax};
+      write(&cached, 1);
+    }
+
+    if (!output) {
+      output.close();
+      std::error_code error;
+      std::filesystem::remove(temporaryPath, error);
+      return;
+    }
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporaryPath, cachePath, error);
+  if (error) std::filesystem::remove(temporaryPath, error);
+}
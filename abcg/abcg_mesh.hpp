@@ -0,0 +1,344 @@
+/**
+ * @file abcg_mesh.hpp
+ * @brief abcg::Mesh header file.
+ *
+ * Declaration of abcg::Mesh class and its vertex and material types.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_MESH_HPP_
+#define ABCG_MESH_HPP_
+
+#include <functional>
+#include <glm/gtc/epsilon.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "abcg_aabbtree.hpp"
+#include "abcg_collisionmesh.hpp"
+#include "abcg_external.hpp"
+#include "abcg_frustum.hpp"
+#include "abcg_renderqueue.hpp"
+
+namespace abcg {
+class GeometryPool;
+class GPUCuller;
+struct LevelOfDetail;
+struct Material;
+class Mesh;
+struct Meshlet;
+struct Submesh;
+struct Vertex;
+struct VertexCacheStatistics;
+enum class VertexFormat;
+}  // namespace abcg
+
+/**
+ * @brief Interleaved vertex attributes of abcg::Mesh.
+ *
+ * The tangent is only meaningful if the mesh has texture coordinates. Its w
+ * component stores the handedness of the tangent space.
+ */
+struct abcg::Vertex {
+  glm::vec3 position{};
+  glm::vec3 normal{};
+  glm::vec2 texCoord{};
+  glm::vec4 tangent{};
+
+  bool operator==(const Vertex& other) const noexcept {
+    static const auto epsilon{std::numeric_limits<float>::epsilon()};
+    return glm::all(glm::epsilonEqual(position, other.position, epsilon)) &&
+           glm::all(glm::epsilonEqual(normal, other.normal, epsilon)) &&
+           glm::all(glm::epsilonEqual(texCoord, other.texCoord, epsilon));
+  }
+};
+
+/**
+ * @brief Material properties read from the MTL file of a mesh.
+ */
+struct abcg::Material {
+  glm::vec4 Ka{0.1f, 0.1f, 0.1f, 1.0f};
+  glm::vec4 Kd{0.7f, 0.7f, 0.7f, 1.0f};
+  glm::vec4 Ks{1.0f, 1.0f, 1.0f, 1.0f};
+  float shininess{25.0f};
+  // Full paths of the texture files. Empty if there is no texture
+  std::string diffuseTexturePath{};
+  std::string normalTexturePath{};
+  // Layer of the diffuse texture in a texture array, assigned by the
+  // application. -1 if none
+  int diffuseLayer{-1};
+};
+
+/**
+ * @brief Contiguous range of indices drawn with a single material.
+ */
+struct abcg::Submesh {
+  std::size_t firstIndex{};
+  std::size_t indexCount{};
+  std::size_t materialIndex{};
+};
+
+/**
+ * @brief Simplified version of abcg::Mesh sharing its vertex buffer.
+ */
+struct abcg::LevelOfDetail {
+  // Ranges of the index buffer, one per submesh of the full mesh
+  std::vector<Submesh> submeshes;
+  // Largest geometric error relative to the bounding box diagonal
+  float error{};
+};
+
+/**
+ * @brief Cluster of nearby triangles of abcg::Mesh with data for culling.
+ *
+ * The triangles of a meshlet are a contiguous range of the index buffer
+ * inside a single submesh.
+ */
+struct abcg::Meshlet {
+  std::size_t firstIndex{};
+  std::size_t indexCount{};
+  // Bounding sphere of the vertices
+  glm::vec3 center{};
+  float radius{};
+  // Cone containing the face normals. All triangles face away from a
+  // viewer at eye if dot(center - eye, coneAxis) >= coneCutoff *
+  // distance(center, eye) + radius. coneCutoff is 1 if the normals are
+  // too spread for the test to ever pass
+  glm::vec3 coneAxis{};
+  float coneCutoff{1.0f};
+  // Index of the chunk in abcg::Mesh::getChunks(). 0 if the mesh has no
+  // chunks
+  std::size_t chunk{};
+};
+
+/**
+ * @brief Layout of the vertices in the VBO of abcg::Mesh.
+ */
+enum class abcg::VertexFormat {
+  // abcg::Vertex as is: 48 bytes
+  Full,
+  // 20 bytes: half-float position, GL_INT_2_10_10_10_REV normal and tangent
+  // and 16-bit texture coordinates. The handedness is the sign of the
+  // tangent w component. Positions lose precision far from the origin, so
+  // this is meant for standardized meshes
+  Compact
+};
+
+/**
+ * @brief Efficiency of the post-transform vertex cache for an index buffer.
+ *
+ * Measured by simulating a FIFO cache.
+ */
+struct abcg::VertexCacheStatistics {
+  // Average cache miss ratio: transformed vertices per triangle. 0.5 is
+  // the best possible for large regular meshes, 3 the worst
+  float acmr{};
+  // Average transform to vertex ratio: transformed vertices per referenced
+  // vertex. 1 is the best possible
+  float atvr{};
+};
+
+/**
+ * @brief abcg::Mesh class.
+ *
+ * Triangle mesh loaded from a Wavefront OBJ file. Owns the CPU-side vertex
+ * and index data and the OpenGL buffers and VAO created from them.
+ *
+ * Faces of all shapes are merged and grouped by material, so each
+ * material is drawn with one call regardless of the number of shapes.
+ *
+ * The result of parsing an OBJ file is cached in a binary file next to it
+ * (same name with the .abcgmesh extension) and read back on later loads
+ * while the OBJ file keeps the same size and modification time. The cache
+ * can also hold the mesh after processing steps such as optimize(),
+ * generateLODs() and buildMeshlets(), so that they are not repeated.
+ *
+ * The EBO stores 16-bit indices when the mesh has at most 65535 vertices.
+ *
+ * Simplified levels of detail can be generated after loading. Their
+ * indices are appended to the index buffer of the full mesh, which is
+ * level 0, so all levels are drawn from the same VBO and EBO.
+ *
+ * Submeshes can also be split in meshlets, which renderCulled() tests
+ * against the view frustum and for facing away from the camera before
+ * drawing the remaining ones with a single glMultiDrawElements call per
+ * submesh.
+ *
+ * Meshlets can in turn be grouped in spatially compact chunks with their
+ * own bounding boxes, so that large meshes such as buildings are culled
+ * in parts, for instance by an abcg::AABBTree, and only the chunks found
+ * visible are submitted.
+ *
+ * The buffers can also be ranges of the buffers of an abcg::GeometryPool
+ * shared with other meshes, in which case the VAO is shared as well.
+ *
+ * Once the buffers are created, the CPU-side vertices and indices can be
+ * released, optionally keeping an abcg::CollisionMesh with just the
+ * positions and triangles for ray casts and collision tests.
+ */
+class abcg::Mesh {
+ public:
+  void loadObj(std::string_view path, bool useCache = true,
+               const std::function<void(Mesh&)>& process = {});
+  void standardize(const glm::vec3& offset = {});
+  void computeNormals();
+  void computeTangents();
+  void optimize(int cacheSize = 16);
+  [[nodiscard]] VertexCacheStatistics getVertexCacheStatistics(
+      int cacheSize = 16) const;
+  void generateLODs(int maxLevels = 4, float reduction = 0.5f,
+                    float maxError = 0.05f);
+  [[nodiscard]] int selectLOD(float projectedSize, int currentLOD,
+                              float maxPixelError = 1.0f,
+                              float hysteresis = 0.25f) const;
+  void buildMeshlets(std::size_t maxTriangles = 64);
+  void buildChunks(std::size_t count = 16);
+
+  void createBuffers(VertexFormat format = VertexFormat::Full);
+  void createBuffers(GeometryPool& pool,
+                     VertexFormat format = VertexFormat::Full);
+  void setupVAO(GLuint program);
+  void render(const std::function<void(const Material&)>& bindMaterial = {},
+              int lod = 0) const;
+  void renderCulled(
+      const glm::mat4& modelViewProjMatrix, const glm::vec3& eyePosition,
+      const std::function<void(const Material&)>& bindMaterial = {},
+      int lod = 0, bool cullBackFaces = false) const;
+  void submit(RenderQueue& queue, GLuint program, std::size_t transform,
+              int lod = 0, bool cullBackFaces = false,
+              RenderPass pass = RenderPass::Opaque) const;
+  void submitChunk(RenderQueue& queue, GLuint program, std::size_t transform,
+                   std::size_t chunk, int lod = 0, bool cullBackFaces = false,
+                   RenderPass pass = RenderPass::Opaque) const;
+  void releaseCPUData(bool keepCollisionMesh = false, int collisionLOD = 0);
+  void destroy();
+
+  [[nodiscard]] const std::vector<Vertex>& getVertices() const {
+    return m_vertices;
+  }
+  [[nodiscard]] const std::vector<GLuint>& getIndices() const {
+    return m_indices;
+  }
+  [[nodiscard]] const std::vector<Submesh>& getSubmeshes() const {
+    return m_submeshes;
+  }
+  [[nodiscard]] std::vector<Material>& getMaterials() { return m_materials; }
+  [[nodiscard]] const std::vector<Material>& getMaterials() const {
+    return m_materials;
+  }
+  [[nodiscard]] int getNumTriangles(int lod = 0) const;
+  [[nodiscard]] int getNumLODs() const {
+    return static_cast<int>(m_levels.size()) + 1;
+  }
+  [[nodiscard]] float getLODError(int lod) const {
+    return lod == 0 ? 0.0f
+                    : m_levels.at(static_cast<std::size_t>(lod - 1)).error;
+  }
+  [[nodiscard]] const std::vector<Meshlet>& getMeshlets() const {
+    return m_meshlets;
+  }
+  [[nodiscard]] const std::vector<AABB>& getChunks() const {
+    return m_chunks;
+  }
+  [[nodiscard]] const CollisionMesh& getCollisionMesh() const {
+    return m_collisionMesh;
+  }
+  [[nodiscard]] const glm::vec3& getBoundsMin() const { return m_boundsMin; }
+  [[nodiscard]] const glm::vec3& getBoundsMax() const { return m_boundsMax; }
+  [[nodiscard]] VertexFormat getVertexFormat() const { return m_vertexFormat; }
+  [[nodiscard]] GLenum getIndexType() const { return m_indexType; }
+  [[nodiscard]] std::size_t getVertexBufferSize() const {
+    return m_vertexBufferSize;
+  }
+  [[nodiscard]] std::size_t getIndexBufferSize() const {
+    return m_indexBufferSize;
+  }
+  [[nodiscard]] std::size_t getCPUMemoryUsage() const;
+  [[nodiscard]] bool hasCPUData() const { return m_hasCPUData; }
+  [[nodiscard]] bool hasNormals() const { return m_hasNormals; }
+  [[nodiscard]] bool hasTexCoords() const { return m_hasTexCoords; }
+
+ private:
+  friend GeometryPool;
+  friend GPUCuller;
+
+  std::vector<Vertex> m_vertices;
+  std::vector<GLuint> m_indices;
+  std::vector<Material> m_materials;
+  std::vector<Submesh> m_submeshes;
+
+  // Levels of detail from 1 on, coarser at higher levels
+  std::vector<LevelOfDetail> m_levels;
+
+  // Meshlets of all levels, sorted by their first index
+  std::vector<Meshlet> m_meshlets;
+
+  // Bounding boxes of the chunks of meshlets. Inside each submesh, the
+  // meshlets of a chunk are contiguous
+  std::vector<AABB> m_chunks;
+
+  // Kept by releaseCPUData() if requested
+  CollisionMesh m_collisionMesh;
+
+  // Axis-aligned bounding box of the vertex positions
+  glm::vec3 m_boundsMin{};
+  glm::vec3 m_boundsMax{};
+
+  // False after releaseCPUData()
+  bool m_hasCPUData{false};
+  bool m_hasNormals{false};
+  bool m_hasTexCoords{false};
+
+  GLuint m_VAO{};
+  GLuint m_VBO{};
+  GLuint m_EBO{};
+
+  // Layout of the buffers created by createBuffers()
+  VertexFormat m_vertexFormat{VertexFormat::Full};
+  GLenum m_texCoordType{GL_FLOAT};
+  GLenum m_indexType{GL_UNSIGNED_INT};
+  std::size_t m_vertexBufferSize{};
+  std::size_t m_indexBufferSize{};
+
+  // Pool storing the buffers, if any, and where. Index offsets and
+  // submesh ranges are relative to m_firstIndex, and indices to
+  // m_baseVertex
+  GeometryPool* m_pool{};
+  std::size_t m_poolAllocation{};
+  std::size_t m_firstIndex{};
+  GLint m_baseVertex{};
+
+  [[nodiscard]] static std::size_t getVertexSize(VertexFormat format);
+  static void bindVertexAttributes(GLuint program, VertexFormat format,
+                                   GLenum texCoordType);
+
+  [[nodiscard]] std::vector<std::string> parseObj(std::string_view path);
+  void deleteBuffers();
+  [[nodiscard]] GLenum getTexCoordType(VertexFormat format) const;
+  void computeBounds();
+  [[nodiscard]] const std::vector<Submesh>& getLODSubmeshes(int lod) const;
+  void submitMeshlets(RenderQueue& queue, GLuint program,
+                      std::size_t transform, int lod, bool cullBackFaces,
+                      RenderPass pass,
+                      std::optional<std::size_t> chunk) const;
+  void getVisibleRanges(const Submesh& submesh, const Frustum& frustum,
+                        const glm::vec3& eyePosition, bool cullBackFaces,
+                        std::optional<std::size_t> chunk,
+                        std::vector<GLsizei>& counts,
+                        std::vector<std::size_t>& firstIndices) const;
+  [[nodiscard]] bool readCache(const std::string& cachePath,
+                               std::string_view sourcePath, bool processed);
+  void writeCache(const std::string& cachePath, std::string_view sourcePath,
+                  const std::vector<std::string>& materialFiles,
+                  bool processed) const;
+};
+
+#endif
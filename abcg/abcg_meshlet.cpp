@@ -0,0 +1,277 @@
+/**
+ * @file abcg_meshlet.cpp
+ * @brief Definition of the meshlet building function.
+ *
+ * The normal cone test follows Shirman and Abi-Ezzi, "The Cone of Normals
+ * Technique for Fast Processing of Curved Patches", Eurographics 1993.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_meshlet.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cppitertools/itertools.hpp>
+#include <glm/geometric.hpp>
+#include <limits>
+#include <numeric>
+#include <tuple>
+
+namespace {
+constexpr auto noMeshlet{std::numeric_limits<std::size_t>::max()};
+
+// Weight of the angle to the average normal of a meshlet when choosing its
+// next triangle, relative to the distance to its center in units of its
+// radius. Flatter meshlets have narrower normal cones and are culled more
+// often when facing away
+constexpr float coneWeight{3.0f};
+
+// Smallest cosine of the cone angle for the back-facing test to be useful
+constexpr float minConeCosine{0.1f};
+
+// Triangles that use each vertex, in compressed rows
+struct Adjacency {
+  std::vector<std::size_t> offsets;
+  std::vector<std::size_t> triangles;
+};
+
+Adjacency buildAdjacency(const std::vector<GLuint>& indices,
+                         std::size_t numVertices) {
+  Adjacency adjacency;
+  adjacency.offsets.assign(numVertices + 1, 0);
+  for (const auto index : indices) {
+    ++adjacency.offsets.at(index + 1);
+  }
+  std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(),
+                   adjacency.offsets.begin());
+
+  adjacency.triangles.resize(indices.size());
+  auto next{adjacency.offsets};
+  for (auto&& [corner, index] : iter::enumerate(indices)) {
+    adjacency.triangles.at(next.at(index)++) = corner / 3;
+  }
+  return adjacency;
+}
+
+// Indices remapped to the first vertex with the same position, so that
+// triangles on both sides of an attribute seam are adjacent
+std::vector<GLuint> weldPositions(const std::vector<GLuint>& indices,
+                                  const std::vector<abcg::Vertex>& vertices) {
+  std::vector<GLuint> order(vertices.size());
+  std::iota(order.begin(), order.end(), 0);
+  auto less{[&vertices](GLuint a, GLuint b) {
+    const auto& pa{vertices.at(a).position};
+    const auto& pb{vertices.at(b).position};
+    return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+  }};
+  std::sort(order.begin(), order.end(), less);
+
+  std::vector<GLuint> remap(vertices.size());
+  for (auto first{order.begin()}; first != order.end();) {
+    const auto last{std::upper_bound(first, order.end(), *first, less)};
+    for (auto it{first}; it != last; ++it) remap.at(*it) = *first;
+    first = last;
+  }
+
+  std::vector<GLuint> welded(indices.size());
+  std::transform(indices.begin(), indices.end(), welded.begin(),
+                 [&remap](GLuint index) { return remap.at(index); });
+  return welded;
+}
+
+// Bounding sphere and normal cone of the triangles of a meshlet
+void computeBounds(abcg::Meshlet& meshlet, const std::vector<GLuint>& indices,
+                   const std::vector<abcg::Vertex>& vertices,
+                   const std::vector<glm::vec3>& normals,
+                   const std::vector<std::size_t>& triangles) {
+  glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+  glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+  glm::vec3 normalSum{};
+  for (const auto triangle : triangles) {
+    for (const auto k : iter::range<std::size_t>(3)) {
+      const auto& position{vertices.at(indices.at(triangle * 3 + k)).position};
+      boundsMin = glm::min(boundsMin, position);
+      boundsMax = glm::max(boundsMax, position);
+    }
+    normalSum += normals.at(triangle);
+  }
+
+  meshlet.center = (boundsMin + boundsMax) / 2.0f;
+  meshlet.radius = 0.0f;
+  for (const auto triangle : triangles) {
+    for (const auto k : iter::range<std::size_t>(3)) {
+      const auto& position{vertices.at(indices.at(triangle * 3 + k)).position};
+      meshlet.radius =
+          std::max(meshlet.radius, glm::distance(meshlet.center, position));
+    }
+  }
+
+  meshlet.coneCutoff = 1.0f;
+  const auto normalLength{glm::length(normalSum)};
+  if (normalLength <= 0.0f) return;
+  meshlet.coneAxis = normalSum / normalLength;
+
+  auto minCosine{1.0f};
+  for (const auto triangle : triangles) {
+    const auto& normal{normals.at(triangle)};
+    if (normal != glm::vec3{}) {
+      minCosine = std::min(minCosine, glm::dot(normal, meshlet.coneAxis));
+    }
+  }
+
+  // All triangles face away if the view direction is within 90 degrees
+  // minus the cone angle of the axis
+  if (minCosine >= minConeCosine) {
+    meshlet.coneCutoff = std::sqrt(1.0f - minCosine * minCosine);
+  }
+}
+}  // namespace
+
+/**
+ * @brief Splits a triangle list in meshlets and computes their culling
+ * data.
+ *
+ * Each meshlet is grown from a seed triangle by adding the adjacent
+ * triangle that adds the fewest new vertices, stays closest to its center
+ * and deviates least from its average normal. Seeds are taken from the
+ * triangles left adjacent to the previous meshlet, so consecutive meshlets
+ * share vertices in the post-transform cache. Meshlets may have fewer
+ * triangles than the maximum where the mesh is not connected.
+ *
+ * @param indices Indices of a triangle list, reordered in place so that
+ * each meshlet is a contiguous range.
+ * @param vertices Vertices referenced by the indices.
+ * @param maxTriangles Maximum number of triangles of a meshlet.
+ *
+ * @return Meshlets in index order. Their first indices are relative to the
+ * start of indices.
+ */
+std::vector<abcg::Meshlet> abcg::buildMeshlets(
+    std::vector<GLuint>& indices, const std::vector<Vertex>& vertices,
+    std::size_t maxTriangles) {
+  const auto numTriangles{indices.size() / 3};
+  const auto welded{weldPositions(indices, vertices)};
+  const auto adjacency{buildAdjacency(welded, vertices.size())};
+  maxTriangles = std::max<std::size_t>(maxTriangles, 1);
+
+  // Unit face normals, zero for degenerate triangles, and centroids
+  std::vector<glm::vec3> normals(numTriangles);
+  std::vector<glm::vec3> centroids(numTriangles);
+  for (const auto triangle : iter::range(numTriangles)) {
+    const auto& a{vertices.at(indices.at(triangle * 3 + 0)).position};
+    const auto& b{vertices.at(indices.at(triangle * 3 + 1)).position};
+    const auto& c{vertices.at(indices.at(triangle * 3 + 2)).position};
+    const auto normal{glm::cross(b - a, c - a)};
+    const auto length{glm::length(normal)};
+    if (length > 0.0f) normals.at(triangle) = normal / length;
+    centroids.at(triangle) = (a + b + c) / 3.0f;
+  }
+
+  std::vector<bool> emitted(numTriangles, false);
+  // Meshlet that last added each triangle to its candidates or used each
+  // vertex
+  std::vector<std::size_t> candidateOf(numTriangles, noMeshlet);
+  std::vector<std::size_t> vertexOf(vertices.size(), noMeshlet);
+
+  std::vector<GLuint> reordered;
+  reordered.reserve(indices.size());
+  std::vector<Meshlet> meshlets;
+  std::vector<std::size_t> candidates;
+  std::vector<std::size_t> triangles;
+  std::size_t nextSeed{};
+
+  while (reordered.size() < numTriangles * 3) {
+    const auto meshletIndex{meshlets.size()};
+
+    // Seed with a triangle adjacent to the previous meshlet if possible
+    auto seed{nextSeed};
+    const auto leftover{std::find_if(
+        candidates.begin(), candidates.end(),
+        [&emitted](std::size_t triangle) { return !emitted.at(triangle); })};
+    if (leftover != candidates.end()) {
+      seed = *leftover;
+    } else {
+      while (emitted.at(nextSeed)) ++nextSeed;
+      seed = nextSeed;
+    }
+    candidates.clear();
+    triangles.clear();
+
+    glm::vec3 centroidSum{};
+    glm::vec3 normalSum{};
+    auto radius{0.0f};
+    auto addTriangle{[&](std::size_t triangle) {
+      emitted.at(triangle) = true;
+      triangles.push_back(triangle);
+      centroidSum += centroids.at(triangle);
+      normalSum += normals.at(triangle);
+      const auto center{centroidSum / static_cast<float>(triangles.size())};
+      for (const auto k : iter::range<std::size_t>(3)) {
+        const auto vertex{indices.at(triangle * 3 + k)};
+        reordered.push_back(vertex);
+        vertexOf.at(vertex) = meshletIndex;
+        const auto& position{vertices.at(vertex).position};
+        radius = std::max(radius, glm::distance(center, position));
+        const auto weldedVertex{welded.at(triangle * 3 + k)};
+        const auto begin{adjacency.offsets.at(weldedVertex)};
+        const auto end{adjacency.offsets.at(weldedVertex + 1)};
+        for (const auto offset : iter::range(begin, end)) {
+          const auto neighbor{adjacency.triangles.at(offset)};
+          if (!emitted.at(neighbor) &&
+              candidateOf.at(neighbor) != meshletIndex) {
+            candidateOf.at(neighbor) = meshletIndex;
+            candidates.push_back(neighbor);
+          }
+        }
+      }
+    }};
+
+    addTriangle(seed);
+    while (triangles.size() < maxTriangles) {
+      const auto center{centroidSum / static_cast<float>(triangles.size())};
+      const auto normalLength{glm::length(normalSum)};
+      const auto axis{normalLength > 0.0f ? normalSum / normalLength
+                                          : glm::vec3{}};
+
+      // Drop emitted candidates while looking for the cheapest one
+      auto best{noMeshlet};
+      auto bestCost{std::numeric_limits<float>::max()};
+      std::erase_if(candidates, [&](std::size_t triangle) {
+        if (emitted.at(triangle)) return true;
+        auto newVertices{0};
+        for (const auto k : iter::range<std::size_t>(3)) {
+          if (vertexOf.at(indices.at(triangle * 3 + k)) != meshletIndex) {
+            ++newVertices;
+          }
+        }
+        const auto cost{
+            static_cast<float>(newVertices) +
+            glm::distance(center, centroids.at(triangle)) /
+                std::max(radius, std::numeric_limits<float>::min()) +
+            coneWeight * (1.0f - glm::dot(normals.at(triangle), axis))};
+        if (cost < bestCost) {
+          bestCost = cost;
+          best = triangle;
+        }
+        return false;
+      });
+      if (best == noMeshlet) break;
+
+      addTriangle(best);
+    }
+
+    Meshlet meshlet{.firstIndex = reordered.size() - triangles.size() * 3,
+                    .indexCount = triangles.size() * 3,
+                    .center = {},
+                    .radius = {},
+                    .coneAxis = {},
+                    .coneCutoff = 1.0f,
+                    .chunk = 0};
+    computeBounds(meshlet, indices, vertices, normals, triangles);
+    meshlets.push_back(meshlet);
+  }
+
+  indices = std::move(reordered);
+  return meshlets;
+}
@@ -0,0 +1,23 @@
+/**
+ * @file abcg_meshlet.hpp
+ * @brief Declaration of the meshlet building function.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_MESHLET_HPP_
+#define ABCG_MESHLET_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include "abcg_external.hpp"
+#include "abcg_mesh.hpp"
+
+namespace abcg {
+[[nodiscard]] std::vector<Meshlet> buildMeshlets(
+    std::vector<GLuint>& indices, const std::vector<Vertex>& vertices,
+    std::size_t maxTriangles = 64);
+}  // namespace abcg
+
+#endif
@@ -0,0 +1,362 @@
+/**
+ * @file abcg_meshoptimizer.cpp
+ * @brief Definition of index and vertex buffer optimization functions.
+ *
+ * Triangle reordering for the vertex cache and the overdraw cluster sort
+ * follow Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex
+ * Locality and Reduced Overdraw", SIGGRAPH 2007.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_meshoptimizer.hpp"
+
+#include <algorithm>
+#include <cppitertools/itertools.hpp>
+#include <cstdint>
+#include <glm/geometric.hpp>
+#include <limits>
+#include <numeric>
+
+namespace {
+constexpr auto noVertex{std::numeric_limits<GLuint>::max()};
+
+// Simulation of a FIFO post-transform vertex cache
+class VertexCache {
+ public:
+  VertexCache(std::size_t numVertices, int cacheSize)
+      : m_entryTime(numVertices, 0), m_cacheSize{cacheSize},
+        m_time{cacheSize + 1} {}
+
+  // Returns true on a cache miss
+  bool access(GLuint vertex) {
+    auto& entryTime{m_entryTime.at(vertex)};
+    if (m_time - entryTime <= m_cacheSize) return false;
+    entryTime = m_time++;
+    return true;
+  }
+
+  void flush() { m_time += m_cacheSize + 1; }
+
+ private:
+  std::vector<std::int64_t> m_entryTime;
+  std::int64_t m_cacheSize{};
+  std::int64_t m_time{};
+};
+
+// Triangles that use each vertex, in compressed rows
+struct Adjacency {
+  std::vector<std::size_t> offsets;
+  std::vector<std::size_t> triangles;
+};
+
+Adjacency buildAdjacency(const std::vector<GLuint>& indices,
+                         std::size_t numVertices) {
+  Adjacency adjacency;
+  adjacency.offsets.assign(numVertices + 1, 0);
+  for (const auto index : indices) {
+    ++adjacency.offsets.at(index + 1);
+  }
+  std::partial_sum(adjacency.offsets.begin(), adjacency.offsets.end(),
+                   adjacency.offsets.begin());
+
+  adjacency.triangles.resize(indices.size());
+  auto next{adjacency.offsets};
+  for (auto&& [corner, index] : iter::enumerate(indices)) {
+    adjacency.triangles.at(next.at(index)++) = corner / 3;
+  }
+  return adjacency;
+}
+
+// First index of each cluster of triangles that can be drawn in any order
+// without losing much cache efficiency. A cluster starts where the cache
+// misses all vertices of a triangle and where the ACMR accumulated since
+// the cluster start gets below threshold times the ACMR of the enclosing
+// hard cluster
+std::vector<std::size_t> findClusters(const std::vector<GLuint>& indices,
+                                      std::size_t numVertices, int cacheSize,
+                                      float threshold) {
+  const auto numTriangles{indices.size() / 3};
+
+  // Hard boundaries
+  std::vector<std::size_t> hardClusters;
+  std::vector<int> misses(numTriangles);
+  VertexCache cache{numVertices, cacheSize};
+  for (auto triangle : iter::range(numTriangles)) {
+    for (auto k : iter::range<std::size_t>(3)) {
+      misses.at(triangle) += cache.access(indices.at(triangle * 3 + k)) ? 1 : 0;
+    }
+    if (triangle == 0 || misses.at(triangle) == 3) {
+      hardClusters.push_back(triangle);
+    }
+  }
+  hardClusters.push_back(numTriangles);
+
+  // Soft boundaries
+  std::vector<std::size_t> clusters;
+  for (auto cluster : iter::range(hardClusters.size() - 1)) {
+    const auto begin{hardClusters.at(cluster)};
+    const auto end{hardClusters.at(cluster + 1)};
+
+    const auto clusterMisses{std::accumulate(
+        misses.begin() + static_cast<std::ptrdiff_t>(begin),
+        misses.begin() + static_cast<std::ptrdiff_t>(end), 0)};
+    const auto maxAcmr{threshold * static_cast<float>(clusterMisses) /
+                       static_cast<float>(end - begin)};
+
+    cache.flush();
+    clusters.push_back(begin);
+    auto start{begin};
+    auto softMisses{0};
+    for (auto triangle : iter::range(begin, end)) {
+      for (auto k : iter::range<std::size_t>(3)) {
+        softMisses += cache.access(indices.at(triangle * 3 + k)) ? 1 : 0;
+      }
+      const auto acmr{static_cast<float>(softMisses) /
+                      static_cast<float>(triangle + 1 - start)};
+      if (triangle + 1 < end && acmr <= maxAcmr) {
+        cache.flush();
+        start = triangle + 1;
+        softMisses = 0;
+        clusters.push_back(start);
+      }
+    }
+  }
+  clusters.push_back(numTriangles);
+
+  return clusters;
+}
+}  // namespace
+
+/**
+ * @brief Reorders triangles for the post-transform vertex cache.
+ *
+ * Uses the Tipsify algorithm, which emits the triangles around a fanning
+ * vertex and picks as the next fanning vertex a recently used one that is
+ * still expected to be in the cache.
+ *
+ * @param indices Indices of a triangle list, reordered in place.
+ * @param numVertices Number of vertices referenced by the indices.
+ * @param cacheSize Number of entries of the target vertex cache.
+ */
+void abcg::optimizeVertexCache(std::vector<GLuint>& indices,
+                               std::size_t numVertices, int cacheSize) {
+  const auto numTriangles{indices.size() / 3};
+  if (numTriangles == 0) return;
+
+  const auto adjacency{buildAdjacency(indices, numVertices)};
+
+  // Number of triangles not yet emitted around each vertex
+  std::vector<int> liveTriangles(numVertices);
+  for (auto vertex : iter::range(numVertices)) {
+    liveTriangles.at(vertex) =
+        static_cast<int>(adjacency.offsets.at(vertex + 1) -
+                         adjacency.offsets.at(vertex));
+  }
+
+  // Time each vertex last entered the cache
+  std::vector<int> cacheTime(numVertices, 0);
+  auto time{cacheSize + 1};
+
+  std::vector<bool> emitted(numTriangles, false);
+  std::vector<GLuint> deadEndStack;
+  std::vector<GLuint> candidates;
+  std::vector<GLuint> output;
+  output.reserve(indices.size());
+  std::size_t cursor{0};
+
+  auto fanningVertex{indices.front()};
+  while (fanningVertex != noVertex) {
+    // Emit the remaining triangles around the fanning vertex
+    candidates.clear();
+    for (auto adjacent : iter::range(adjacency.offsets.at(fanningVertex),
+                                     adjacency.offsets.at(fanningVertex + 1))) {
+      const auto triangle{adjacency.triangles.at(adjacent)};
+      if (emitted.at(triangle)) continue;
+      for (auto k : iter::range<std::size_t>(3)) {
+        const auto vertex{indices.at(triangle * 3 + k)};
+        output.push_back(vertex);
+        deadEndStack.push_back(vertex);
+        candidates.push_back(vertex);
+        --liveTriangles.at(vertex);
+        if (time - cacheTime.at(vertex) > cacheSize) {
+          cacheTime.at(vertex) = time++;
+        }
+      }
+      emitted.at(triangle) = true;
+    }
+
+    // Prefer the candidate that entered the cache first among those that
+    // will still be in the cache after their remaining triangles are
+    // emitted
+    fanningVertex = noVertex;
+    auto bestPriority{-1};
+    for (const auto vertex : candidates) {
+      if (liveTriangles.at(vertex) <= 0) continue;
+      auto priority{0};
+      if (time - cacheTime.at(vertex) + 2 * liveTriangles.at(vertex) <=
+          cacheSize) {
+        priority = time - cacheTime.at(vertex);
+      }
+      if (priority > bestPriority) {
+        bestPriority = priority;
+        fanningVertex = vertex;
+      }
+    }
+
+    // Dead end: resume from a recently used vertex, or else from the next
+    // vertex in index order with triangles left
+    while (fanningVertex == noVertex && !deadEndStack.empty()) {
+      const auto vertex{deadEndStack.back()};
+      deadEndStack.pop_back();
+      if (liveTriangles.at(vertex) > 0) fanningVertex = vertex;
+    }
+    for (; fanningVertex == noVertex && cursor < numVertices; ++cursor) {
+      if (liveTriangles.at(cursor) > 0) {
+        fanningVertex = static_cast<GLuint>(cursor);
+      }
+    }
+  }
+
+  indices = std::move(output);
+}
+
+/**
+ * @brief Reorders clusters of triangles to reduce overdraw.
+ *
+ * The triangles are split into clusters that keep most of the vertex
+ * cache efficiency of the current order. Clusters facing away from the
+ * center of the mesh are drawn first, as they are more likely to occlude
+ * the others. Should be called after optimizeVertexCache().
+ *
+ * @param indices Indices of a triangle list, reordered in place.
+ * @param vertices Vertices referenced by the indices.
+ * @param cacheSize Number of entries of the target vertex cache.
+ * @param threshold Maximum increase of the ACMR of each cluster. Larger
+ * values produce smaller clusters.
+ */
+void abcg::optimizeOverdraw(std::vector<GLuint>& indices,
+                            const std::vector<Vertex>& vertices, int cacheSize,
+                            float threshold) {
+  const auto numTriangles{indices.size() / 3};
+  if (numTriangles == 0) return;
+
+  const auto clusters{
+      findClusters(indices, vertices.size(), cacheSize, threshold)};
+  const auto numClusters{clusters.size() - 1};
+
+  // Area-weighted centroid and normal of each cluster
+  std::vector<glm::vec3> centroids(numClusters);
+  std::vector<glm::vec3> normals(numClusters);
+  std::vector<float> areas(numClusters);
+  glm::vec3 meshCentroid{};
+  auto meshArea{0.0f};
+  for (auto cluster : iter::range(numClusters)) {
+    for (auto triangle :
+         iter::range(clusters.at(cluster), clusters.at(cluster + 1))) {
+      const auto& a{vertices.at(indices.at(triangle * 3 + 0)).position};
+      const auto& b{vertices.at(indices.at(triangle * 3 + 1)).position};
+      const auto& c{vertices.at(indices.at(triangle * 3 + 2)).position};
+      const auto normal{glm::cross(b - a, c - a)};
+      const auto area{glm::length(normal)};
+      centroids.at(cluster) += (a + b + c) * (area / 3.0f);
+      normals.at(cluster) += normal;
+      areas.at(cluster) += area;
+    }
+    meshCentroid += centroids.at(cluster);
+    meshArea += areas.at(cluster);
+  }
+  if (meshArea > 0.0f) meshCentroid /= meshArea;
+
+  std::vector<float> sortKeys(numClusters);
+  for (auto cluster : iter::range(numClusters)) {
+    if (areas.at(cluster) <= 0.0f) continue;
+    const auto centroid{centroids.at(cluster) / areas.at(cluster)};
+    sortKeys.at(cluster) = glm::dot(centroid - meshCentroid,
+                                    glm::normalize(normals.at(cluster)));
+  }
+
+  std::vector<std::size_t> order(numClusters);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](auto lhs, auto rhs) {
+    return sortKeys.at(lhs) > sortKeys.at(rhs);
+  });
+
+  std::vector<GLuint> output;
+  output.reserve(indices.size());
+  for (const auto cluster : order) {
+    output.insert(
+        output.end(),
+        indices.begin() + static_cast<std::ptrdiff_t>(clusters.at(cluster) * 3),
+        indices.begin() +
+            static_cast<std::ptrdiff_t>(clusters.at(cluster + 1) * 3));
+  }
+  indices = std::move(output);
+}
+
+/**
+ * @brief Renumbers vertices in the order they are first used.
+ *
+ * Makes vertex fetches follow the index buffer order. Vertices not used by
+ * any index are moved to the end.
+ *
+ * @param indices Indices, renumbered in place.
+ * @param vertices Vertices, reordered in place.
+ */
+void abcg::optimizeVertexFetch(std::vector<GLuint>& indices,
+                               std::vector<Vertex>& vertices) {
+  std::vector<GLuint> remap(vertices.size(), noVertex);
+  std::vector<Vertex> reordered;
+  reordered.reserve(vertices.size());
+
+  for (auto& index : indices) {
+    auto& newIndex{remap.at(index)};
+    if (newIndex == noVertex) {
+      newIndex = static_cast<GLuint>(reordered.size());
+      reordered.push_back(vertices.at(index));
+    }
+    index = newIndex;
+  }
+
+  for (auto&& [vertex, newIndex] : iter::zip(vertices, remap)) {
+    if (newIndex == noVertex) reordered.push_back(vertex);
+  }
+
+  vertices = std::move(reordered);
+}
+
+/**
+ * @brief Measures the vertex cache efficiency of a triangle list.
+ *
+ * @param indices Indices of a triangle list.
+ * @param numVertices Number of vertices referenced by the indices.
+ * @param cacheSize Number of entries of the simulated FIFO cache.
+ *
+ * @return ACMR and ATVR of the index order.
+ */
+abcg::VertexCacheStatistics abcg::analyzeVertexCache(
+    const std::vector<GLuint>& indices, std::size_t numVertices,
+    int cacheSize) {
+  VertexCache cache{numVertices, cacheSize};
+  std::vector<bool> used(numVertices, false);
+  std::size_t misses{};
+  std::size_t usedVertices{};
+  for (const auto index : indices) {
+    if (cache.access(index)) ++misses;
+    if (!used.at(index)) {
+      used.at(index) = true;
+      ++usedVertices;
+    }
+  }
+
+  VertexCacheStatistics statistics;
+  if (indices.size() >= 3) {
+    statistics.acmr = static_cast<float>(misses) /
+                      static_cast<float>(indices.size() / 3);
+  }
+  if (usedVertices > 0) {
+    statistics.atvr =
+        static_cast<float>(misses) / static_cast<float>(usedVertices);
+  }
+  return statistics;
+}
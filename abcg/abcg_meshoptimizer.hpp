@@ -0,0 +1,30 @@
+/**
+ * @file abcg_meshoptimizer.hpp
+ * @brief Declaration of index and vertex buffer optimization functions.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_MESHOPTIMIZER_HPP_
+#define ABCG_MESHOPTIMIZER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include "abcg_external.hpp"
+#include "abcg_mesh.hpp"
+
+namespace abcg {
+void optimizeVertexCache(std::vector<GLuint>& indices, std::size_t numVertices,
+                         int cacheSize = 16);
+void optimizeOverdraw(std::vector<GLuint>& indices,
+                      const std::vector<Vertex>& vertices, int cacheSize = 16,
+                      float threshold = 1.05f);
+void optimizeVertexFetch(std::vector<GLuint>& indices,
+                         std::vector<Vertex>& vertices);
+[[nodiscard]] VertexCacheStatistics analyzeVertexCache(
+    const std::vector<GLuint>& indices, std::size_t numVertices,
+    int cacheSize = 16);
+}  // namespace abcg
+
+#endif
@@ -0,0 +1,376 @@
+/**
+ * @file abcg_meshsimplifier.cpp
+ * @brief Definition of the triangle mesh simplification function.
+ *
+ * Edge collapses are ordered by the quadric error metric extended to vertex
+ * attributes of Garland and Heckbert, "Simplifying Surfaces with Color and
+ * Texture using Quadric Error Metrics", IEEE Visualization 1998.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_meshsimplifier.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cppitertools/itertools.hpp>
+#include <cstdint>
+#include <functional>
+#include <glm/geometric.hpp>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <tuple>
+#include <unordered_map>
+
+namespace {
+constexpr auto noVertex{std::numeric_limits<GLuint>::max()};
+
+// Position, normal and texture coordinates
+constexpr std::size_t attributeCount{8};
+
+// Weights of the normal and texture coordinates relative to positions
+// scaled to a unit bounding box diagonal. A normal deviation of 0.2 or a
+// texture coordinate deviation of 0.02 costs about as much as moving the
+// surface by 1% of the diagonal
+constexpr double normalWeight{0.05};
+constexpr double texCoordWeight{0.5};
+
+// Smallest cosine of the angle between the normals of a triangle before
+// and after a collapse
+constexpr float minNormalCosine{0.25f};
+
+using Point = std::array<double, attributeCount>;
+
+double dot(const Point& a, const Point& b) {
+  return std::inner_product(a.begin(), a.end(), b.begin(), 0.0);
+}
+
+// Q(x) = x^T A x + 2 b^T x + c, with the symmetric matrix A stored as its
+// upper triangle
+struct Quadric {
+  std::array<double, attributeCount*(attributeCount + 1) / 2> A{};
+  Point b{};
+  double c{};
+
+  Quadric& operator+=(const Quadric& other) {
+    std::transform(A.begin(), A.end(), other.A.begin(), A.begin(),
+                   std::plus<>{});
+    std::transform(b.begin(), b.end(), other.b.begin(), b.begin(),
+                   std::plus<>{});
+    c += other.c;
+    return *this;
+  }
+
+  [[nodiscard]] double evaluate(const Point& x) const {
+    auto result{c + 2.0 * dot(b, x)};
+    std::size_t k{};
+    for (const auto i : iter::range(attributeCount)) {
+      result += A.at(k++) * x.at(i) * x.at(i);
+      for (const auto j : iter::range(i + 1, attributeCount)) {
+        result += 2.0 * A.at(k++) * x.at(i) * x.at(j);
+      }
+    }
+    return result;
+  }
+};
+
+// Quadric of the squared distance to the plane through p, q and r in
+// attribute space, scaled by weight
+Quadric makeQuadric(const Point& p, const Point& q, const Point& r,
+                    double weight) {
+  // Orthonormal basis of the plane
+  Point e1{};
+  Point e2{};
+  for (const auto i : iter::range(attributeCount)) {
+    e1.at(i) = q.at(i) - p.at(i);
+    e2.at(i) = r.at(i) - p.at(i);
+  }
+  const auto length1{std::sqrt(dot(e1, e1))};
+  if (length1 == 0.0) return {};
+  for (auto& value : e1) value /= length1;
+  const auto projection{dot(e2, e1)};
+  for (const auto i : iter::range(attributeCount)) {
+    e2.at(i) -= projection * e1.at(i);
+  }
+  const auto length2{std::sqrt(dot(e2, e2))};
+  if (length2 == 0.0) return {};
+  for (auto& value : e2) value /= length2;
+
+  // A = I - e1 e1^T - e2 e2^T
+  // b = (p.e1) e1 + (p.e2) e2 - p
+  // c = p.p - (p.e1)^2 - (p.e2)^2
+  const auto pe1{dot(p, e1)};
+  const auto pe2{dot(p, e2)};
+  Quadric quadric;
+  std::size_t k{};
+  for (const auto i : iter::range(attributeCount)) {
+    for (const auto j : iter::range(i, attributeCount)) {
+      const auto identity{i == j ? 1.0 : 0.0};
+      quadric.A.at(k++) =
+          weight * (identity - e1.at(i) * e1.at(j) - e2.at(i) * e2.at(j));
+    }
+    quadric.b.at(i) = weight * (pe1 * e1.at(i) + pe2 * e2.at(i) - p.at(i));
+  }
+  quadric.c = weight * (dot(p, p) - pe1 * pe1 - pe2 * pe2);
+  return quadric;
+}
+
+// Vertices that can't be removed: those on borders or non-manifold edges
+// and those sharing their position with other vertices (attribute seams).
+// Locking borders also keeps the submeshes of a mesh stitched together
+// when they are simplified separately
+std::vector<bool> findLockedVertices(
+    const std::vector<GLuint>& indices,
+    const std::vector<abcg::Vertex>& vertices) {
+  // Map each used vertex to the first used vertex with the same position
+  std::vector<bool> used(vertices.size(), false);
+  for (const auto index : indices) used.at(index) = true;
+
+  std::vector<GLuint> order;
+  for (const auto index : iter::range(vertices.size())) {
+    if (used.at(index)) order.push_back(static_cast<GLuint>(index));
+  }
+  auto less{[&vertices](GLuint a, GLuint b) {
+    const auto& pa{vertices.at(a).position};
+    const auto& pb{vertices.at(b).position};
+    return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+  }};
+  std::sort(order.begin(), order.end(), less);
+
+  std::vector<GLuint> remap(vertices.size(), noVertex);
+  std::vector<int> wedgeCount(vertices.size(), 0);
+  for (auto first{order.begin()}; first != order.end();) {
+    const auto last{std::upper_bound(first, order.end(), *first, less)};
+    for (auto it{first}; it != last; ++it) remap.at(*it) = *first;
+    wedgeCount.at(*first) = static_cast<int>(std::distance(first, last));
+    first = last;
+  }
+
+  // An edge is interior if it is used once in each direction
+  std::unordered_map<std::uint64_t, int> edgeCount;
+  auto edgeKey{[](GLuint a, GLuint b) {
+    return (static_cast<std::uint64_t>(a) << 32U) | b;
+  }};
+  for (const auto offset : iter::range<std::size_t>(0, indices.size(), 3)) {
+    for (const auto k : iter::range<std::size_t>(3)) {
+      const auto a{remap.at(indices.at(offset + k))};
+      const auto b{remap.at(indices.at(offset + (k + 1) % 3))};
+      ++edgeCount[edgeKey(a, b)];
+    }
+  }
+
+  std::vector<bool> lockedPosition(vertices.size(), false);
+  for (const auto& [key, count] : edgeCount) {
+    const auto a{static_cast<GLuint>(key >> 32U)};
+    const auto b{static_cast<GLuint>(key & 0xFFFFFFFFU)};
+    const auto opposite{edgeCount.find(edgeKey(b, a))};
+    if (count != 1 || opposite == edgeCount.end() || opposite->second != 1) {
+      lockedPosition.at(a) = true;
+      lockedPosition.at(b) = true;
+    }
+  }
+
+  std::vector<bool> locked(vertices.size(), true);
+  for (const auto index : order) {
+    const auto position{remap.at(index)};
+    locked.at(index) =
+        lockedPosition.at(position) || wedgeCount.at(position) > 1;
+  }
+  return locked;
+}
+
+struct Collapse {
+  GLuint from{noVertex};
+  GLuint to{noVertex};
+  double cost{std::numeric_limits<double>::max()};
+};
+}  // namespace
+
+/**
+ * @brief Reduces the number of triangles of an indexed triangle mesh.
+ *
+ * Vertices are collapsed onto neighboring vertices in order of increasing
+ * quadric error, measured on positions, normals and texture coordinates.
+ * The vertex buffer is left unchanged, so the result can share it with the
+ * original indices. Vertices on borders and attribute seams are kept.
+ *
+ * @param indices Triangle list, replaced with the simplified triangles.
+ * @param vertices Vertex buffer.
+ * @param targetIndexCount Number of indices to stop at.
+ * @param targetError Largest error allowed for a collapse, relative to the
+ * diagonal of the bounding box of the vertices.
+ *
+ * @return Largest error of the collapses done, relative to the diagonal of
+ * the bounding box of the vertices.
+ */
+float abcg::simplifyMesh(std::vector<GLuint>& indices,
+                         const std::vector<Vertex>& vertices,
+                         std::size_t targetIndexCount, float targetError) {
+  if (indices.size() <= targetIndexCount) return 0.0f;
+
+  // Scale positions to a unit bounding box diagonal
+  glm::vec3 boundsMin{std::numeric_limits<float>::max()};
+  glm::vec3 boundsMax{std::numeric_limits<float>::lowest()};
+  for (const auto& vertex : vertices) {
+    boundsMin = glm::min(boundsMin, vertex.position);
+    boundsMax = glm::max(boundsMax, vertex.position);
+  }
+  const auto diagonal{glm::length(boundsMax - boundsMin)};
+  const auto scale{diagonal > 0.0f ? 1.0 / static_cast<double>(diagonal)
+                                   : 1.0};
+
+  std::vector<Point> points(vertices.size());
+  for (auto&& [point, vertex] : iter::zip(points, vertices)) {
+    const glm::dvec3 position{vertex.position - boundsMin};
+    const glm::dvec3 normal{vertex.normal};
+    const glm::dvec2 texCoord{vertex.texCoord};
+    point = {position.x * scale,
+             position.y * scale,
+             position.z * scale,
+             normal.x * normalWeight,
+             normal.y * normalWeight,
+             normal.z * normalWeight,
+             texCoord.x * texCoordWeight,
+             texCoord.y * texCoordWeight};
+  }
+
+  // Quadrics of the triangles around each vertex, weighted by area
+  std::vector<Quadric> quadrics(vertices.size());
+  for (const auto offset : iter::range<std::size_t>(0, indices.size(), 3)) {
+    const auto& p{points.at(indices.at(offset + 0))};
+    const auto& q{points.at(indices.at(offset + 1))};
+    const auto& r{points.at(indices.at(offset + 2))};
+    const glm::dvec3 pq{q.at(0) - p.at(0), q.at(1) - p.at(1),
+                        q.at(2) - p.at(2)};
+    const glm::dvec3 pr{r.at(0) - p.at(0), r.at(1) - p.at(1),
+                        r.at(2) - p.at(2)};
+    const auto area{0.5 * glm::length(glm::cross(pq, pr))};
+    const auto quadric{makeQuadric(p, q, r, area)};
+    for (const auto k : iter::range<std::size_t>(3)) {
+      quadrics.at(indices.at(offset + k)) += quadric;
+    }
+  }
+
+  const auto locked{findLockedVertices(indices, vertices)};
+
+  // Each pass collapses the cheapest vertices whose neighborhoods don't
+  // overlap, then removes the triangles that became degenerate
+  const auto maxCost{static_cast<double>(targetError) *
+                     static_cast<double>(targetError)};
+  auto resultCost{0.0};
+  std::vector<GLuint> remap(vertices.size());
+  std::vector<bool> touched(vertices.size());
+  std::vector<std::size_t> offsets(vertices.size() + 1);
+  std::vector<std::size_t> triangles;
+  while (indices.size() > targetIndexCount) {
+    // Triangles that use each vertex, in compressed rows
+    std::fill(offsets.begin(), offsets.end(), 0);
+    for (const auto index : indices) ++offsets.at(index + 1);
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    triangles.resize(indices.size());
+    auto next{offsets};
+    for (auto&& [corner, index] : iter::enumerate(indices)) {
+      triangles.at(next.at(index)++) = corner / 3;
+    }
+
+    // Cheapest collapse of each vertex along its edges
+    std::vector<Collapse> bestCollapse(vertices.size());
+    for (const auto offset : iter::range<std::size_t>(0, indices.size(), 3)) {
+      for (const auto k : iter::range<std::size_t>(3)) {
+        const auto a{indices.at(offset + k)};
+        const auto b{indices.at(offset + (k + 1) % 3)};
+        for (const auto& [from, to] : {std::pair{a, b}, std::pair{b, a}}) {
+          if (locked.at(from)) continue;
+          const auto cost{quadrics.at(from).evaluate(points.at(to))};
+          if (cost < bestCollapse.at(from).cost) {
+            bestCollapse.at(from) = {.from = from, .to = to, .cost = cost};
+          }
+        }
+      }
+    }
+    std::vector<Collapse> collapses;
+    std::copy_if(bestCollapse.begin(), bestCollapse.end(),
+                 std::back_inserter(collapses),
+                 [](const auto& collapse) { return collapse.to != noVertex; });
+    std::sort(collapses.begin(), collapses.end(),
+              [](const auto& a, const auto& b) { return a.cost < b.cost; });
+
+    // Collapsing an interior vertex removes two triangles
+    const auto goal{
+        std::max<std::size_t>((indices.size() - targetIndexCount) / 6, 1)};
+
+    // Returns true if replacing from with to turns a triangle over
+    auto flips{[&](const Collapse& collapse) {
+      for (const auto i : iter::range(offsets.at(collapse.from),
+                                      offsets.at(collapse.from + 1))) {
+        const auto offset{triangles.at(i) * 3};
+        std::array<glm::vec3, 3> before{};
+        std::array<glm::vec3, 3> after{};
+        auto degenerate{false};
+        for (const auto k : iter::range<std::size_t>(3)) {
+          const auto index{indices.at(offset + k)};
+          degenerate = degenerate || index == collapse.to;
+          before.at(k) = vertices.at(index).position;
+          after.at(k) =
+              vertices.at(index == collapse.from ? collapse.to : index)
+                  .position;
+        }
+        if (degenerate) continue;
+        const auto normalBefore{
+            glm::cross(before[1] - before[0], before[2] - before[0])};
+        const auto normalAfter{
+            glm::cross(after[1] - after[0], after[2] - after[0])};
+        if (glm::dot(normalBefore, normalAfter) <
+            minNormalCosine * glm::length(normalBefore) *
+                glm::length(normalAfter)) {
+          return true;
+        }
+      }
+      return false;
+    }};
+
+    std::iota(remap.begin(), remap.end(), 0);
+    std::fill(touched.begin(), touched.end(), false);
+    std::size_t done{};
+    for (const auto& collapse : collapses) {
+      if (collapse.cost > maxCost) break;
+      if (touched.at(collapse.from) || touched.at(collapse.to)) continue;
+      if (flips(collapse)) continue;
+
+      remap.at(collapse.from) = collapse.to;
+      quadrics.at(collapse.to) += quadrics.at(collapse.from);
+      resultCost = std::max(resultCost, collapse.cost);
+
+      // The neighborhood can't change again in this pass
+      for (const auto i : iter::range(offsets.at(collapse.from),
+                                      offsets.at(collapse.from + 1))) {
+        const auto offset{triangles.at(i) * 3};
+        for (const auto k : iter::range<std::size_t>(3)) {
+          touched.at(indices.at(offset + k)) = true;
+        }
+      }
+
+      if (++done >= goal) break;
+    }
+    if (done == 0) break;
+
+    // Apply the collapses and remove degenerate triangles
+    std::size_t size{};
+    for (const auto offset : iter::range<std::size_t>(0, indices.size(), 3)) {
+      const auto a{remap.at(indices.at(offset + 0))};
+      const auto b{remap.at(indices.at(offset + 1))};
+      const auto c{remap.at(indices.at(offset + 2))};
+      if (a == b || b == c || c == a) continue;
+      indices.at(size++) = a;
+      indices.at(size++) = b;
+      indices.at(size++) = c;
+    }
+    indices.resize(size);
+  }
+
+  return static_cast<float>(std::sqrt(std::max(resultCost, 0.0)));
+}
@@ -0,0 +1,24 @@
+/**
+ * @file abcg_meshsimplifier.hpp
+ * @brief Declaration of the triangle mesh simplification function.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_MESHSIMPLIFIER_HPP_
+#define ABCG_MESHSIMPLIFIER_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include "abcg_external.hpp"
+#include "abcg_mesh.hpp"
+
+namespace abcg {
+[[nodiscard]] float simplifyMesh(std::vector<GLuint>& indices,
+                                 const std::vector<Vertex>& vertices,
+                                 std::size_t targetIndexCount,
+                                 float targetError);
+}  // namespace abcg
+
+#endif
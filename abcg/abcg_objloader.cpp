@@ -0,0 +1,685 @@
+/**
+ * @file abcg_objloader.cpp
+ * @brief Definition of the Wavefront OBJ file reader.
+ *
+ * The file is split into chunks of whole lines that are parsed
+ * concurrently. The records of each chunk are then merged in file order
+ * using the number of records of the preceding chunks.
+ *
+ * Numbers are parsed and polygons are triangulated with the same
+ * arithmetic as tinyobj, so the results are bit-identical to
+ * tinyobj::ObjReader.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_objloader.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cppitertools/itertools.hpp>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <limits>
+#include <map>
+#include <thread>
+
+#include "abcg_exception.hpp"
+
+namespace {
+#if defined(__EMSCRIPTEN__)
+// No worker threads without pthreads: parse the chunks in sequence
+constexpr auto parseLaunchPolicy{std::launch::deferred};
+#else
+constexpr auto parseLaunchPolicy{std::launch::async};
+#endif
+
+// Smaller files are not worth splitting
+constexpr std::size_t minChunkSize{256 * 1024};
+
+// Indices of a face corner, zero-based. -1 if absent
+struct Corner {
+  int v{-1};
+  int vt{-1};
+  int vn{-1};
+};
+
+// Flags of the corner indices given relative to the end of the attribute
+// list. They are resolved once the attributes of the preceding chunks are
+// counted
+constexpr std::uint8_t relativeV{1};
+constexpr std::uint8_t relativeVT{2};
+constexpr std::uint8_t relativeVN{4};
+
+// mtllib or usemtl statement
+struct Statement {
+  bool isUseMtl{};
+  // Number of faces of the chunk read before the statement
+  std::size_t face{};
+  std::string argument;
+};
+
+// Records read from a range of whole lines
+struct Chunk {
+  std::string_view text;
+
+  std::vector<float> positions;
+  std::vector<float> normals;
+  std::vector<float> texCoords;
+  std::vector<Corner> corners;
+  std::vector<std::uint32_t> faceSizes;
+  std::vector<std::pair<std::size_t, std::uint8_t>> relativeCorners;
+  std::vector<Statement> statements;
+
+  std::size_t numLines{};
+  // Line of the first invalid face counted from the start of the chunk. 0
+  // if none
+  std::size_t errorLine{};
+
+  // Set after merging
+  std::vector<int> faceMaterialIDs;
+  std::vector<tinyobj::index_t> indices;
+  std::vector<int> materialIDs;
+  std::array<int, 3> greatestIndex{-1, -1, -1};
+};
+
+bool isSpace(char c) { return c == ' ' || c == '\t'; }
+bool isLineBreak(char c) { return c == '\n' || c == '\r'; }
+bool isNewLine(char c) { return isLineBreak(c) || c == '\0'; }
+bool isDigit(char c) { return static_cast<unsigned int>(c - '0') < 10U; }
+
+const char *skipSpaces(const char *token) {
+  while (isSpace(*token)) ++token;
+  return token;
+}
+
+const char *tokenEnd(const char *token) {
+  while (!isSpace(*token) && !isNewLine(*token)) ++token;
+  return token;
+}
+
+// Parses a decimal number in [s, end). Mantissa and exponent are
+// accumulated as in tinyobj's tryParseDouble. Returns false if s doesn't
+// start with a number
+bool parseDouble(const char *s, const char *end, double &result) {
+  if (s >= end) return false;
+
+  auto mantissa{0.0};
+  auto exponent{0};
+  auto negative{false};
+  auto leadingDot{false};
+  const auto *curr{s};
+
+  if (*curr == '+' || *curr == '-') {
+    negative = *curr == '-';
+    ++curr;
+    leadingDot = curr != end && *curr == '.';
+  } else if (*curr == '.') {
+    leadingDot = true;
+  } else if (!isDigit(*curr)) {
+    return false;
+  }
+
+  // Integer part
+  if (!leadingDot) {
+    auto read{0};
+    while (curr != end && isDigit(*curr)) {
+      mantissa = mantissa * 10 + (*curr - '0');
+      ++curr;
+      ++read;
+    }
+    if (read == 0) return false;
+  }
+
+  // Fractional part
+  if (curr != end && *curr == '.') {
+    static constexpr std::array powers{1.0,    0.1,     0.01,     0.001,
+                                       0.0001, 0.00001, 0.000001, 0.0000001};
+    ++curr;
+    std::size_t read{1};
+    while (curr != end && isDigit(*curr)) {
+      mantissa += (*curr - '0') *
+                  (read < powers.size()
+                       ? powers.at(read)
+                       : std::pow(10.0, -static_cast<double>(read)));
+      ++read;
+      ++curr;
+    }
+  }
+
+  // Exponent
+  if (curr != end && (*curr == 'e' || *curr == 'E')) {
+    ++curr;
+    auto negativeExponent{false};
+    if (curr != end && (*curr == '+' || *curr == '-')) {
+      negativeExponent = *curr == '-';
+      ++curr;
+    } else if (!isDigit(*curr)) {
+      return false;
+    }
+    auto read{0};
+    while (curr != end && isDigit(*curr)) {
+      exponent = exponent * 10 + (*curr - '0');
+      ++curr;
+      ++read;
+    }
+    if (read == 0) return false;
+    if (negativeExponent) exponent = -exponent;
+  }
+
+  result = (negative ? -1 : 1) *
+           (exponent != 0
+                ? std::ldexp(mantissa * std::pow(5.0, exponent), exponent)
+                : mantissa);
+  return true;
+}
+
+float parseFloat(const char *&token) {
+  token = skipSpaces(token);
+  const auto *end{tokenEnd(token)};
+  auto value{0.0};
+  parseDouble(token, end, value);
+  token = end;
+  return static_cast<float>(value);
+}
+
+// Parses an integer like atoi
+int parseInt(const char *token) {
+  auto negative{false};
+  if (*token == '+' || *token == '-') {
+    negative = *token == '-';
+    ++token;
+  }
+  auto value{0};
+  while (isDigit(*token)) {
+    value = value * 10 + (*token - '0');
+    ++token;
+  }
+  return negative ? -value : value;
+}
+
+const char *indexEnd(const char *token) {
+  while (*token != '/' && !isSpace(*token) && !isNewLine(*token)) ++token;
+  return token;
+}
+
+// Makes an index zero-based. Negative indices are relative to the number
+// of attributes read so far
+bool fixIndex(int index, std::size_t count, std::uint8_t flag, int &result,
+              std::uint8_t &relative) {
+  if (index > 0) {
+    result = index - 1;
+    return true;
+  }
+  if (index == 0) return false;
+  result = static_cast<int>(count) + index;
+  relative |= flag;
+  return true;
+}
+
+// Parses i, i/j/k, i//k or i/j. Returns false on a zero index
+bool parseCorner(const char *&token, const Chunk &chunk, Corner &corner,
+                 std::uint8_t &relative) {
+  if (!fixIndex(parseInt(token), chunk.positions.size() / 3, relativeV,
+                corner.v, relative)) {
+    return false;
+  }
+  token = indexEnd(token);
+  if (*token != '/') return true;
+  ++token;
+
+  // i//k
+  if (*token == '/') {
+    ++token;
+    if (!fixIndex(parseInt(token), chunk.normals.size() / 3, relativeVN,
+                  corner.vn, relative)) {
+      return false;
+    }
+    token = indexEnd(token);
+    return true;
+  }
+
+  // i/j/k or i/j
+  if (!fixIndex(parseInt(token), chunk.texCoords.size() / 2, relativeVT,
+                corner.vt, relative)) {
+    return false;
+  }
+  token = indexEnd(token);
+  if (*token != '/') return true;
+  ++token;
+
+  if (!fixIndex(parseInt(token), chunk.normals.size() / 3, relativeVN,
+                corner.vn, relative)) {
+    return false;
+  }
+  token = indexEnd(token);
+  return true;
+}
+
+void parseChunk(Chunk &chunk) {
+  const auto *cursor{chunk.text.data()};
+  const auto *const end{cursor + chunk.text.size()};
+
+  while (cursor < end) {
+    const auto *token{skipSpaces(cursor)};
+
+    if (token[0] == 'v' && isSpace(token[1])) {
+      token += 2;
+      for ([[maybe_unused]] auto i : iter::range(3)) {
+        chunk.positions.push_back(parseFloat(token));
+      }
+    } else if (token[0] == 'v' && token[1] == 'n' && isSpace(token[2])) {
+      token += 3;
+      for ([[maybe_unused]] auto i : iter::range(3)) {
+        chunk.normals.push_back(parseFloat(token));
+      }
+    } else if (token[0] == 'v' && token[1] == 't' && isSpace(token[2])) {
+      token += 3;
+      for ([[maybe_unused]] auto i : iter::range(2)) {
+        chunk.texCoords.push_back(parseFloat(token));
+      }
+    } else if (token[0] == 'f' && isSpace(token[1])) {
+      token = skipSpaces(token + 2);
+      std::uint32_t faceSize{};
+      while (!isNewLine(*token)) {
+        Corner corner;
+        std::uint8_t relative{};
+        if (!parseCorner(token, chunk, corner, relative)) {
+          chunk.errorLine = chunk.numLines + 1;
+          return;
+        }
+        if (relative != 0) {
+          chunk.relativeCorners.emplace_back(chunk.corners.size(), relative);
+        }
+        chunk.corners.push_back(corner);
+        ++faceSize;
+        token = skipSpaces(token);
+      }
+      chunk.faceSizes.push_back(faceSize);
+    } else if (std::strncmp(token, "usemtl", 6) == 0) {
+      token = skipSpaces(token + 6);
+      const auto *nameEnd{tokenEnd(token)};
+      chunk.statements.push_back({.isUseMtl = true,
+                                  .face = chunk.faceSizes.size(),
+                                  .argument = std::string{token, nameEnd}});
+      token = nameEnd;
+    } else if (std::strncmp(token, "mtllib", 6) == 0 && isSpace(token[6])) {
+      token += 7;
+      const auto *lineEnd{token};
+      while (!isNewLine(*lineEnd)) ++lineEnd;
+      chunk.statements.push_back({.isUseMtl = false,
+                                  .face = chunk.faceSizes.size(),
+                                  .argument = std::string{token, lineEnd}});
+      token = lineEnd;
+    }
+
+    // Skip the rest of the line
+    while (token < end && !isLineBreak(*token)) ++token;
+    if (token < end && *token == '\n') ++chunk.numLines;
+    cursor = token + 1;
+  }
+}
+
+// Splits the file names of a mtllib statement. Spaces can be escaped with
+// a backslash
+std::vector<std::string> splitFileNames(const std::string &argument) {
+  std::vector<std::string> names;
+  std::string name;
+  auto escaping{false};
+  for (const auto c : argument) {
+    if (escaping) {
+      escaping = false;
+    } else if (c == '\\') {
+      escaping = true;
+      continue;
+    } else if (c == ' ') {
+      if (!name.empty()) names.push_back(name);
+      name.clear();
+      continue;
+    }
+    name += c;
+  }
+  names.push_back(name);
+  return names;
+}
+
+// Point in polygon test used by tinyobj's triangulation
+bool pointInTriangle(const std::array<float, 3> &vx,
+                     const std::array<float, 3> &vy, float tx, float ty) {
+  auto inside{false};
+  for (std::size_t i{0}, j{2}; i < 3; j = i++) {
+    if (((vy.at(i) > ty) != (vy.at(j) > ty)) &&
+        (tx < (vx.at(j) - vx.at(i)) * (ty - vy.at(i)) / (vy.at(j) - vy.at(i)) +
+                  vx.at(i))) {
+      inside = !inside;
+    }
+  }
+  return inside;
+}
+
+// Splits a face into triangles by ear clipping, following tinyobj's
+// exportGroupsToShape step by step so that the same triangles are made
+void triangulateFace(const Corner *face, std::size_t faceSize,
+                     int materialID, const std::vector<float> &v,
+                     Chunk &chunk, std::vector<Corner> &remaining) {
+  if (faceSize < 3) return;
+
+  auto addTriangle{[&chunk, materialID](const Corner &c0, const Corner &c1,
+                                        const Corner &c2) {
+    for (const auto &corner : {c0, c1, c2}) {
+      chunk.indices.push_back({.vertex_index = corner.v,
+                               .normal_index = corner.vn,
+                               .texcoord_index = corner.vt});
+    }
+    chunk.materialIDs.push_back(materialID);
+  }};
+
+  if (faceSize == 3) {
+    addTriangle(face[0], face[1], face[2]);
+    return;
+  }
+
+  // Find the two axes to work in
+  std::array<std::size_t, 2> axes{1, 2};
+  for (auto k : iter::range(faceSize)) {
+    const auto vi0{static_cast<std::size_t>(face[k % faceSize].v)};
+    const auto vi1{static_cast<std::size_t>(face[(k + 1) % faceSize].v)};
+    const auto vi2{static_cast<std::size_t>(face[(k + 2) % faceSize].v)};
+    if (3 * vi0 + 2 >= v.size() || 3 * vi1 + 2 >= v.size() ||
+        3 * vi2 + 2 >= v.size()) {
+      continue;
+    }
+    const auto e0x{v[vi1 * 3 + 0] - v[vi0 * 3 + 0]};
+    const auto e0y{v[vi1 * 3 + 1] - v[vi0 * 3 + 1]};
+    const auto e0z{v[vi1 * 3 + 2] - v[vi0 * 3 + 2]};
+    const auto e1x{v[vi2 * 3 + 0] - v[vi1 * 3 + 0]};
+    const auto e1y{v[vi2 * 3 + 1] - v[vi1 * 3 + 1]};
+    const auto e1z{v[vi2 * 3 + 2] - v[vi1 * 3 + 2]};
+    const auto cx{std::fabs(e0y * e1z - e0z * e1y)};
+    const auto cy{std::fabs(e0z * e1x - e0x * e1z)};
+    const auto cz{std::fabs(e0x * e1y - e0y * e1x)};
+    const auto epsilon{std::numeric_limits<float>::epsilon()};
+    if (cx > epsilon || cy > epsilon || cz > epsilon) {
+      if (!(cx > cy && cx > cz)) {
+        axes[0] = 0;
+        if (cz > cx && cz > cy) axes[1] = 1;
+      }
+      break;
+    }
+  }
+
+  auto area{0.0f};
+  for (auto k : iter::range(faceSize)) {
+    const auto vi0{static_cast<std::size_t>(face[k % faceSize].v)};
+    const auto vi1{static_cast<std::size_t>(face[(k + 1) % faceSize].v)};
+    if (vi0 * 3 + axes[0] >= v.size() || vi0 * 3 + axes[1] >= v.size() ||
+        vi1 * 3 + axes[0] >= v.size() || vi1 * 3 + axes[1] >= v.size()) {
+      continue;
+    }
+    area += (v[vi0 * 3 + axes[0]] * v[vi1 * 3 + axes[1]] -
+             v[vi0 * 3 + axes[1]] * v[vi1 * 3 + axes[0]]) *
+            0.5f;
+  }
+
+  remaining.assign(face, face + faceSize);
+  std::size_t guess{0};
+  // Number of iterations left without removing a vertex
+  auto remainingIterations{faceSize};
+  auto previousSize{faceSize};
+
+  while (remaining.size() > 3 && remainingIterations > 0) {
+    const auto size{remaining.size()};
+    if (guess >= size) guess -= size;
+
+    if (previousSize != size) {
+      previousSize = size;
+      remainingIterations = size;
+    } else {
+      --remainingIterations;
+    }
+
+    std::array<Corner, 3> ear;
+    std::array<float, 3> vx{};
+    std::array<float, 3> vy{};
+    for (auto k : iter::range<std::size_t>(3)) {
+      ear.at(k) = remaining.at((guess + k) % size);
+      const auto vi{static_cast<std::size_t>(ear.at(k).v)};
+      if (vi * 3 + axes[0] < v.size() && vi * 3 + axes[1] < v.size()) {
+        vx.at(k) = v[vi * 3 + axes[0]];
+        vy.at(k) = v[vi * 3 + axes[1]];
+      }
+    }
+
+    // Skip reflex vertices
+    const auto cross{(vx[1] - vx[0]) * (vy[2] - vy[1]) -
+                     (vy[1] - vy[0]) * (vx[2] - vx[1])};
+    if (cross * area < 0.0f) {
+      ++guess;
+      continue;
+    }
+
+    // Skip if any other vertex is inside the triangle
+    auto overlap{false};
+    for (auto other : iter::range<std::size_t>(3, size)) {
+      const auto vi{
+          static_cast<std::size_t>(remaining.at((guess + other) % size).v)};
+      if (vi * 3 + axes[0] >= v.size() || vi * 3 + axes[1] >= v.size()) {
+        continue;
+      }
+      if (pointInTriangle(vx, vy, v[vi * 3 + axes[0]], v[vi * 3 + axes[1]])) {
+        overlap = true;
+        break;
+      }
+    }
+    if (overlap) {
+      ++guess;
+      continue;
+    }
+
+    addTriangle(ear[0], ear[1], ear[2]);
+    remaining.erase(remaining.begin() +
+                    static_cast<std::ptrdiff_t>((guess + 1) % size));
+  }
+
+  if (remaining.size() == 3) {
+    addTriangle(remaining[0], remaining[1], remaining[2]);
+  }
+}
+
+// Resolves relative indices and triangulates the faces of a chunk
+void finishChunk(Chunk &chunk, const std::array<int, 3> &base,
+                 const std::vector<float> &positions) {
+  for (const auto &[index, relative] : chunk.relativeCorners) {
+    auto &corner{chunk.corners.at(index)};
+    if ((relative & relativeV) != 0) corner.v += base[0];
+    if ((relative & relativeVT) != 0) corner.vt += base[1];
+    if ((relative & relativeVN) != 0) corner.vn += base[2];
+  }
+
+  // Absolute indices of the chunk may point to any attribute of the file
+  for (const auto &corner : chunk.corners) {
+    chunk.greatestIndex[0] = std::max(chunk.greatestIndex[0], corner.v);
+    chunk.greatestIndex[1] = std::max(chunk.greatestIndex[1], corner.vt);
+    chunk.greatestIndex[2] = std::max(chunk.greatestIndex[2], corner.vn);
+  }
+
+  chunk.indices.reserve(chunk.corners.size());
+  chunk.materialIDs.reserve(chunk.faceSizes.size());
+  std::vector<Corner> remaining;
+  const auto *face{chunk.corners.data()};
+  for (auto &&[faceSize, materialID] :
+       iter::zip(chunk.faceSizes, chunk.faceMaterialIDs)) {
+    triangulateFace(face, faceSize, materialID, positions, chunk, remaining);
+    face += faceSize;
+  }
+}
+
+template <typename T>
+void append(std::vector<T> &destination, std::vector<T> &source) {
+  destination.insert(destination.end(), source.begin(), source.end());
+  source = {};
+}
+
+void runConcurrently(std::vector<Chunk> &chunks,
+                     const std::function<void(Chunk &)> &task) {
+  std::vector<std::future<void>> futures;
+  futures.reserve(chunks.size());
+  for (auto &chunk : chunks) {
+    futures.push_back(std::async(parseLaunchPolicy, task, std::ref(chunk)));
+  }
+  for (auto &future : futures) future.get();
+}
+}  // namespace
+
+/**
+ * @brief Reads a Wavefront OBJ file and its material files.
+ *
+ * Polygons are triangulated. The file is parsed on multiple threads if it
+ * is large enough.
+ *
+ * @param path Path to the OBJ file. Material files are searched in the
+ * same directory.
+ *
+ * @return Geometry and materials of the file.
+ *
+ * @throw abcg::Exception if the file cannot be read or has a face with an
+ * invalid index.
+ */
+abcg::ObjData abcg::loadObjData(std::string_view path) {
+  std::string text;
+  {
+    std::ifstream input(std::string{path}, std::ios::binary | std::ios::ate);
+    if (!input) {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Failed to load model {} (cannot open file)", path))};
+    }
+    text.resize(static_cast<std::size_t>(input.tellg()));
+    input.seekg(0);
+    input.read(text.data(), static_cast<std::streamsize>(text.size()));
+  }
+
+  // Split the text at line breaks
+  const auto numThreads{std::max(1U, std::thread::hardware_concurrency())};
+  const auto numChunks{
+      std::clamp<std::size_t>(text.size() / minChunkSize, 1, numThreads)};
+  std::vector<Chunk> chunks(numChunks);
+  std::size_t chunkBegin{0};
+  for (auto &&[index, chunk] : iter::enumerate(chunks)) {
+    auto chunkEnd{text.size() * (index + 1) / numChunks};
+    chunkEnd = std::max(chunkEnd, chunkBegin);
+    while (chunkEnd < text.size() && !isLineBreak(text[chunkEnd])) ++chunkEnd;
+    chunkEnd = std::min(chunkEnd + 1, text.size());
+    chunk.text = std::string_view{text}.substr(chunkBegin,
+                                               chunkEnd - chunkBegin);
+    chunkBegin = chunkEnd;
+  }
+
+  runConcurrently(chunks, parseChunk);
+
+  ObjData data;
+
+  std::size_t numLines{};
+  for (const auto &chunk : chunks) {
+    if (chunk.errorLine != 0) {
+      throw abcg::Exception{abcg::Exception::Runtime(
+          fmt::format("Failed to load model {} (invalid face index at line {})",
+                      path, numLines + chunk.errorLine))};
+    }
+    numLines += chunk.numLines;
+  }
+
+  // Apply the material statements in file order
+  std::string mtlBaseDir;
+  if (const auto pos{path.find_last_of("/\\")}; pos != std::string::npos) {
+    mtlBaseDir = path.substr(0, pos);
+  }
+  tinyobj::MaterialFileReader materialReader{mtlBaseDir};
+  std::map<std::string, int> materialMap;
+  auto materialID{-1};
+  for (auto &chunk : chunks) {
+    chunk.faceMaterialIDs.reserve(chunk.faceSizes.size());
+    auto statement{chunk.statements.begin()};
+    for (auto face : iter::range(chunk.faceSizes.size() + 1)) {
+      for (; statement != chunk.statements.end() && statement->face == face;
+           ++statement) {
+        if (statement->isUseMtl) {
+          auto it{materialMap.find(statement->argument)};
+          if (it == materialMap.end()) {
+            data.warning += fmt::format("material [ '{}' ] not found in .mtl\n",
+                                        statement->argument);
+            materialID = -1;
+          } else {
+            materialID = it->second;
+          }
+          continue;
+        }
+        auto found{false};
+        for (const auto &fileName : splitFileNames(statement->argument)) {
+          if (std::find(data.materialFiles.begin(), data.materialFiles.end(),
+                        fileName) == data.materialFiles.end()) {
+            data.materialFiles.push_back(fileName);
+          }
+          std::string warning;
+          std::string error;
+          found = materialReader(fileName, &data.materials, &materialMap,
+                                 &warning, &error);
+          data.warning += warning + error;
+          if (found) break;
+        }
+        if (!found) {
+          data.warning +=
+              "Failed to load material file(s). Use default material.\n";
+        }
+      }
+      if (face < chunk.faceSizes.size()) {
+        chunk.faceMaterialIDs.push_back(materialID);
+      }
+    }
+  }
+
+  // Merge the attributes. Relative indices of each chunk are offset by the
+  // number of attributes of the preceding chunks
+  auto &attrib{data.attrib};
+  std::vector<std::array<int, 3>> bases;
+  bases.reserve(chunks.size());
+  for (auto &chunk : chunks) {
+    bases.push_back({static_cast<int>(attrib.vertices.size() / 3),
+                     static_cast<int>(attrib.texcoords.size() / 2),
+                     static_cast<int>(attrib.normals.size() / 3)});
+    append(attrib.vertices, chunk.positions);
+    append(attrib.normals, chunk.normals);
+    append(attrib.texcoords, chunk.texCoords);
+  }
+
+  runConcurrently(chunks, [&](Chunk &chunk) {
+    const auto index{static_cast<std::size_t>(&chunk - chunks.data())};
+    finishChunk(chunk, bases.at(index), attrib.vertices);
+  });
+
+  std::array<int, 3> greatestIndex{-1, -1, -1};
+  for (auto &chunk : chunks) {
+    append(data.indices, chunk.indices);
+    append(data.materialIDs, chunk.materialIDs);
+    for (auto i : iter::range<std::size_t>(3)) {
+      greatestIndex.at(i) = std::max(greatestIndex.at(i),
+                                     chunk.greatestIndex.at(i));
+    }
+  }
+
+  if (greatestIndex[0] >= static_cast<int>(attrib.vertices.size() / 3)) {
+    data.warning += "Vertex indices out of bounds\n";
+  }
+  if (greatestIndex[1] >= static_cast<int>(attrib.texcoords.size() / 2)) {
+    data.warning += "Vertex texcoord indices out of bounds\n";
+  }
+  if (greatestIndex[2] >= static_cast<int>(attrib.normals.size() / 3)) {
+    data.warning += "Vertex normal indices out of bounds\n";
+  }
+
+  return data;
+}
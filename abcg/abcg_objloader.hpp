@@ -0,0 +1,43 @@
+/**
+ * @file abcg_objloader.hpp
+ * @brief Declaration of the Wavefront OBJ file reader.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OBJLOADER_HPP_
+#define ABCG_OBJLOADER_HPP_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "tiny_obj_loader.h"
+
+namespace abcg {
+struct ObjData;
+[[nodiscard]] ObjData loadObjData(std::string_view path);
+}  // namespace abcg
+
+/**
+ * @brief Geometry and materials read from a Wavefront OBJ file.
+ *
+ * Holds the same data tinyobj::ObjReader produces with triangulation
+ * enabled, with the faces of all shapes merged in file order. Vertex
+ * colors, lines and points are not read.
+ */
+struct abcg::ObjData {
+  // Vertex positions, normals and texture coordinates
+  tinyobj::attrib_t attrib;
+  // Three indices per triangle
+  std::vector<tinyobj::index_t> indices;
+  // Material of each triangle. -1 if none
+  std::vector<int> materialIDs;
+  std::vector<tinyobj::material_t> materials;
+  // Names of the MTL files of the mtllib statements, found or not,
+  // relative to the directory of the OBJ file
+  std::vector<std::string> materialFiles;
+  std::string warning;
+};
+
+#endif
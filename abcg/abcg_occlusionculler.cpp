@@ -0,0 +1,158 @@
+/**
+ * @file abcg_occlusionculler.cpp
+ * @brief Definition of abcg::OcclusionCuller class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_occlusionculler.hpp"
+
+#include <cppitertools/itertools.hpp>
+#include <glm/vec4.hpp>
+
+/**
+ * @brief Sets up the program that draws the bounding boxes.
+ *
+ * @param program Program with the viewProjMatrix, boxMin and boxMax uniform
+ * variables. Its vertex shader builds the box from gl_VertexID.
+ */
+void abcg::OcclusionCuller::initializeGL(GLuint program) {
+  terminateGL();
+
+  m_program = program;
+  m_viewProjMatrixLocation = glGetUniformLocation(program, "viewProjMatrix");
+  m_boxMinLocation = glGetUniformLocation(program, "boxMin");
+  m_boxMaxLocation = glGetUniformLocation(program, "boxMax");
+
+  // The vertices are generated by the shader, but a VAO must be bound
+  glGenVertexArrays(1, &m_VAO);
+}
+
+/**
+ * @brief Deletes the queries and the VAO. The program is not deleted.
+ */
+void abcg::OcclusionCuller::terminateGL() {
+  for (auto& [object, state] : m_objects) {
+    glDeleteQueries(1, &state.query);
+  }
+  m_objects.clear();
+  glDeleteVertexArrays(1, &m_VAO);
+  m_VAO = 0;
+  m_frame = 0;
+}
+
+/**
+ * @brief Starts a new frame, reading the results of the queries that are
+ * available.
+ *
+ * Must be called before isVisible() and test().
+ *
+ * @param viewProjMatrix Product of the projection and view matrices.
+ */
+void abcg::OcclusionCuller::begin(const glm::mat4& viewProjMatrix) {
+  ++m_frame;
+  m_viewProjMatrix = viewProjMatrix;
+  m_statistics = {};
+
+  for (auto& [object, state] : m_objects) {
+    if (state.pending) {
+      GLuint available{};
+      glGetQueryObjectuiv(state.query, GL_QUERY_RESULT_AVAILABLE, &available);
+      if (available == GL_TRUE) {
+        GLuint samplesPassed{};
+        glGetQueryObjectuiv(state.query, GL_QUERY_RESULT, &samplesPassed);
+        state.visible = samplesPassed != GL_FALSE;
+        state.pending = false;
+      }
+    }
+    if (state.lastTestedFrame + 1 == m_frame && !state.visible &&
+        !state.clipped) {
+      ++m_statistics.occluded;
+    }
+  }
+}
+
+/**
+ * @brief Tests whether a bounding box is hidden by what has been drawn.
+ *
+ * Must be called after drawing the scene of the frame, between begin()
+ * and end(). Color and depth writes are disabled until end().
+ *
+ * If the query of the object issued in an earlier frame has no result yet,
+ * no new query is issued.
+ *
+ * @param object Identifier of the object.
+ * @param box Bounding box of the object in world space.
+ */
+void abcg::OcclusionCuller::test(std::size_t object, const AABB& box) {
+  auto& state{m_objects[object]};
+  state.lastTestedFrame = m_frame;
+  state.clipped = false;
+
+  // Boxes crossing the near plane are partially clipped, so the query
+  // could fail for a visible object
+  for (const auto corner : iter::range(8)) {
+    const glm::vec4 position{(corner & 1) != 0 ? box.boundsMax.x
+                                               : box.boundsMin.x,
+                             (corner & 2) != 0 ? box.boundsMax.y
+                                               : box.boundsMin.y,
+                             (corner & 4) != 0 ? box.boundsMax.z
+                                               : box.boundsMin.z,
+                             1.0f};
+    const auto clipPosition{m_viewProjMatrix * position};
+    if (clipPosition.z < -clipPosition.w) {
+      state.clipped = true;
+      return;
+    }
+  }
+
+  if (state.pending) return;
+
+  if (!m_testing) {
+    m_testing = true;
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glUseProgram(m_program);
+    glBindVertexArray(m_VAO);
+    glUniformMatrix4fv(m_viewProjMatrixLocation, 1, GL_FALSE,
+                       &m_viewProjMatrix[0][0]);
+  }
+
+  if (state.query == 0) glGenQueries(1, &state.query);
+  glUniform3fv(m_boxMinLocation, 1, &box.boundsMin.x);
+  glUniform3fv(m_boxMaxLocation, 1, &box.boundsMax.x);
+  glBeginQuery(GL_ANY_SAMPLES_PASSED, state.query);
+  glDrawArrays(GL_TRIANGLE_STRIP, 0, 14);
+  glEndQuery(GL_ANY_SAMPLES_PASSED);
+  state.pending = true;
+  ++m_statistics.queries;
+}
+
+/**
+ * @brief Restores the color and depth writes disabled by test().
+ */
+void abcg::OcclusionCuller::end() {
+  if (!m_testing) return;
+
+  m_testing = false;
+  glBindVertexArray(0);
+  glUseProgram(0);
+  glDepthMask(GL_TRUE);
+  glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+/**
+ * @brief Returns the result of the last query of an object.
+ *
+ * @param object Identifier of the object.
+ *
+ * @return false only if the object was found hidden and was tested in the
+ * previous frame with its box in front of the near plane.
+ */
+bool abcg::OcclusionCuller::isVisible(std::size_t object) const {
+  const auto it{m_objects.find(object)};
+  if (it == m_objects.end()) return true;
+  const auto& state{it->second};
+  return state.visible || state.clipped ||
+         state.lastTestedFrame + 1 != m_frame;
+}
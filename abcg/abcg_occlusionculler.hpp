@@ -0,0 +1,90 @@
+/**
+ * @file abcg_occlusionculler.hpp
+ * @brief abcg::OcclusionCuller header file.
+ *
+ * Declaration of abcg::OcclusionCuller class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_OCCLUSIONCULLER_HPP_
+#define ABCG_OCCLUSIONCULLER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <glm/mat4x4.hpp>
+#include <unordered_map>
+
+#include "abcg_aabbtree.hpp"
+#include "abcg_external.hpp"
+
+namespace abcg {
+class OcclusionCuller;
+}  // namespace abcg
+
+/**
+ * @brief abcg::OcclusionCuller class.
+ *
+ * Finds objects hidden behind others with hardware occlusion queries.
+ *
+ * After the scene is drawn, the bounding boxes of the objects are drawn
+ * with color and depth writes disabled, each inside a GL_ANY_SAMPLES_PASSED
+ * query. Results are read in later frames, only once they are available,
+ * so the CPU never waits for the GPU. Until then, the object keeps its
+ * last result. Objects seen for the first time, not tested in the previous
+ * frame or whose box crosses the near plane are always visible, so that
+ * they don't disappear for a frame while their query is in flight.
+ *
+ * Objects are identified by any number chosen by the application.
+ *
+ * The program given to initializeGL() must draw the box from
+ * gl_VertexID, as a triangle strip of 14 vertices, with the uniform
+ * variables viewProjMatrix, boxMin and boxMax.
+ */
+class abcg::OcclusionCuller {
+ public:
+  /**
+   * @brief Queries issued and results read by the last frame.
+   */
+  struct Statistics {
+    std::size_t queries{};
+    std::size_t occluded{};
+  };
+
+  void initializeGL(GLuint program);
+  void terminateGL();
+
+  void begin(const glm::mat4& viewProjMatrix);
+  void test(std::size_t object, const AABB& box);
+  void end();
+
+  [[nodiscard]] bool isVisible(std::size_t object) const;
+  [[nodiscard]] const Statistics& getStatistics() const {
+    return m_statistics;
+  }
+
+ private:
+  struct Object {
+    GLuint query{};
+    // The result of the query is not read yet
+    bool pending{false};
+    bool visible{true};
+    // The box crossed the near plane when last tested
+    bool clipped{false};
+    std::uint64_t lastTestedFrame{};
+  };
+
+  GLuint m_program{};
+  GLuint m_VAO{};
+  GLint m_viewProjMatrixLocation{-1};
+  GLint m_boxMinLocation{-1};
+  GLint m_boxMaxLocation{-1};
+
+  std::unordered_map<std::size_t, Object> m_objects;
+  std::uint64_t m_frame{};
+  glm::mat4 m_viewProjMatrix{1.0f};
+  bool m_testing{false};
+  Statistics m_statistics;
+};
+
+#endif
@@ -394,6 +394,63 @@ GLuint abcg::OpenGLWindow::createProgramFromString(
   return shaderProgram;
 }
 
+GLuint abcg::OpenGLWindow::createComputeProgramFromFile(
+    std::string_view pathToComputeShader) {
+  std::stringstream computeShaderSource;
+  if (std::ifstream stream(pathToComputeShader.data()); stream) {
+    computeShaderSource << stream.rdbuf();
+    stream.close();
+  } else {
+    throw abcg::Exception{abcg::Exception::Runtime(fmt::format(
+        "Failed to read compute shader file {}", pathToComputeShader))};
+  }
+
+  return createComputeProgramFromString(computeShaderSource.str());
+}
+
+// Compute shaders require OpenGL 4.3, so the source keeps its own version
+// header, or gets "#version 430" if it has none
+GLuint abcg::OpenGLWindow::createComputeProgramFromString(
+    [[maybe_unused]] std::string_view computeShaderSource) {
+#if defined(__EMSCRIPTEN__)
+  throw abcg::Exception{
+      abcg::Exception::Runtime("Compute shaders are not supported")};
+#else
+  std::string csSource{abcg::trimCopy(std::string{computeShaderSource})};
+  if (!csSource.starts_with("#version"))
+    csSource = "#version 430\n\n" + csSource;
+
+  GLint compileStatus{};
+  GLuint computeShader = glCreateShader(GL_COMPUTE_SHADER);
+  const char *csSourceConstChar = csSource.c_str();
+  glShaderSource(computeShader, 1, &csSourceConstChar, nullptr);
+  glCompileShader(computeShader);
+  glGetShaderiv(computeShader, GL_COMPILE_STATUS, &compileStatus);
+  if (compileStatus == 0) {
+    printShaderInfoLog(computeShader, "Compute shader");
+    glDeleteShader(computeShader);
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Failed to compile compute shader")};
+  }
+
+  GLuint shaderProgram = glCreateProgram();
+  glAttachShader(shaderProgram, computeShader);
+
+  glLinkProgram(shaderProgram);
+  GLint linkStatus{};
+  glGetProgramiv(shaderProgram, GL_LINK_STATUS, &linkStatus);
+  if (linkStatus == 0) {
+    printProgramInfoLog(shaderProgram);
+    glDeleteShader(computeShader);
+    throw abcg::Exception{abcg::Exception::Runtime("Failed to link program")};
+  }
+
+  glDeleteShader(computeShader);
+
+  return shaderProgram;
+#endif
+}
+
 std::string abcg::OpenGLWindow::getAssetsPath() { return m_assetsPath; }
 
 double abcg::OpenGLWindow::getDeltaTime() const { return m_lastDeltaTime; }
@@ -86,6 +86,10 @@ class abcg::OpenGLWindow {
   [[nodiscard]] GLuint createProgramFromString(
       std::string_view vertexShaderSource,
       std::string_view fragmentShaderSource);
+  [[nodiscard]] GLuint createComputeProgramFromFile(
+      std::string_view pathToComputeShader);
+  [[nodiscard]] GLuint createComputeProgramFromString(
+      std::string_view computeShaderSource);
   std::string getAssetsPath();
   [[nodiscard]] double getDeltaTime() const;
   [[nodiscard]] double getElapsedTime() const;
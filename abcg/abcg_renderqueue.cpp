@@ -0,0 +1,427 @@
+/**
+ * @file abcg_renderqueue.cpp
+ * @brief Definition of abcg::RenderQueue class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_renderqueue.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cppitertools/itertools.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include "abcg_mesh.hpp"
+
+namespace {
+// Layout of the sort keys, from the most significant bits:
+//  - opaque: pass (8), program (16), texture (16), depth (24);
+//  - transparent: pass (8), inverted depth (24), program (16), texture (16).
+// Program and texture names are truncated to 16 bits, which only costs
+// extra state changes if two names collide
+constexpr std::uint64_t nameMask{0xFFFF};
+constexpr std::uint64_t depthMask{0xFFFFFF};
+
+// Depth in 24 bits that keep the order of non-negative floats. The bit
+// pattern of a non-negative float grows with its value, so dropping the
+// sign and the 7 least significant bits of the mantissa is enough
+std::uint64_t quantizeDepth(float depth) {
+  return (std::bit_cast<std::uint32_t>(std::max(depth, 0.0f)) >> 7U) &
+         depthMask;
+}
+
+// Size of the entries of the shader storage buffer in std430 layout
+static_assert(sizeof(abcg::RenderQueue::IndirectDraw) == 176);
+
+std::size_t getIndexSize(GLenum indexType) {
+  switch (indexType) {
+    case GL_UNSIGNED_BYTE:
+      return sizeof(GLubyte);
+    case GL_UNSIGNED_SHORT:
+      return sizeof(GLushort);
+    default:
+      return sizeof(GLuint);
+  }
+}
+
+// Items drawn by the same glMultiDrawElementsIndirect call share all state
+// but the transform and the material
+bool canBatch(const abcg::DrawItem& first, const abcg::DrawItem& second) {
+  return first.program == second.program && first.VAO == second.VAO &&
+         first.texture == second.texture &&
+         (first.texture == 0 || first.textureTarget == second.textureTarget) &&
+         first.mode == second.mode && first.indexType == second.indexType;
+}
+}  // namespace
+
+/**
+ * @brief Returns whether the context can draw items with
+ * glMultiDrawElementsIndirect.
+ *
+ * Requires OpenGL 4.3, for indirect draws and shader storage buffers, and
+ * ARB_shader_draw_parameters, for gl_DrawIDARB. Always false in WebGL.
+ */
+bool abcg::RenderQueue::isIndirectSupported() {
+#if defined(__EMSCRIPTEN__)
+  return false;
+#else
+  return GLEW_VERSION_4_3 && GLEW_ARB_shader_draw_parameters;
+#endif
+}
+
+/**
+ * @brief Starts a new frame, discarding the items and transforms of the
+ * previous one.
+ *
+ * @param viewMatrix View matrix, used to sort by depth and set to the
+ * viewMatrix uniform variable.
+ * @param projMatrix Projection matrix, set to the projMatrix uniform
+ * variable.
+ */
+void abcg::RenderQueue::begin(const glm::mat4& viewMatrix,
+                              const glm::mat4& projMatrix) {
+  m_viewMatrix = viewMatrix;
+  m_projMatrix = projMatrix;
+  m_transforms.clear();
+  m_items.clear();
+  m_counts.clear();
+  m_offsets.clear();
+}
+
+/**
+ * @brief Adds a model matrix that items can refer to.
+ *
+ * Items drawn with the same transform share the model and normal matrix
+ * uploads.
+ *
+ * @param modelMatrix Model matrix.
+ *
+ * @return Handle of the transform for abcg::DrawItem::transform.
+ */
+std::size_t abcg::RenderQueue::addTransform(const glm::mat4& modelMatrix) {
+  m_transforms.push_back(
+      {.modelMatrix = modelMatrix,
+       .normalMatrix = glm::inverseTranspose(
+           glm::mat3{m_viewMatrix * modelMatrix})});
+  return m_transforms.size() - 1;
+}
+
+/**
+ * @brief Queues a draw call of a single range of indices.
+ *
+ * @param item Draw call.
+ */
+void abcg::RenderQueue::submit(const DrawItem& item) {
+  submit(item, {static_cast<GLsizei>(item.indexCount)}, {item.firstIndex});
+}
+
+/**
+ * @brief Queues a draw call of several ranges of indices sharing all other
+ * state.
+ *
+ * The ranges are drawn with a single glMultiDrawElementsBaseVertex call, or
+ * with a glDrawElements call per range in WebGL. item.firstIndex and
+ * item.indexCount are ignored.
+ *
+ * @param item Draw call.
+ * @param counts Number of indices of each range.
+ * @param firstIndices First index of each range.
+ */
+void abcg::RenderQueue::submit(const DrawItem& item,
+                               const std::vector<GLsizei>& counts,
+                               const std::vector<std::size_t>& firstIndices) {
+  if (counts.empty()) return;
+
+  const auto indexSize{getIndexSize(item.indexType)};
+  m_items.push_back({.item = item,
+                     .key = makeKey(item),
+                     .firstRange = m_counts.size(),
+                     .rangeCount = counts.size()});
+  for (const auto range : iter::range(counts.size())) {
+    m_counts.push_back(counts.at(range));
+    m_offsets.push_back(
+        reinterpret_cast<void*>(firstIndices.at(range) * indexSize));
+  }
+}
+
+/**
+ * @brief Draws the queued items in key order and empties the queue.
+ *
+ * Leaves no program, no VAO and no indirect buffer bound.
+ */
+void abcg::RenderQueue::flush() {
+  m_statistics = {.items = m_items.size()};
+
+  m_order.clear();
+  for (auto&& [index, queued] : iter::enumerate(m_items)) {
+    m_order.emplace_back(queued.key, index);
+  }
+  std::sort(m_order.begin(), m_order.end());
+
+  // Locations are looked up again each frame, as program names may be
+  // reused after a program is deleted
+  m_uniforms.clear();
+
+  buildIndirectBatches();
+#if !defined(__EMSCRIPTEN__)
+  auto batch{m_batches.cbegin()};
+#endif
+
+  GLuint program{};
+  GLuint VAO{};
+  GLuint texture{};
+  GLenum textureTarget{};
+  const Material* material{};
+  auto transform{m_transforms.size()};
+  const ProgramUniforms* uniforms{};
+  auto bindProgram{[&](GLuint newProgram) {
+    const auto changed{newProgram != program || !uniforms};
+    if (changed) {
+      program = newProgram;
+      glUseProgram(program);
+      uniforms = &getUniforms(program);
+      ++m_statistics.programChanges;
+    }
+    return changed;
+  }};
+  auto bindState{[&](const DrawItem& item) {
+    if (item.VAO != VAO) {
+      VAO = item.VAO;
+      glBindVertexArray(VAO);
+      ++m_statistics.vertexArrayChanges;
+    }
+
+    if (item.texture != 0 &&
+        (item.texture != texture || item.textureTarget != textureTarget)) {
+      texture = item.texture;
+      textureTarget = item.textureTarget;
+      glBindTexture(textureTarget, texture);
+      ++m_statistics.textureChanges;
+    }
+  }};
+
+  for (std::size_t position{}; position < m_order.size(); ++position) {
+    const auto& queued{m_items.at(m_order.at(position).second)};
+    const auto& item{queued.item};
+
+#if !defined(__EMSCRIPTEN__)
+    if (batch != m_batches.cend() && batch->begin == position) {
+      bindProgram(m_indirectPrograms.at(item.program));
+      bindState(item);
+      glUniform1i(uniforms->firstDraw, static_cast<GLint>(batch->firstCommand));
+      glMultiDrawElementsIndirect(
+          item.mode, item.indexType,
+          reinterpret_cast<void*>(batch->firstCommand *
+                                  sizeof(IndirectCommand)),
+          static_cast<GLsizei>(batch->commandCount), 0);
+      ++m_statistics.drawCalls;
+      m_statistics.indirectDraws += batch->commandCount;
+
+      position = batch->end - 1;
+      ++batch;
+      continue;
+    }
+#endif
+
+    const auto programChanged{bindProgram(item.program)};
+    bindState(item);
+
+    if (programChanged || item.transform != transform) {
+      transform = item.transform;
+      const auto& matrices{m_transforms.at(transform)};
+      glUniformMatrix4fv(uniforms->modelMatrix, 1, GL_FALSE,
+                         &matrices.modelMatrix[0][0]);
+      glUniformMatrix3fv(uniforms->normalMatrix, 1, GL_FALSE,
+                         &matrices.normalMatrix[0][0]);
+    }
+
+    if (item.material && (programChanged || item.material != material)) {
+      material = item.material;
+      glUniform4fv(uniforms->Ka, 1, &material->Ka.x);
+      glUniform4fv(uniforms->Kd, 1, &material->Kd.x);
+      glUniform4fv(uniforms->Ks, 1, &material->Ks.x);
+      glUniform1f(uniforms->shininess, material->shininess);
+      glUniform1i(uniforms->diffuseLayer, material->diffuseLayer);
+    }
+
+    const auto* counts{m_counts.data() + queued.firstRange};
+    const auto* offsets{m_offsets.data() + queued.firstRange};
+    const auto rangeCount{static_cast<GLsizei>(queued.rangeCount)};
+#if defined(__EMSCRIPTEN__)
+    for (const auto range : iter::range(rangeCount)) {
+      glDrawElements(item.mode, counts[range], item.indexType,
+                     offsets[range]);
+    }
+    m_statistics.drawCalls += queued.rangeCount;
+#else
+    if (rangeCount == 1) {
+      glDrawElementsBaseVertex(item.mode, counts[0], item.indexType,
+                               offsets[0], item.baseVertex);
+    } else {
+      m_baseVertices.assign(queued.rangeCount, item.baseVertex);
+      glMultiDrawElementsBaseVertex(item.mode, counts, item.indexType,
+                                    offsets, rangeCount,
+                                    m_baseVertices.data());
+    }
+    ++m_statistics.drawCalls;
+#endif
+  }
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+#if !defined(__EMSCRIPTEN__)
+  if (!m_batches.empty()) glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+#endif
+
+  m_items.clear();
+  m_counts.clear();
+  m_offsets.clear();
+}
+
+/**
+ * @brief Sets the variant of a program used to draw its items with
+ * glMultiDrawElementsIndirect.
+ *
+ * The variant must have the same inputs and outputs as the program, but
+ * read the transforms and materials from the shader storage buffer. See
+ * the description of the class.
+ *
+ * @param program Program of the items.
+ * @param indirectProgram Variant of the program, or 0 to draw the items of
+ * the program one by one.
+ */
+void abcg::RenderQueue::setIndirectProgram(GLuint program,
+                                           GLuint indirectProgram) {
+  if (indirectProgram == 0) {
+    m_indirectPrograms.erase(program);
+  } else {
+    m_indirectPrograms.insert_or_assign(program, indirectProgram);
+  }
+}
+
+/**
+ * @brief Releases the buffers of the indirect draws.
+ */
+void abcg::RenderQueue::destroy() {
+  glDeleteBuffers(1, &m_commandBuffer);
+  glDeleteBuffers(1, &m_drawBuffer);
+  m_commandBuffer = 0;
+  m_drawBuffer = 0;
+  m_indirectPrograms.clear();
+}
+
+// Sort key of an item. See the layout above
+std::uint64_t abcg::RenderQueue::makeKey(const DrawItem& item) const {
+  const auto& modelMatrix{m_transforms.at(item.transform).modelMatrix};
+  const auto viewPosition{m_viewMatrix * modelMatrix *
+                          glm::vec4{item.center, 1.0f}};
+  const auto depth{quantizeDepth(-viewPosition.z)};
+  const auto pass{static_cast<std::uint64_t>(item.pass)};
+  const auto program{item.program & nameMask};
+  const auto texture{item.texture & nameMask};
+
+  if (item.pass == RenderPass::Transparent) {
+    return pass << 56U | (depthMask - depth) << 32U | program << 16U |
+           texture;
+  }
+  return pass << 56U | program << 40U | texture << 24U | depth;
+}
+
+// Groups the sorted opaque items with an indirect program in batches and
+// uploads their commands and draws. The indirect buffer is left bound
+void abcg::RenderQueue::buildIndirectBatches() {
+  m_batches.clear();
+  m_commands.clear();
+  m_draws.clear();
+  if (m_indirectPrograms.empty() || !isIndirectSupported()) return;
+
+  static const Material defaultMaterial{};
+  for (const auto position : iter::range(m_order.size())) {
+    const auto& queued{m_items.at(m_order.at(position).second)};
+    const auto& item{queued.item};
+    if (item.pass != RenderPass::Opaque ||
+        !m_indirectPrograms.contains(item.program)) {
+      continue;
+    }
+
+    if (m_batches.empty() || m_batches.back().end != position ||
+        !canBatch(m_items.at(m_order.at(position - 1).second).item, item)) {
+      m_batches.push_back({.begin = position,
+                           .end = position,
+                           .firstCommand = m_commands.size(),
+                           .commandCount = 0});
+    }
+    auto& batch{m_batches.back()};
+    batch.end = position + 1;
+
+    const auto& transform{m_transforms.at(item.transform)};
+    const auto& material{item.material ? *item.material : defaultMaterial};
+    const IndirectDraw draw{
+        .modelMatrix = transform.modelMatrix,
+        .normalMatrix = {glm::vec4{transform.normalMatrix[0], 0.0f},
+                         glm::vec4{transform.normalMatrix[1], 0.0f},
+                         glm::vec4{transform.normalMatrix[2], 0.0f}},
+        .Ka = material.Ka,
+        .Kd = material.Kd,
+        .Ks = material.Ks,
+        .shininess = material.shininess,
+        .diffuseLayer = material.diffuseLayer,
+        .padding = {}};
+    const auto indexSize{getIndexSize(item.indexType)};
+    for (const auto range : iter::range(queued.rangeCount)) {
+      const auto offset{reinterpret_cast<std::uintptr_t>(
+          m_offsets.at(queued.firstRange + range))};
+      m_commands.push_back(
+          {.count = static_cast<GLuint>(m_counts.at(queued.firstRange + range)),
+           .instanceCount = 1,
+           .firstIndex = static_cast<GLuint>(offset / indexSize),
+           .baseVertex = item.baseVertex,
+           .baseInstance = 0});
+      m_draws.push_back(draw);
+    }
+    batch.commandCount += queued.rangeCount;
+  }
+  if (m_batches.empty()) return;
+
+#if !defined(__EMSCRIPTEN__)
+  // The buffers are orphaned, as they are written every frame
+  if (m_commandBuffer == 0) glGenBuffers(1, &m_commandBuffer);
+  if (m_drawBuffer == 0) glGenBuffers(1, &m_drawBuffer);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER,
+               static_cast<GLsizeiptr>(m_commands.size() *
+                                       sizeof(IndirectCommand)),
+               m_commands.data(), GL_STREAM_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawBuffer);
+  glBufferData(GL_SHADER_STORAGE_BUFFER,
+               static_cast<GLsizeiptr>(m_draws.size() * sizeof(IndirectDraw)),
+               m_draws.data(), GL_STREAM_DRAW);
+  glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, drawBufferBinding, m_drawBuffer);
+#endif
+}
+
+// Uniform locations of the program, which must be in use. The view and
+// projection matrices are set when the program is first seen in a frame
+const abcg::RenderQueue::ProgramUniforms& abcg::RenderQueue::getUniforms(
+    GLuint program) {
+  auto [it, inserted]{m_uniforms.try_emplace(program)};
+  if (inserted) {
+    auto& uniforms{it->second};
+    uniforms.viewMatrix = glGetUniformLocation(program, "viewMatrix");
+    uniforms.projMatrix = glGetUniformLocation(program, "projMatrix");
+    uniforms.modelMatrix = glGetUniformLocation(program, "modelMatrix");
+    uniforms.normalMatrix = glGetUniformLocation(program, "normalMatrix");
+    uniforms.Ka = glGetUniformLocation(program, "Ka");
+    uniforms.Kd = glGetUniformLocation(program, "Kd");
+    uniforms.Ks = glGetUniformLocation(program, "Ks");
+    uniforms.shininess = glGetUniformLocation(program, "shininess");
+    uniforms.diffuseLayer = glGetUniformLocation(program, "diffuseLayer");
+    uniforms.firstDraw = glGetUniformLocation(program, "firstDraw");
+
+    glUniformMatrix4fv(uniforms.viewMatrix, 1, GL_FALSE, &m_viewMatrix[0][0]);
+    glUniformMatrix4fv(uniforms.projMatrix, 1, GL_FALSE, &m_projMatrix[0][0]);
+  }
+  return it->second;
+}
@@ -0,0 +1,231 @@
+/**
+ * @file abcg_renderqueue.hpp
+ * @brief abcg::RenderQueue header file.
+ *
+ * Declaration of abcg::RenderQueue class and its draw item type.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_RENDERQUEUE_HPP_
+#define ABCG_RENDERQUEUE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <glm/mat3x3.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "abcg_external.hpp"
+
+namespace abcg {
+struct DrawItem;
+struct Material;
+class RenderQueue;
+enum class RenderPass;
+}  // namespace abcg
+
+/**
+ * @brief Passes of abcg::RenderQueue, drawn in this order.
+ */
+enum class abcg::RenderPass {
+  // Sorted by state, then front to back
+  Opaque,
+  // Sorted back to front, then by state
+  Transparent
+};
+
+/**
+ * @brief Indexed draw call submitted to abcg::RenderQueue.
+ */
+struct abcg::DrawItem {
+  RenderPass pass{RenderPass::Opaque};
+  GLuint program{};
+  GLuint VAO{};
+  // Texture bound to the active texture unit. 0 keeps the bound texture
+  GLenum textureTarget{GL_TEXTURE_2D};
+  GLuint texture{};
+  // Material whose uniform variables are set. nullptr to set none
+  const Material* material{};
+  GLenum mode{GL_TRIANGLES};
+  GLenum indexType{GL_UNSIGNED_INT};
+  std::size_t firstIndex{};
+  std::size_t indexCount{};
+  // Added to the indices, for meshes sharing buffers. Must be 0 in WebGL
+  GLint baseVertex{};
+  // Handle returned by abcg::RenderQueue::addTransform()
+  std::size_t transform{};
+  // Point in model space whose depth orders the item, usually the center of
+  // its bounding box
+  glm::vec3 center{};
+};
+
+/**
+ * @brief abcg::RenderQueue class.
+ *
+ * Collects the draw calls of a frame, sorts them by a 64-bit key and
+ * issues them changing as little OpenGL state as possible.
+ *
+ * Opaque items are grouped by program and texture and sorted front to
+ * back within each group so that the depth test discards hidden fragments
+ * early. Transparent items are drawn afterwards from back to front.
+ *
+ * Uniform variables are matched by name, and those not used by a program
+ * are skipped:
+ *  - viewMatrix and projMatrix are set once per program and frame;
+ *  - modelMatrix and normalMatrix (the inverse transpose of the
+ *    model-view matrix) are set when the transform changes;
+ *  - Ka, Kd, Ks, shininess and diffuseLayer are set when the material
+ *    changes.
+ *
+ * Other uniform variables, such as lights, must be set by the application
+ * beforehand.
+ *
+ * With OpenGL 4.3 and ARB_shader_draw_parameters, opaque items of a
+ * program given a variant with setIndirectProgram() are drawn with
+ * glMultiDrawElementsIndirect, one call for each run of consecutive items
+ * sharing the VAO, the texture, the primitive mode and the index type. The
+ * transforms and materials of the draws are stored in a shader storage
+ * buffer at binding drawBufferBinding, as an array of structures laid out
+ * as IndirectDraw, and the variant reads its entry at index
+ * firstDraw + gl_DrawIDARB, where firstDraw is a uniform variable set for
+ * each call. Items without a variant, and all items elsewhere, are drawn
+ * one by one.
+ */
+class abcg::RenderQueue {
+ public:
+  /**
+   * @brief State changes and draw calls issued by the last flush().
+   */
+  struct Statistics {
+    std::size_t items{};
+    std::size_t drawCalls{};
+    std::size_t programChanges{};
+    std::size_t textureChanges{};
+    std::size_t vertexArrayChanges{};
+    // Ranges of indices drawn by glMultiDrawElementsIndirect calls, also
+    // counted as one draw call per glMultiDrawElementsIndirect
+    std::size_t indirectDraws{};
+  };
+
+  /**
+   * @brief Entry of the shader storage buffer of the indirect draws, laid
+   * out as a std430 structure.
+   */
+  struct IndirectDraw {
+    glm::mat4 modelMatrix{1.0f};
+    // Columns of the normal matrix, each padded to a vec4
+    std::array<glm::vec4, 3> normalMatrix{};
+    glm::vec4 Ka{};
+    glm::vec4 Kd{};
+    glm::vec4 Ks{};
+    float shininess{};
+    GLint diffuseLayer{-1};
+    std::array<float, 2> padding{};
+  };
+
+  // Binding point of the shader storage buffer of the indirect draws
+  static constexpr GLuint drawBufferBinding{0};
+
+  [[nodiscard]] static bool isIndirectSupported();
+
+  void begin(const glm::mat4& viewMatrix, const glm::mat4& projMatrix);
+  [[nodiscard]] std::size_t addTransform(const glm::mat4& modelMatrix);
+  void submit(const DrawItem& item);
+  void submit(const DrawItem& item, const std::vector<GLsizei>& counts,
+              const std::vector<std::size_t>& firstIndices);
+  void flush();
+  void setIndirectProgram(GLuint program, GLuint indirectProgram);
+  void destroy();
+
+  [[nodiscard]] const glm::mat4& getViewMatrix() const {
+    return m_viewMatrix;
+  }
+  [[nodiscard]] const glm::mat4& getProjMatrix() const {
+    return m_projMatrix;
+  }
+  [[nodiscard]] const glm::mat4& getModelMatrix(std::size_t transform) const {
+    return m_transforms.at(transform).modelMatrix;
+  }
+  [[nodiscard]] const Statistics& getStatistics() const {
+    return m_statistics;
+  }
+
+ private:
+  // Locations of the uniform variables of a program
+  struct ProgramUniforms {
+    GLint viewMatrix{-1};
+    GLint projMatrix{-1};
+    GLint modelMatrix{-1};
+    GLint normalMatrix{-1};
+    GLint Ka{-1};
+    GLint Kd{-1};
+    GLint Ks{-1};
+    GLint shininess{-1};
+    GLint diffuseLayer{-1};
+    GLint firstDraw{-1};
+  };
+
+  struct Transform {
+    glm::mat4 modelMatrix{1.0f};
+    glm::mat3 normalMatrix{1.0f};
+  };
+
+  struct QueuedItem {
+    DrawItem item;
+    std::uint64_t key{};
+    // Ranges of the index buffer in m_counts and m_offsets
+    std::size_t firstRange{};
+    std::size_t rangeCount{};
+  };
+
+  // Fields of the commands read by glMultiDrawElementsIndirect
+  struct IndirectCommand {
+    GLuint count{};
+    GLuint instanceCount{};
+    GLuint firstIndex{};
+    GLint baseVertex{};
+    GLuint baseInstance{};
+  };
+
+  // Items at positions [begin, end) of m_order drawn with a single
+  // glMultiDrawElementsIndirect call
+  struct IndirectBatch {
+    std::size_t begin{};
+    std::size_t end{};
+    std::size_t firstCommand{};
+    std::size_t commandCount{};
+  };
+
+  glm::mat4 m_viewMatrix{1.0f};
+  glm::mat4 m_projMatrix{1.0f};
+  std::vector<Transform> m_transforms;
+  std::vector<QueuedItem> m_items;
+  std::vector<GLsizei> m_counts;
+  std::vector<const void*> m_offsets;
+  std::vector<GLint> m_baseVertices;
+  std::vector<std::pair<std::uint64_t, std::size_t>> m_order;
+
+  // Variants of the programs for indirect draws
+  std::unordered_map<GLuint, GLuint> m_indirectPrograms;
+  std::vector<IndirectBatch> m_batches;
+  // One draw per command, as gl_DrawIDARB is the index of the command
+  std::vector<IndirectCommand> m_commands;
+  std::vector<IndirectDraw> m_draws;
+  GLuint m_commandBuffer{};
+  GLuint m_drawBuffer{};
+
+  std::unordered_map<GLuint, ProgramUniforms> m_uniforms;
+  Statistics m_statistics;
+
+  [[nodiscard]] std::uint64_t makeKey(const DrawItem& item) const;
+  void buildIndirectBatches();
+  [[nodiscard]] const ProgramUniforms& getUniforms(GLuint program);
+};
+
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file abcg_streambuffer.cpp
+ * @brief Definition of abcg::StreamBuffer class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_streambuffer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "abcg_exception.hpp"
+
+namespace {
+// Persistent mapping requires immutable buffer storage, core in OpenGL 4.4
+bool hasBufferStorage() {
+#if defined(__EMSCRIPTEN__)
+  return false;
+#else
+  return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+#endif
+}
+}  // namespace
+
+/**
+ * @brief Creates the buffer.
+ *
+ * @param frameSize Maximum number of bytes pushed in a frame, including
+ * padding for alignment.
+ */
+void abcg::StreamBuffer::create(std::size_t frameSize) {
+  destroy();
+
+  m_frameSize = frameSize;
+  GLint uniformAlignment{};
+  glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+  m_uniformAlignment = static_cast<std::size_t>(std::max(uniformAlignment, 1));
+
+  // The copy target doesn't change the buffers bound to a VAO
+  glGenBuffers(1, &m_buffer);
+  glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+#if !defined(__EMSCRIPTEN__)
+  if (hasBufferStorage()) {
+    const auto size{static_cast<GLsizeiptr>(m_frameSize * m_numRegions)};
+    const GLbitfield flags{GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+                           GL_MAP_COHERENT_BIT};
+    glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, flags);
+    m_mapping = static_cast<std::byte*>(
+        glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags));
+  }
+#endif
+  if (m_mapping == nullptr) {
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(m_frameSize),
+                 nullptr, GL_STREAM_DRAW);
+  }
+  glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+/**
+ * @brief Releases the buffer and the fences.
+ */
+void abcg::StreamBuffer::destroy() {
+  for (auto& fence : m_fences) {
+    if (fence != nullptr) glDeleteSync(fence);
+    fence = nullptr;
+  }
+  // Deleting a buffer unmaps it
+  glDeleteBuffers(1, &m_buffer);
+  m_buffer = 0;
+  m_mapping = nullptr;
+  m_frameSize = 0;
+  m_region = 0;
+  m_offset = 0;
+}
+
+/**
+ * @brief Starts a frame.
+ *
+ * With persistent mapping, waits until the GPU has finished reading the
+ * region of three frames ago. Otherwise, orphans the buffer, so that the
+ * driver gives it new storage instead of waiting.
+ */
+void abcg::StreamBuffer::begin() {
+  m_offset = 0;
+
+  if (m_mapping == nullptr) {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(m_frameSize),
+                 nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    return;
+  }
+
+  auto& fence{m_fences.at(m_region)};
+  if (fence == nullptr) return;
+  // The first wait flushes the fence, so later ones can't wait forever
+  GLbitfield flags{GL_SYNC_FLUSH_COMMANDS_BIT};
+  const GLuint64 timeout{1'000'000};
+  while (glClientWaitSync(fence, flags, timeout) == GL_TIMEOUT_EXPIRED) {
+    flags = 0;
+  }
+  glDeleteSync(fence);
+  fence = nullptr;
+}
+
+/**
+ * @brief Appends data to the region of the current frame.
+ *
+ * @param data Pointer to the data.
+ * @param size Size of the data in bytes.
+ * @param alignment The offset returned is a multiple of this value, e.g.
+ * the size of a vertex, or getUniformAlignment() for a uniform block.
+ *
+ * @throw abcg::Exception if the data doesn't fit in the frame.
+ *
+ * @return Offset of the data in bytes from the start of the buffer.
+ */
+std::size_t abcg::StreamBuffer::push(const void* data, std::size_t size,
+                                     std::size_t alignment) {
+  const auto regionStart{m_mapping == nullptr ? 0 : m_region * m_frameSize};
+  const auto offset{(regionStart + m_offset + alignment - 1) / alignment *
+                    alignment};
+  if (offset + size > regionStart + m_frameSize) {
+    throw abcg::Exception{abcg::Exception::Runtime(
+        "Data pushed to stream buffer exceeds its frame size")};
+  }
+  m_offset = offset + size - regionStart;
+
+  if (m_mapping != nullptr) {
+    std::memcpy(m_mapping + offset, data, size);
+  } else {
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_buffer);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(offset),
+                    static_cast<GLsizeiptr>(size), data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+  }
+  return offset;
+}
+
+/**
+ * @brief Ends a frame.
+ *
+ * Must be called after the draw calls that read the data of the frame.
+ */
+void abcg::StreamBuffer::end() {
+  if (m_mapping == nullptr) return;
+
+  // Coherent writes are visible to commands issued after them, so only
+  // the reads of the GPU need to be fenced
+  if (m_offset > 0) {
+    m_fences.at(m_region) = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+  m_region = (m_region + 1) % m_numRegions;
+}
@@ -0,0 +1,101 @@
+/**
+ * @file abcg_streambuffer.hpp
+ * @brief abcg::StreamBuffer header file.
+ *
+ * Declaration of abcg::StreamBuffer class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_STREAMBUFFER_HPP_
+#define ABCG_STREAMBUFFER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "abcg_external.hpp"
+
+namespace abcg {
+class StreamBuffer;
+}  // namespace abcg
+
+/**
+ * @brief abcg::StreamBuffer class.
+ *
+ * Buffer for data written by the CPU once per frame, such as vertices,
+ * instance attributes and uniform blocks.
+ *
+ * Data is appended with push(), which returns its offset in the buffer,
+ * between begin() and end(). The buffer is never reallocated, so VAOs and
+ * uniform buffer bindings can point to it once and only change offsets.
+ *
+ * With OpenGL 4.4 or ARB_buffer_storage, the buffer has three regions and
+ * is mapped once, persistently and coherently. Each frame writes to the
+ * next region, and a fence placed by end() makes the CPU wait before a
+ * region is written again while the GPU may still read it. Otherwise, as
+ * in OpenGL 4.1 and WebGL 2, begin() orphans the buffer and push() calls
+ * glBufferSubData.
+ *
+ * Data pushed is only valid until the end of the frame.
+ */
+class abcg::StreamBuffer {
+ public:
+  void create(std::size_t frameSize);
+  void destroy();
+
+  void begin();
+  [[nodiscard]] std::size_t push(const void* data, std::size_t size,
+                                 std::size_t alignment = 1);
+  void end();
+
+  /**
+   * @brief Appends a value aligned to its size, so that the offset divided
+   * by the size is an index of the buffer seen as an array of values.
+   *
+   * @param value Value to append.
+   *
+   * @return Offset of the value in bytes.
+   */
+  template <typename T>
+  [[nodiscard]] std::size_t push(const T& value) {
+    return push(&value, sizeof(T), sizeof(T));
+  }
+
+  /**
+   * @brief Appends the elements of a vector aligned to their size.
+   *
+   * @param values Elements to append.
+   *
+   * @return Offset of the first element in bytes.
+   */
+  template <typename T>
+  [[nodiscard]] std::size_t push(const std::vector<T>& values) {
+    return push(values.data(), values.size() * sizeof(T), sizeof(T));
+  }
+
+  [[nodiscard]] GLuint getBuffer() const { return m_buffer; }
+  [[nodiscard]] std::size_t getFrameSize() const { return m_frameSize; }
+  [[nodiscard]] std::size_t getUniformAlignment() const {
+    return m_uniformAlignment;
+  }
+  [[nodiscard]] bool isPersistent() const { return m_mapping != nullptr; }
+
+ private:
+  // Number of frames the GPU may be behind the CPU
+  static constexpr std::size_t m_numRegions{3};
+
+  GLuint m_buffer{};
+  std::size_t m_frameSize{};
+  std::size_t m_uniformAlignment{1};
+
+  // Start of the persistently mapped buffer, or nullptr if orphaning
+  std::byte* m_mapping{};
+  std::array<GLsync, m_numRegions> m_fences{};
+  std::size_t m_region{};
+
+  // Offset of the next push() in the current region
+  std::size_t m_offset{};
+};
+
+#endif
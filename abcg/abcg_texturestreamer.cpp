@@ -0,0 +1,394 @@
+/**
+ * @file abcg_texturestreamer.cpp
+ * @brief Definition of abcg::TextureStreamer class members.
+ *
+ * This project is released under the MIT License.
+ */
+
+#include "abcg_texturestreamer.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cppitertools/itertools.hpp>
+#include <limits>
+
+#include "abcg_exception.hpp"
+
+namespace {
+#if defined(__EMSCRIPTEN__)
+// No worker threads without pthreads: decode on the first call to update()
+constexpr auto decodeLaunchPolicy{std::launch::deferred};
+#else
+constexpr auto decodeLaunchPolicy{std::launch::async};
+#endif
+
+// Decodes the images of the layers of a texture and joins their mipmap
+// chains, one layer after the other in each level
+std::vector<abcg::opengl::ImageLevel> decodeLayers(
+    const std::vector<std::string>& paths, int layerSize) {
+  std::vector<abcg::opengl::ImageLevel> levels;
+  for (const auto& path : paths) {
+    auto layer{abcg::opengl::loadMipChain(path, layerSize, layerSize)};
+    if (levels.empty()) {
+      levels = std::move(layer);
+      continue;
+    }
+    for (auto&& [level, image] : iter::zip(levels, layer)) {
+      level.pixels.insert(level.pixels.end(), image.pixels.begin(),
+                          image.pixels.end());
+    }
+  }
+  return levels;
+}
+
+// Specifies a level of the texture bound to target. A level of size zero
+// releases its storage
+void specifyLevel(GLenum target, std::size_t level, int width, int height,
+                  int layers, const void* pixels) {
+  if (target == GL_TEXTURE_2D_ARRAY) {
+    glTexImage3D(target, static_cast<GLint>(level), GL_RGBA8, width, height,
+                 layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  } else {
+    glTexImage2D(target, static_cast<GLint>(level), GL_RGBA8, width, height,
+                 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+  }
+}
+}  // namespace
+
+/**
+ * @brief Creates a 2D texture and starts decoding its image in the
+ * background.
+ *
+ * The texture can be bound right away. It samples as opaque white until the
+ * image is decoded and its smallest mipmap levels are uploaded by update().
+ *
+ * @param path Path to the image file.
+ *
+ * @return Texture name.
+ */
+GLuint abcg::TextureStreamer::load(std::string_view path) {
+  return create(GL_TEXTURE_2D, {std::string{path}}, 0);
+}
+
+/**
+ * @brief Creates a GL_TEXTURE_2D_ARRAY with one layer per image and starts
+ * decoding the images in the background.
+ *
+ * The layer of each image is its index in paths, as in
+ * abcg::opengl::loadTextureArray(). The texture can be bound right away.
+ * All layers sample as opaque white until the images are decoded and their
+ * smallest mipmap levels are uploaded by update().
+ *
+ * @param paths Paths to the image files.
+ * @param layerSize Width and height each image is resized to.
+ *
+ * @return Texture name of the array.
+ *
+ * @throw abcg::Exception if paths is empty or layerSize is not positive.
+ */
+GLuint abcg::TextureStreamer::loadArray(const std::vector<std::string>& paths,
+                                        int layerSize) {
+  if (paths.empty() || layerSize <= 0) {
+    throw abcg::Exception{
+        abcg::Exception::Runtime("Invalid texture array parameters")};
+  }
+  return create(GL_TEXTURE_2D_ARRAY, paths, layerSize);
+}
+
+/**
+ * @brief Binds a texture to a texture unit and marks it as used.
+ *
+ * @param unit Texture unit index, starting from 0.
+ * @param textureID Texture name. May be a 2D texture not created by this
+ * streamer.
+ */
+void abcg::TextureStreamer::bind(GLuint unit, GLuint textureID) {
+  glActiveTexture(GL_TEXTURE0 + unit);
+
+  auto it{m_textures.find(textureID)};
+  if (it == m_textures.end()) {
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    return;
+  }
+  glBindTexture(it->second.target, textureID);
+  it->second.lastUsedFrame = m_frame;
+}
+
+/**
+ * @brief Uploads decoded images and streams in finer mipmap levels.
+ *
+ * Must be called once per frame after the textures of the frame were bound.
+ * At most setLevelsPerFrame() levels are uploaded per call, starting with
+ * the most recently used textures. Only textures bound in this frame or
+ * in the previous one are streamed.
+ *
+ * @throw abcg::Exception if an image failed to load. The corresponding
+ * texture is released.
+ */
+void abcg::TextureStreamer::update() {
+  // Finish decoded images
+  for (auto& [textureID, texture] : m_textures) {
+    if (!texture.pending.valid()) continue;
+    if (texture.pending.wait_for(std::chrono::seconds{0}) ==
+        std::future_status::timeout) {
+      continue;
+    }
+    try {
+      finishLoading(textureID, texture);
+    } catch (...) {
+      release(textureID);
+      throw;
+    }
+  }
+
+  // The budget may have been lowered. Any texture can be evicted then
+  if (m_residentBytes > m_budget) {
+    makeRoom(0, std::numeric_limits<std::uint64_t>::max());
+  }
+
+  // Textures used lately with levels still to stream, most recently used
+  // first. Ties are broken in favor of the coarsest ones. The pixels of the
+  // textures not used lately are not kept meanwhile
+  std::vector<std::pair<GLuint, Texture*>> candidates;
+  for (auto& [textureID, texture] : m_textures) {
+    if (texture.pending.valid() || texture.baseLevel == 0 ||
+        texture.baseLevel >= texture.levels.size()) {
+      continue;
+    }
+    if (texture.lastUsedFrame + 1 < m_frame) {
+      discardPixels(texture);
+      continue;
+    }
+    candidates.emplace_back(textureID, &texture);
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const auto& lhs, const auto& rhs) {
+              if (lhs.second->lastUsedFrame != rhs.second->lastUsedFrame) {
+                return lhs.second->lastUsedFrame > rhs.second->lastUsedFrame;
+              }
+              return lhs.second->baseLevel > rhs.second->baseLevel;
+            });
+
+  auto uploads{0};
+  for (auto& [textureID, texture] : candidates) {
+    if (uploads >= m_levelsPerFrame) break;
+
+    const auto level{texture->baseLevel - 1};
+    const auto size{getLevelSize(*texture, level)};
+    if (!canMakeRoom(size, texture->lastUsedFrame)) {
+      // Nothing used less recently can be evicted for the level
+      discardPixels(*texture);
+      continue;
+    }
+    if (texture->levels.at(level).pixels.empty()) {
+      // The level was evicted or its pixels discarded
+      decode(*texture);
+      continue;
+    }
+    makeRoom(size, texture->lastUsedFrame);
+    uploadLevel(textureID, *texture, level);
+    ++uploads;
+  }
+
+  ++m_frame;
+}
+
+/**
+ * @brief Deletes a texture created by load() or loadArray().
+ *
+ * @param textureID Texture name.
+ */
+void abcg::TextureStreamer::release(GLuint textureID) {
+  auto it{m_textures.find(textureID)};
+  if (it == m_textures.end()) return;
+
+  auto& texture{it->second};
+  if (texture.pending.valid()) texture.pending.wait();
+  for (auto level : iter::range(texture.baseLevel, texture.levels.size())) {
+    m_residentBytes -= getLevelSize(texture, level);
+  }
+
+  glDeleteTextures(1, &textureID);
+  m_textures.erase(it);
+}
+
+/**
+ * @brief Deletes all textures created by load() and loadArray().
+ */
+void abcg::TextureStreamer::clear() {
+  while (!m_textures.empty()) {
+    release(m_textures.begin()->first);
+  }
+}
+
+// Creates a texture with a white placeholder texel in each layer and starts
+// decoding its images
+GLuint abcg::TextureStreamer::create(GLenum target,
+                                     std::vector<std::string> paths,
+                                     int layerSize) {
+  GLuint textureID{};
+  glGenTextures(1, &textureID);
+  glBindTexture(target, textureID);
+
+  // Placeholder texels
+  const std::vector<GLubyte> white(paths.size() * 4, 255);
+  specifyLevel(target, 0, 1, 1, static_cast<int>(paths.size()), white.data());
+  glTexParameteri(target, GL_TEXTURE_BASE_LEVEL, 0);
+  glTexParameteri(target, GL_TEXTURE_MAX_LEVEL, 0);
+
+  // Set texture filtering
+  glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+  // Set texture wrapping
+  glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_REPEAT);
+  glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_REPEAT);
+
+  glBindTexture(target, 0);
+
+  auto& texture{m_textures[textureID]};
+  texture.target = target;
+  texture.paths = std::move(paths);
+  texture.layerSize = layerSize;
+  texture.lastUsedFrame = m_frame;
+  decode(texture);
+
+  return textureID;
+}
+
+// Starts decoding the images of a texture in the background
+void abcg::TextureStreamer::decode(Texture& texture) {
+  texture.pending = std::async(decodeLaunchPolicy, decodeLayers,
+                               texture.paths, texture.layerSize);
+}
+
+void abcg::TextureStreamer::finishLoading(GLuint textureID, Texture& texture) {
+  auto levels{texture.pending.get()};
+
+  // Decoded again for evicted levels: keep the pixels of those not resident
+  if (!texture.levels.empty()) {
+    if (levels.size() != texture.levels.size()) {
+      throw abcg::Exception{abcg::Exception::Runtime(fmt::format(
+          "Images of texture {} changed while streaming", textureID))};
+    }
+    for (auto level : iter::range(texture.baseLevel)) {
+      texture.levels.at(level).pixels = std::move(levels.at(level).pixels);
+    }
+    return;
+  }
+
+  texture.levels = std::move(levels);
+
+  // Upload the levels that are always resident, smallest first
+  const auto numLevels{texture.levels.size()};
+  texture.baseLevel = numLevels;
+  glBindTexture(texture.target, textureID);
+  glTexParameteri(texture.target, GL_TEXTURE_MAX_LEVEL,
+                  static_cast<GLint>(numLevels - 1));
+  glBindTexture(texture.target, 0);
+  for (auto level{numLevels}; level > 0; --level) {
+    const auto& image{texture.levels.at(level - 1)};
+    if (std::max(image.width, image.height) > m_minResidentSize) break;
+    uploadLevel(textureID, texture, level - 1);
+  }
+}
+
+void abcg::TextureStreamer::uploadLevel(GLuint textureID, Texture& texture,
+                                        std::size_t level) {
+  auto& image{texture.levels.at(level)};
+
+  glBindTexture(texture.target, textureID);
+  specifyLevel(texture.target, level, image.width, image.height,
+               static_cast<int>(texture.paths.size()), image.pixels.data());
+  glTexParameteri(texture.target, GL_TEXTURE_BASE_LEVEL,
+                  static_cast<GLint>(level));
+  glBindTexture(texture.target, 0);
+
+  texture.baseLevel = level;
+  m_residentBytes += getLevelSize(texture, level);
+  image.pixels = {};
+}
+
+void abcg::TextureStreamer::evictLevel(GLuint textureID, Texture& texture) {
+  const auto level{texture.baseLevel};
+
+  // Raise the base level first so the texture stays complete, then release
+  // the storage of the evicted level with a zero-sized image
+  glBindTexture(texture.target, textureID);
+  glTexParameteri(texture.target, GL_TEXTURE_BASE_LEVEL,
+                  static_cast<GLint>(level + 1));
+  specifyLevel(texture.target, level, 0, 0, 0, nullptr);
+  glBindTexture(texture.target, 0);
+
+  texture.baseLevel = level + 1;
+  m_residentBytes -= getLevelSize(texture, level);
+}
+
+// Whether evicting the finest levels of the textures used before the given
+// frame would make the given amount of bytes fit in the budget
+bool abcg::TextureStreamer::canMakeRoom(std::size_t bytes,
+                                        std::uint64_t requesterFrame) const {
+  std::size_t evictableBytes{};
+  for (const auto& [textureID, texture] : m_textures) {
+    if (!isEvictable(texture) || texture.lastUsedFrame >= requesterFrame) {
+      continue;
+    }
+    for (auto level : iter::range(texture.baseLevel, texture.levels.size())) {
+      const auto& image{texture.levels.at(level)};
+      if (std::max(image.width, image.height) <= m_minResidentSize) break;
+      evictableBytes += getLevelSize(texture, level);
+    }
+  }
+  return m_residentBytes + bytes <= m_budget + evictableBytes;
+}
+
+// Evicts the finest levels of the textures used before the given frame,
+// least recently used first, until the given amount of bytes fits in the
+// budget or nothing is left to evict
+void abcg::TextureStreamer::makeRoom(std::size_t bytes,
+                                     std::uint64_t requesterFrame) {
+  while (m_residentBytes + bytes > m_budget) {
+    std::pair<GLuint, Texture*> victim{};
+    for (auto& [textureID, texture] : m_textures) {
+      if (!isEvictable(texture) || texture.lastUsedFrame >= requesterFrame) {
+        continue;
+      }
+      if (victim.second == nullptr ||
+          texture.lastUsedFrame < victim.second->lastUsedFrame) {
+        victim = {textureID, &texture};
+      }
+    }
+    if (victim.second == nullptr) return;
+
+    evictLevel(victim.first, *victim.second);
+  }
+}
+
+// Releases the pixels of the levels that are not resident
+void abcg::TextureStreamer::discardPixels(Texture& texture) {
+  for (auto level : iter::range(texture.baseLevel)) {
+    texture.levels.at(level).pixels = {};
+  }
+}
+
+// Size of a level of all layers in GPU memory, also when its pixels are not
+// in CPU memory
+std::size_t abcg::TextureStreamer::getLevelSize(const Texture& texture,
+                                                std::size_t level) {
+  const auto& image{texture.levels.at(level)};
+  return static_cast<std::size_t>(image.width) *
+         static_cast<std::size_t>(image.height) * 4 * texture.paths.size();
+}
+
+// Whether the finest resident level of a texture can be evicted. The
+// levels that are always resident can't
+bool abcg::TextureStreamer::isEvictable(const Texture& texture) {
+  if (texture.pending.valid() ||
+      texture.baseLevel >= texture.levels.size()) {
+    return false;
+  }
+  const auto& image{texture.levels.at(texture.baseLevel)};
+  return std::max(image.width, image.height) > m_minResidentSize;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file abcg_texturestreamer.hpp
+ * @brief abcg::TextureStreamer header file.
+ *
+ * Declaration of abcg::TextureStreamer class.
+ *
+ * This project is released under the MIT License.
+ */
+
+#ifndef ABCG_TEXTURESTREAMER_HPP_
+#define ABCG_TEXTURESTREAMER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "abcg_external.hpp"
+#include "abcg_image.hpp"
+
+namespace abcg {
+class TextureStreamer;
+}  // namespace abcg
+
+/**
+ * @brief abcg::TextureStreamer class.
+ *
+ * Loads 2D textures and 2D texture arrays progressively within a texture
+ * memory budget.
+ *
+ * Images are decoded on worker threads and only the smallest mipmap levels
+ * are uploaded at first. Each call to update() uploads one finer level of
+ * the textures bound in the current or the previous frame, giving priority
+ * to the textures bound most recently. The range of resident levels is
+ * exposed to the sampler through GL_TEXTURE_BASE_LEVEL and
+ * GL_TEXTURE_MAX_LEVEL. When an upload would exceed the budget, the finest
+ * levels of the textures bound less recently are evicted. They are
+ * streamed in again once the textures are used. Levels that don't fit
+ * are not uploaded, and lowering the budget evicts the finest levels of
+ * the least recently used textures in the next update().
+ *
+ * The pixels of a level are kept in CPU memory only until the level is
+ * uploaded, or until it is found not to fit in the budget or its texture
+ * is no longer used. Levels needed again are decoded anew from the image
+ * files, which must therefore remain available until the texture is
+ * released.
+ *
+ * Textures must be bound with bind() so that their use is tracked. All
+ * members must be called from the thread that owns the OpenGL context.
+ */
+class abcg::TextureStreamer {
+ public:
+  [[nodiscard]] GLuint load(std::string_view path);
+  [[nodiscard]] GLuint loadArray(const std::vector<std::string>& paths,
+                                 int layerSize);
+  void bind(GLuint unit, GLuint textureID);
+  void update();
+  void release(GLuint textureID);
+  void clear();
+
+  void setBudget(std::size_t bytes) { m_budget = bytes; }
+  void setLevelsPerFrame(int levels) { m_levelsPerFrame = levels; }
+  [[nodiscard]] std::size_t getBudget() const { return m_budget; }
+  [[nodiscard]] std::size_t getResidentBytes() const {
+    return m_residentBytes;
+  }
+
+ private:
+  struct Texture {
+    GLenum target{GL_TEXTURE_2D};
+    // One path per layer. Layers are resized to layerSize x layerSize, or
+    // keep the size of the image if layerSize is 0
+    std::vector<std::string> paths;
+    int layerSize{};
+    std::future<std::vector<opengl::ImageLevel>> pending;
+    // Levels of all layers, one layer after the other. Pixels are empty
+    // for the levels uploaded, evicted or discarded
+    std::vector<opengl::ImageLevel> levels;
+    // Finest level in GPU memory. Equal to levels.size() if none
+    std::size_t baseLevel{};
+    std::uint64_t lastUsedFrame{};
+  };
+
+  // Levels with both dimensions up to this size are always resident
+  static constexpr int m_minResidentSize{64};
+
+  std::unordered_map<GLuint, Texture> m_textures;
+  std::size_t m_budget{256 * 1024 * 1024};
+  std::size_t m_residentBytes{};
+  std::uint64_t m_frame{};
+  int m_levelsPerFrame{1};
+
+  [[nodiscard]] GLuint create(GLenum target, std::vector<std::string> paths,
+                              int layerSize);
+  void decode(Texture& texture);
+  void finishLoading(GLuint textureID, Texture& texture);
+  void uploadLevel(GLuint textureID, Texture& texture, std::size_t level);
+  void evictLevel(GLuint textureID, Texture& texture);
+  [[nodiscard]] bool canMakeRoom(std::size_t bytes,
+                                 std::uint64_t requesterFrame) const;
+  void makeRoom(std::size_t bytes, std::uint64_t requesterFrame);
+  static void discardPixels(Texture& texture);
+  [[nodiscard]] static std::size_t getLevelSize(const Texture& texture,
+                                                std::size_t level);
+  [[nodiscard]] static bool isEvictable(const Texture& texture);
+};
+
+#endif
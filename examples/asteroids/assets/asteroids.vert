@@ -0,0 +1,46 @@
+#version 410
+
+// Per-asteroid attributes, shared by its 9 wrap-around copies
+layout(location = 0) in vec4 inColor;
+layout(location = 1) in vec2 inTranslation;
+layout(location = 2) in float inRotation;
+layout(location = 3) in float inScale;
+layout(location = 4) in float inPolygonSides;
+layout(location = 5) in vec4 inRadii0;
+layout(location = 6) in vec4 inRadii1;
+layout(location = 7) in vec4 inRadii2;
+layout(location = 8) in vec4 inRadii3;
+layout(location = 9) in vec4 inRadii4;
+
+out vec4 fragColor;
+
+const float twoPi = 6.28318530718;
+
+void main() {
+  fragColor = inColor;
+
+  // Copy of the asteroid in the 3x3 grid of screens around the visible one
+  int copy = gl_InstanceID % 9;
+  vec2 translation = inTranslation + vec2(copy % 3 - 1, copy / 3 - 1) * 2.0;
+
+  // Copies whose bounding circle is entirely off-screen collapse to a
+  // single point outside the clip volume and produce no fragments
+  if (any(greaterThan(abs(translation), vec2(1.0 + inScale)))) {
+    gl_Position = vec4(0, 0, 2, 1);
+    return;
+  }
+
+  // Vertex 0 is the center of the fan. The others go around the polygon
+  // and those past the last side repeat the first vertex
+  vec2 position = vec2(0);
+  if (gl_VertexID > 0) {
+    int sides = int(inPolygonSides);
+    int side = min(gl_VertexID - 1, sides) % sides;
+    vec4 radii[5] = vec4[5](inRadii0, inRadii1, inRadii2, inRadii3, inRadii4);
+    float radius = radii[side / 4][side % 4];
+    float angle = float(side) * twoPi / float(sides) + inRotation;
+    position = radius * vec2(cos(angle), sin(angle));
+  }
+
+  gl_Position = vec4(position * inScale + translation, 0, 1);
+}
@@ -0,0 +1,64 @@
+#version 410
+
+// Must match the number of star layers
+const int numLayers = 5;
+
+uniform vec2 viewportSize;
+uniform int seed;
+uniform vec2 translations[numLayers];
+uniform float pointSizes[numLayers];
+// Stars of each layer are placed in a grid with this many cells per unit
+// of the normalized device coordinates, at most one star per cell. Whole
+// numbers, so that the grid wraps around with the screen
+uniform float cellsPerUnit[numLayers];
+// Probability of a cell having a star
+uniform float densities[numLayers];
+
+out vec4 outColor;
+
+// 4D hash by Jarzynski and Olano, "Hash Functions for GPU Rendering", JCGT
+// 2020
+uvec4 pcg4d(uvec4 v) {
+  v = v * 1664525u + 1013904223u;
+  v.x += v.y * v.w;
+  v.y += v.z * v.x;
+  v.z += v.x * v.y;
+  v.w += v.y * v.z;
+  v ^= v >> 16u;
+  v.x += v.y * v.w;
+  v.y += v.z * v.x;
+  v.z += v.x * v.y;
+  v.w += v.y * v.z;
+  return v;
+}
+
+void main() {
+  vec2 ndc = gl_FragCoord.xy / viewportSize * 2.0 - 1.0;
+
+  vec3 color = vec3(0);
+  for (int layer = 0; layer < numLayers; ++layer) {
+    float cells = cellsPerUnit[layer];
+    vec2 position = (ndc - translations[layer]) * cells;
+    vec2 cell = floor(position);
+
+    // Cells repeat every 2 units, as the screen does when wrapping around
+    uvec2 wrappedCell = uvec2(mod(cell, 2.0 * cells));
+    vec4 random =
+        vec4(pcg4d(uvec4(wrappedCell, uint(layer), uint(seed))) >> 8u) /
+        16777216.0;
+    if (random.x >= densities[layer]) continue;
+
+    // Radius of the star in cell units. The star is kept inside its cell
+    // so that only the cell of the fragment has to be checked
+    vec2 radius = pointSizes[layer] / viewportSize * cells;
+    vec2 margin = min(radius, vec2(0.5));
+    vec2 center = cell + mix(margin, 1.0 - margin, random.yz);
+
+    // Same falloff as a point sprite of stars.frag
+    float starDistance = length((position - center) / radius);
+    float intensity = max(1.0 - starDistance, 0.0);
+    color += vec3(mix(0.5, 1.0, random.w)) * intensity;
+  }
+
+  outColor = vec4(color, 1);
+}
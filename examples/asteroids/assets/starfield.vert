@@ -0,0 +1,7 @@
+#version 410
+
+void main() {
+  // Triangle covering the whole viewport: (-1,-1), (3,-1) and (-1,3)
+  vec2 position = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  gl_Position = vec4(position * 2.0 - 1.0, 0, 1);
+}
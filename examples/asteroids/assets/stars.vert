@@ -9,7 +9,11 @@ uniform float pointSize;
 out vec4 fragColor;
 
 void main() {
+  // Copy of the layer in the 3x3 grid of screens around the visible one
+  int copy = gl_InstanceID % 9;
+  vec2 offset = vec2(copy % 3 - 1, copy / 3 - 1) * 2.0;
+
   gl_PointSize = pointSize;
-  gl_Position = vec4(inPosition.xy + translation, 0, 1);
+  gl_Position = vec4(inPosition.xy + translation + offset, 0, 1);
   fragColor = vec4(inColor, 1);
 }
\ No newline at end of file
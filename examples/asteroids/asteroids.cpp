@@ -1,6 +1,8 @@
 #include "asteroids.hpp"
 
 #include <cppitertools/itertools.hpp>
+#include <cstddef>
+#include <fmt/core.h>
 #include <glm/gtx/fast_trigonometry.hpp>
 
 void Asteroids::initializeGL(GLuint program, int quantity) {
@@ -11,10 +13,22 @@ void Asteroids::initializeGL(GLuint program, int quantity) {
   m_randomEngine.seed(seed);
 
   m_program = program;
-  m_colorLoc = glGetUniformLocation(m_program, "color");
-  m_rotationLoc = glGetUniformLocation(m_program, "rotation");
-  m_scaleLoc = glGetUniformLocation(m_program, "scale");
-  m_translationLoc = glGetUniformLocation(m_program, "translation");
+
+  // Get location of attributes in the program
+  m_colorAttribute = glGetAttribLocation(m_program, "inColor");
+  m_translationAttribute = glGetAttribLocation(m_program, "inTranslation");
+  m_rotationAttribute = glGetAttribLocation(m_program, "inRotation");
+  m_scaleAttribute = glGetAttribLocation(m_program, "inScale");
+  m_sidesAttribute = glGetAttribLocation(m_program, "inPolygonSides");
+  static_assert(maxPolygonSides % 4 == 0);
+  for (auto &&[i, attribute] : iter::enumerate(m_radiiAttributes)) {
+    auto name{fmt::format("inRadii{}", i)};
+    attribute = glGetAttribLocation(m_program, name.c_str());
+  }
+
+  // Create VAO. Its attributes are set up when drawing, as the instances
+  // are at a different offset of the stream buffer in each frame
+  glGenVertexArrays(1, &m_vao);
 
   // Create asteroids
   m_asteroids.clear();
@@ -31,37 +45,36 @@ void Asteroids::initializeGL(GLuint program, int quantity) {
   }
 }
 
-void Asteroids::paintGL() {
-  glUseProgram(m_program);
+void Asteroids::paintGL(abcg::StreamBuffer &streamBuffer) {
+  if (m_asteroids.empty()) return;
 
+  m_instances.clear();
   for (auto &asteroid : m_asteroids) {
-    glBindVertexArray(asteroid.m_vao);
-
-    glUniform4fv(m_colorLoc, 1, &asteroid.m_color.r);
-    glUniform1f(m_scaleLoc, asteroid.m_scale);
-    glUniform1f(m_rotationLoc, asteroid.m_rotation);
+    m_instances.push_back(
+        {.color = asteroid.m_color,
+         .translation = asteroid.m_translation,
+         .rotation = asteroid.m_rotation,
+         .scale = asteroid.m_scale,
+         .polygonSides = static_cast<float>(asteroid.m_polygonSides),
+         .radii = asteroid.m_radii});
+  }
 
-    for (auto i : {-2, 0, 2}) {
-      for (auto j : {-2, 0, 2}) {
-        glUniform2f(m_translationLoc, asteroid.m_translation.x + j,
-                    asteroid.m_translation.y + i);
+  auto offset{streamBuffer.push(m_instances)};
+  setupInstanceAttributes(streamBuffer.getBuffer(), offset);
 
-        glDrawArrays(GL_TRIANGLE_FAN, 0, asteroid.m_polygonSides + 2);
-      }
-    }
+  glUseProgram(m_program);
+  glBindVertexArray(m_vao);
 
-    glBindVertexArray(0);
-  }
+  // All copies of all asteroids in a single draw call. The vertex shader
+  // offsets each copy and discards those that are off-screen
+  glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, maxPolygonSides + 2,
+                        static_cast<GLsizei>(m_instances.size() * 9));
 
+  glBindVertexArray(0);
   glUseProgram(0);
 }
 
-void Asteroids::terminateGL() {
-  for (auto asteroid : m_asteroids) {
-    glDeleteBuffers(1, &asteroid.m_vbo);
-    glDeleteVertexArrays(1, &asteroid.m_vao);
-  }
-}
+void Asteroids::terminateGL() { glDeleteVertexArrays(1, &m_vao); }
 
 void Asteroids::update(const Ship &ship, float deltaTime) {
   for (auto &asteroid : m_asteroids) {
@@ -78,6 +91,36 @@ void Asteroids::update(const Ship &ship, float deltaTime) {
   }
 }
 
+// Each asteroid is drawn as 9 instances, one per wrap-around copy, so its
+// attributes advance every 9 instances. OpenGL 4.1 has no base instance, so
+// the attributes point to the offset of the first instance
+void Asteroids::setupInstanceAttributes(GLuint buffer, std::size_t offset) {
+  glBindVertexArray(m_vao);
+
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  auto setInstanceAttribute{[offset](GLint attribute, GLint size,
+                                     std::size_t attributeOffset) {
+    glEnableVertexAttribArray(attribute);
+    glVertexAttribPointer(attribute, size, GL_FLOAT, GL_FALSE,
+                          sizeof(Instance),
+                          reinterpret_cast<void *>(offset + attributeOffset));
+    glVertexAttribDivisor(attribute, 9);
+  }};
+  setInstanceAttribute(m_colorAttribute, 4, offsetof(Instance, color));
+  setInstanceAttribute(m_translationAttribute, 2,
+                       offsetof(Instance, translation));
+  setInstanceAttribute(m_rotationAttribute, 1, offsetof(Instance, rotation));
+  setInstanceAttribute(m_scaleAttribute, 1, offsetof(Instance, scale));
+  setInstanceAttribute(m_sidesAttribute, 1, offsetof(Instance, polygonSides));
+  for (auto &&[i, attribute] : iter::enumerate(m_radiiAttributes)) {
+    setInstanceAttribute(attribute, 4,
+                         offsetof(Instance, radii) + i * 4 * sizeof(float));
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glBindVertexArray(0);
+}
+
 Asteroids::Asteroid Asteroids::createAsteroid(glm::vec2 translation,
                                               float scale) {
   Asteroid asteroid;
@@ -104,40 +147,11 @@ Asteroids::Asteroid Asteroids::createAsteroid(glm::vec2 translation,
   glm::vec2 direction{m_randomDist(re), m_randomDist(re)};
   asteroid.m_velocity = glm::normalize(direction) / 7.0f;
 
-  // Create geometry
-  std::vector<glm::vec2> positions(0);
-  positions.emplace_back(0, 0);
-  auto step{M_PI * 2 / asteroid.m_polygonSides};
+  // Choose the distance of each vertex to the center
   std::uniform_real_distribution<float> randomRadius(0.8f, 1.0f);
-  for (auto angle : iter::range(0.0, M_PI * 2, step)) {
-    auto radius{randomRadius(re)};
-    positions.emplace_back(radius * std::cos(angle), radius * std::sin(angle));
+  for (auto i : iter::range(asteroid.m_polygonSides)) {
+    asteroid.m_radii.at(i) = randomRadius(re);
   }
-  positions.push_back(positions.at(1));
-
-  // Generate VBO
-  glGenBuffers(1, &asteroid.m_vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, asteroid.m_vbo);
-  glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec2),
-               positions.data(), GL_STATIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // Get location of attributes in the program
-  GLint positionAttribute{glGetAttribLocation(m_program, "inPosition")};
-
-  // Create VAO
-  glGenVertexArrays(1, &asteroid.m_vao);
-
-  // Bind vertex attributes to current VAO
-  glBindVertexArray(asteroid.m_vao);
-
-  glBindBuffer(GL_ARRAY_BUFFER, asteroid.m_vbo);
-  glEnableVertexAttribArray(positionAttribute);
-  glVertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // End of binding to current VAO
-  glBindVertexArray(0);
 
   return asteroid;
 }
@@ -1,6 +1,7 @@
 #ifndef ASTEROIDS_HPP_
 #define ASTEROIDS_HPP_
 
+#include <array>
 #include <list>
 #include <random>
 
@@ -13,7 +14,7 @@ class OpenGLWindow;
 class Asteroids {
  public:
   void initializeGL(GLuint program, int quantity);
-  void paintGL();
+  void paintGL(abcg::StreamBuffer &streamBuffer);
   void terminateGL();
 
   void update(const Ship &ship, float deltaTime);
@@ -21,20 +22,29 @@ class Asteroids {
  private:
   friend OpenGLWindow;
 
+  // Polygons have up to 20 sides, drawn as a fan of up to 22 vertices
+  static constexpr int maxPolygonSides{20};
+
   GLuint m_program{};
-  GLint m_colorLoc{};
-  GLint m_rotationLoc{};
-  GLint m_translationLoc{};
-  GLint m_scaleLoc{};
 
-  struct Asteroid {
-    GLuint m_vao{};
-    GLuint m_vbo{};
+  // No per-vertex data: the vertex shader builds the polygons from the
+  // instances, pushed every frame to a stream buffer
+  GLuint m_vao{};
+  GLint m_colorAttribute{};
+  GLint m_translationAttribute{};
+  GLint m_rotationAttribute{};
+  GLint m_scaleAttribute{};
+  GLint m_sidesAttribute{};
+  // Radii are passed as inRadii0, inRadii1, ... with 4 radii each
+  std::array<GLint, maxPolygonSides / 4> m_radiiAttributes{};
 
+  struct Asteroid {
     float m_angularVelocity{};
     glm::vec4 m_color{1};
     bool m_hit{false};
     int m_polygonSides{};
+    // Distance of each vertex of the polygon to its center
+    std::array<float, maxPolygonSides> m_radii{};
     float m_rotation{};
     float m_scale{};
     glm::vec2 m_translation{glm::vec2(0)};
@@ -43,9 +53,22 @@ class Asteroids {
 
   std::list<Asteroid> m_asteroids;
 
+  // Per-asteroid attributes, laid out as in asteroids.vert
+  struct Instance {
+    glm::vec4 color{};
+    glm::vec2 translation{};
+    float rotation{};
+    float scale{};
+    float polygonSides{};
+    std::array<float, maxPolygonSides> radii{};
+  };
+
+  std::vector<Instance> m_instances;
+
   std::default_random_engine m_randomEngine;
   std::uniform_real_distribution<float> m_randomDist{-1.0f, 1.0f};
 
+  void setupInstanceAttributes(GLuint buffer, std::size_t offset);
   Asteroids::Asteroid createAsteroid(glm::vec2 translation = glm::vec2(0),
                                      float scale = 0.25f);
 };
@@ -70,9 +70,18 @@ void OpenGLWindow::initializeGL() {
   // Create program to render the stars
   m_starsProgram = createProgramFromFile(getAssetsPath() + "stars.vert",
                                          getAssetsPath() + "stars.frag");
+  // Create program to render the stars procedurally
+  m_starfieldProgram =
+      createProgramFromFile(getAssetsPath() + "starfield.vert",
+                            getAssetsPath() + "starfield.frag");
   // Create program to render the other objects
   m_objectsProgram = createProgramFromFile(getAssetsPath() + "objects.vert",
                                            getAssetsPath() + "objects.frag");
+  // Create program to render all asteroids with one instanced draw call
+  m_asteroidsProgram = createProgramFromFile(getAssetsPath() + "asteroids.vert",
+                                             getAssetsPath() + "objects.frag");
+
+  m_streamBuffer.create(64 * 1024);
 
   glClearColor(0, 0, 0, 1);
 
@@ -90,9 +99,9 @@ void OpenGLWindow::initializeGL() {
 void OpenGLWindow::restart() {
   m_gameData.m_state = State::Playing;
 
-  m_starLayers.initializeGL(m_starsProgram, 25);
+  m_starLayers.initializeGL(m_starsProgram, m_starfieldProgram, 25);
   m_ship.initializeGL(m_objectsProgram);
-  m_asteroids.initializeGL(m_objectsProgram, 3);
+  m_asteroids.initializeGL(m_asteroidsProgram, 3);
   m_bullets.initializeGL(m_objectsProgram);
 }
 
@@ -123,10 +132,14 @@ void OpenGLWindow::paintGL() {
   glClear(GL_COLOR_BUFFER_BIT);
   glViewport(0, 0, m_viewportWidth, m_viewportHeight);
 
+  m_streamBuffer.begin();
+
   m_starLayers.paintGL();
-  m_asteroids.paintGL();
+  m_asteroids.paintGL(m_streamBuffer);
   m_bullets.paintGL();
   m_ship.paintGL(m_gameData);
+
+  m_streamBuffer.end();
 }
 
 void OpenGLWindow::paintUI() {
@@ -153,23 +166,49 @@ void OpenGLWindow::paintUI() {
     ImGui::PopFont();
     ImGui::End();
   }
+
+  // Starfield selection, to compare the frame time of both
+  {
+    ImGui::SetNextWindowPos(ImVec2(5, 5));
+    ImGuiWindowFlags flags{ImGuiWindowFlags_NoDecoration |
+                           ImGuiWindowFlags_AlwaysAutoResize};
+    ImGui::Begin("Stars", nullptr, flags);
+
+    auto mode{m_starLayers.getMode()};
+    if (ImGui::RadioButton("Point stars", mode == StarLayers::Mode::Points)) {
+      m_starLayers.setMode(StarLayers::Mode::Points);
+    }
+    ImGui::SameLine();
+    if (ImGui::RadioButton("Procedural stars",
+                           mode == StarLayers::Mode::Procedural)) {
+      m_starLayers.setMode(StarLayers::Mode::Procedural);
+    }
+    ImGui::Text("%.3f ms/frame", 1000.0 / ImGui::GetIO().Framerate);
+
+    ImGui::End();
+  }
 }
 
 void OpenGLWindow::resizeGL(int width, int height) {
   m_viewportWidth = width;
   m_viewportHeight = height;
 
+  m_starLayers.resizeGL(width, height);
+
   glClear(GL_COLOR_BUFFER_BIT);
 }
 
 void OpenGLWindow::terminateGL() {
   glDeleteProgram(m_starsProgram);
+  glDeleteProgram(m_starfieldProgram);
   glDeleteProgram(m_objectsProgram);
+  glDeleteProgram(m_asteroidsProgram);
 
   m_asteroids.terminateGL();
   m_bullets.terminateGL();
   m_ship.terminateGL();
   m_starLayers.terminateGL();
+  m_streamBuffer.destroy();
 }
 
 void OpenGLWindow::checkCollisions() {
@@ -22,7 +22,12 @@ class OpenGLWindow : public abcg::OpenGLWindow {
 
  private:
   GLuint m_starsProgram{};
+  GLuint m_starfieldProgram{};
   GLuint m_objectsProgram{};
+  GLuint m_asteroidsProgram{};
+
+  // Per-frame data, such as the instances of the asteroids
+  abcg::StreamBuffer m_streamBuffer;
 
   int m_viewportWidth{};
   int m_viewportHeight{};
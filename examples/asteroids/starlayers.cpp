@@ -1,8 +1,11 @@
 #include "starlayers.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <cppitertools/itertools.hpp>
 
-void StarLayers::initializeGL(GLuint program, int quantity) {
+void StarLayers::initializeGL(GLuint program, GLuint proceduralProgram,
+                              int quantity) {
   terminateGL();
 
   // Start pseudo-random number generator
@@ -13,7 +16,19 @@ void StarLayers::initializeGL(GLuint program, int quantity) {
   m_pointSizeLoc = glGetUniformLocation(m_program, "pointSize");
   m_translationLoc = glGetUniformLocation(m_program, "translation");
 
+  m_proceduralProgram = proceduralProgram;
+  m_viewportSizeLoc = glGetUniformLocation(m_proceduralProgram, "viewportSize");
+  m_seedLoc = glGetUniformLocation(m_proceduralProgram, "seed");
+  m_translationsLoc =
+      glGetUniformLocation(m_proceduralProgram, "translations");
+  m_pointSizesLoc = glGetUniformLocation(m_proceduralProgram, "pointSizes");
+  m_cellsPerUnitLoc =
+      glGetUniformLocation(m_proceduralProgram, "cellsPerUnit");
+  m_densitiesLoc = glGetUniformLocation(m_proceduralProgram, "densities");
+  glGenVertexArrays(1, &m_proceduralVAO);
+
   auto &re{m_randomEngine};
+  m_seed = std::uniform_int_distribution<int>{}(re);
   std::uniform_real_distribution<float> distPos(-1.0f, 1.0f);
   std::uniform_real_distribution<float> distIntensity(0.5f, 1.0f);
 
@@ -66,37 +81,81 @@ void StarLayers::initializeGL(GLuint program, int quantity) {
 }
 
 void StarLayers::paintGL() {
-  glUseProgram(m_program);
-
   glEnable(GL_BLEND);
   glBlendFunc(GL_ONE, GL_ONE);
 
+  if (m_mode == Mode::Procedural) {
+    paintProcedural();
+  } else {
+    paintPoints();
+  }
+
+  glDisable(GL_BLEND);
+}
+
+void StarLayers::paintPoints() {
+  glUseProgram(m_program);
+
   for (auto &layer : m_starLayers) {
     glBindVertexArray(layer.m_vao);
     glUniform1f(m_pointSizeLoc, layer.m_pointSize);
 
-    for (auto i : {-2, 0, 2}) {
-      for (auto j : {-2, 0, 2}) {
-        glUniform2f(m_translationLoc, layer.m_translation.x + j,
-                    layer.m_translation.y + i);
+    glUniform2f(m_translationLoc, layer.m_translation.x,
+                layer.m_translation.y);
 
-        glDrawArrays(GL_POINTS, 0, layer.m_quantity);
-      }
-    }
+    // The 9 wrap-around copies of the layer are instances offset by the
+    // vertex shader
+    glDrawArraysInstanced(GL_POINTS, 0, layer.m_quantity, 9);
 
     glBindVertexArray(0);
   }
 
-  glDisable(GL_BLEND);
+  glUseProgram(0);
+}
+
+void StarLayers::paintProcedural() {
+  std::array<glm::vec2, numLayers> translations{};
+  std::array<float, numLayers> pointSizes{};
+  std::array<float, numLayers> cellsPerUnit{};
+  std::array<float, numLayers> densities{};
+  for (auto &&[index, layer] : iter::enumerate(m_starLayers)) {
+    translations.at(index) = layer.m_translation;
+    pointSizes.at(index) = layer.m_pointSize;
+
+    // Same number of stars as the point layer over the 2x2 screen area
+    auto quantity{static_cast<float>(layer.m_quantity)};
+    auto cells{std::max(minCellsPerUnit,
+                        std::ceil(std::sqrt(quantity / (4.0f * maxDensity))))};
+    cellsPerUnit.at(index) = cells;
+    densities.at(index) = quantity / (4.0f * cells * cells);
+  }
 
+  glUseProgram(m_proceduralProgram);
+  glBindVertexArray(m_proceduralVAO);
+
+  glUniform2fv(m_viewportSizeLoc, 1, &m_viewportSize.x);
+  glUniform1i(m_seedLoc, m_seed);
+  glUniform2fv(m_translationsLoc, translations.size(), &translations.at(0).x);
+  glUniform1fv(m_pointSizesLoc, pointSizes.size(), pointSizes.data());
+  glUniform1fv(m_cellsPerUnitLoc, cellsPerUnit.size(), cellsPerUnit.data());
+  glUniform1fv(m_densitiesLoc, densities.size(), densities.data());
+
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+
+  glBindVertexArray(0);
   glUseProgram(0);
 }
 
+void StarLayers::resizeGL(int width, int height) {
+  m_viewportSize = glm::vec2(width, height);
+}
+
 void StarLayers::terminateGL() {
   for (auto &layer : m_starLayers) {
     glDeleteBuffers(1, &layer.m_vbo);
     glDeleteVertexArrays(1, &layer.m_vao);
   }
+  glDeleteVertexArrays(1, &m_proceduralVAO);
 }
 
 void StarLayers::update(const Ship &ship, float deltaTime) {
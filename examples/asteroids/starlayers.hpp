@@ -12,10 +12,18 @@ class OpenGLWindow;
 
 class StarLayers {
  public:
-  void initializeGL(GLuint program, int quantity);
+  // Stars drawn as point sprites from vertex buffers, or placed
+  // procedurally in the fragment shader of a fullscreen triangle
+  enum class Mode { Points, Procedural };
+
+  void initializeGL(GLuint program, GLuint proceduralProgram, int quantity);
   void paintGL();
+  void resizeGL(int width, int height);
   void terminateGL();
 
+  void setMode(Mode mode) { m_mode = mode; }
+  [[nodiscard]] Mode getMode() const { return m_mode; }
+
   void update(const Ship &ship, float deltaTime);
 
  private:
@@ -25,6 +33,22 @@ class StarLayers {
   GLint m_pointSizeLoc{};
   GLint m_translationLoc{};
 
+  Mode m_mode{Mode::Points};
+
+  GLuint m_proceduralProgram{};
+  GLint m_viewportSizeLoc{};
+  GLint m_seedLoc{};
+  GLint m_translationsLoc{};
+  GLint m_pointSizesLoc{};
+  GLint m_cellsPerUnitLoc{};
+  GLint m_densitiesLoc{};
+
+  // Empty VAO to draw the fullscreen triangle, whose vertices are computed
+  // from gl_VertexID
+  GLuint m_proceduralVAO{};
+  int m_seed{};
+  glm::vec2 m_viewportSize{1.0f};
+
   struct StarLayer {
     GLuint m_vao{};
     GLuint m_vbo{};
@@ -34,9 +58,21 @@ class StarLayers {
     glm::vec2 m_translation{glm::vec2(0)};
   };
 
-  std::array<StarLayer, 5> m_starLayers;
+  // Must match starfield.frag
+  static constexpr std::size_t numLayers{5};
+
+  // Grid of the procedural stars: at least minCellsPerUnit cells per unit,
+  // more for dense layers so that at most maxDensity of the cells have a
+  // star and the grid doesn't show
+  static constexpr float minCellsPerUnit{16.0f};
+  static constexpr float maxDensity{0.25f};
+
+  std::array<StarLayer, numLayers> m_starLayers;
 
   std::default_random_engine m_randomEngine;
+
+  void paintPoints();
+  void paintProcedural();
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+#version 410
+
+layout(location = 0) in vec2 inPosition;
+
+// Per-instance attributes
+layout(location = 1) in vec2 inTranslation;
+layout(location = 2) in vec4 inColor;
+layout(location = 3) in vec2 inArc;
+layout(location = 4) in float inHidden;
+
+uniform float scale;
+
+out vec4 fragColor;
+
+const float twoPi = 6.28318530718;
+
+void main() {
+  vec2 position = inPosition;
+
+  // Points on the circle outside the sector collapse onto the center, so
+  // their triangles are degenerate and not rasterized
+  if (position != vec2(0)) {
+    float angle = atan(position.y, position.x);
+    if (angle < 0.0) angle += twoPi;
+    bool inside = (angle >= inArc.x && angle <= inArc.y) ||
+                  (angle + twoPi >= inArc.x && angle + twoPi <= inArc.y);
+    if (!inside) position = vec2(0);
+  }
+
+  // Hidden discs collapse to a point
+  float instanceScale = inHidden != 0.0 ? 0.0 : scale;
+
+  gl_Position = vec4(position * instanceScale + inTranslation, 0, 1);
+  fragColor = inColor;
+}
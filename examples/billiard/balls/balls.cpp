@@ -8,13 +8,10 @@ glm::vec3 color(int red, int blue, int green) {
   return glm::vec3(red/255.0f, blue/255.0f, green/255.0f);
 }
 
-void Balls::initializeGL(GLuint program) {
+void Balls::initializeGL(GLuint program, GLuint circleVBO) {
   terminateGL();
 
-  m_program = program;
-  m_colorLoc = glGetUniformLocation(m_program, "color");
-  m_scaleLoc = glGetUniformLocation(m_program, "scale");
-  m_translationLoc = glGetUniformLocation(m_program, "translation");
+  m_discs.initializeGL(program, circleVBO);
   radius = 0.03f;
   
   // Create balls
@@ -23,34 +20,20 @@ void Balls::initializeGL(GLuint program) {
   createDefaultBoard();
 }
 
-void Balls::paintGL() {
-  glUseProgram(m_program);
-
+void Balls::paintGL(abcg::StreamBuffer &streamBuffer) {
+  m_instances.clear();
   for (auto &ball : m_balls) {
-    if (ball.beenPocketed) {
-      continue;
-    }
-    glBindVertexArray(ball.m_vao);
-
-    glUniform4fv(m_colorLoc, 1, &ball.m_color.r);
-    glUniform1f(m_scaleLoc, radius);
-
-    glUniform2f(m_translationLoc, ball.position.x, ball.position.y);
-
-    glDrawArrays(GL_TRIANGLE_FAN, 0, 360 + 2);
-
-    glBindVertexArray(0);
+    m_instances.push_back({.translation = ball.position,
+                           .color = ball.m_color,
+                           .hidden = ball.beenPocketed ? 1.0f : 0.0f});
   }
+  // The balls move every frame, so their instances are streamed
+  m_discs.update(streamBuffer, m_instances);
 
-  glUseProgram(0);
+  m_discs.paintGL(radius);
 }
 
-void Balls::terminateGL() {
-  for (auto ball : m_balls) {
-    glDeleteBuffers(1, &ball.m_vbo);
-    glDeleteVertexArrays(1, &ball.m_vao);
-  }
-}
+void Balls::terminateGL() { m_discs.terminateGL(); }
 
 void Balls::update(float deltaTime, GameData* gameData) {
   bool isRunning = false;
@@ -81,40 +64,6 @@ Balls::Ball Balls::createBall(glm::vec2 translation, glm::vec3 color) {
     .velocity = glm::vec2(0)
   };
 
-  // Create geometry
-  std::vector<glm::vec2> positions(0);
-  positions.emplace_back(0, 0);
-  auto step{M_PI * 2 / 360};
-  
-  for (auto angle : iter::range(0.0, M_PI * 2, step)) {
-    positions.emplace_back(std::cos(angle), std::sin(angle));
-  }
-  positions.push_back(positions.at(1));
-
-  // Generate VBO
-  glGenBuffers(1, &ball.m_vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, ball.m_vbo);
-  glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec2),
-               positions.data(), GL_STATIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // Get location of attributes in the program
-  GLint positionAttribute{glGetAttribLocation(m_program, "inPosition")};
-
-  // Create VAO
-  glGenVertexArrays(1, &ball.m_vao);
-
-  // Bind vertex attributes to current VAO
-  glBindVertexArray(ball.m_vao);
-
-  glBindBuffer(GL_ARRAY_BUFFER, ball.m_vbo);
-  glEnableVertexAttribArray(positionAttribute);
-  glVertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // End of binding to current VAO
-  glBindVertexArray(0);
-
   return ball;
 }
 
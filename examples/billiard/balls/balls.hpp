@@ -6,19 +6,17 @@
 
 #include "abcg.hpp"
 #include "../gamedata.hpp"
+#include "../discs/discs.hpp"
 
 class OpenGLWindow;
 
 class Balls {
  public:
-  void initializeGL(GLuint program);
-  void paintGL();
+  void initializeGL(GLuint program, GLuint circleVBO);
+  void paintGL(abcg::StreamBuffer& streamBuffer);
   void terminateGL();
   void update(float deltaTime, GameData* gameData);
   struct Ball {
-    GLuint m_vao{};
-    GLuint m_vbo{};
-
     glm::vec4 m_color { 1 };
 
     bool isWhite { false };
@@ -35,13 +33,13 @@ class Balls {
  private:
   friend OpenGLWindow;
 
-  GLuint m_program{};
-  GLint m_colorLoc{};
-  GLint m_translationLoc{};
-  GLint m_scaleLoc{};
   float radius{};
 
   std::list<Ball> m_balls;
+
+  // All balls are drawn with one instanced draw call
+  Discs m_discs;
+  std::vector<Discs::Instance> m_instances;
   
   // Should keep from its energy
   float frictionEffect = 0.3f;
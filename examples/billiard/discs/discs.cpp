@@ -0,0 +1,134 @@
+#include "discs.hpp"
+
+#include <cppitertools/itertools.hpp>
+#include <cstddef>
+
+GLuint Discs::createCircle() {
+  // Create geometry
+  std::vector<glm::vec2> positions(0);
+  positions.emplace_back(0, 0);
+  auto step{M_PI * 2 / 360};
+
+  for (auto i : iter::range(360)) {
+    positions.emplace_back(std::cos(i * step), std::sin(i * step));
+  }
+  positions.push_back(positions.at(1));
+
+  // Generate VBO
+  GLuint vbo{};
+  glGenBuffers(1, &vbo);
+  glBindBuffer(GL_ARRAY_BUFFER, vbo);
+  glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec2),
+               positions.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  return vbo;
+}
+
+void Discs::initializeGL(GLuint program, GLuint circleVBO) {
+  terminateGL();
+
+  m_program = program;
+  m_scaleLoc = glGetUniformLocation(m_program, "scale");
+
+  // Get location of attributes in the program
+  GLint positionAttribute{glGetAttribLocation(m_program, "inPosition")};
+  m_translationAttribute = glGetAttribLocation(m_program, "inTranslation");
+  m_colorAttribute = glGetAttribLocation(m_program, "inColor");
+  m_arcAttribute = glGetAttribLocation(m_program, "inArc");
+  m_hiddenAttribute = glGetAttribLocation(m_program, "inHidden");
+
+  glGenBuffers(1, &m_instanceVBO);
+
+  // Create VAO
+  glGenVertexArrays(1, &m_vao);
+
+  // Bind vertex attributes to current VAO
+  glBindVertexArray(m_vao);
+
+  glBindBuffer(GL_ARRAY_BUFFER, circleVBO);
+  glEnableVertexAttribArray(positionAttribute);
+  glVertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  // End of binding to current VAO
+  glBindVertexArray(0);
+
+  setupInstanceAttributes(m_instanceVBO, 0);
+}
+
+void Discs::update(const std::vector<Instance>& instances) {
+  m_count = static_cast<GLsizei>(instances.size());
+
+  glBindBuffer(GL_ARRAY_BUFFER, m_instanceVBO);
+  auto size{instances.size() * sizeof(Instance)};
+  if (instances.size() > m_capacity) {
+    // Reallocate only when the batch grows
+    m_capacity = instances.size();
+    glBufferData(GL_ARRAY_BUFFER, size, instances.data(), GL_DYNAMIC_DRAW);
+  } else {
+    glBufferSubData(GL_ARRAY_BUFFER, 0, size, instances.data());
+  }
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  setupInstanceAttributes(m_instanceVBO, 0);
+}
+
+// For batches that change every frame. The instances are only valid until
+// the end of the frame of the stream buffer
+void Discs::update(abcg::StreamBuffer& streamBuffer,
+                   const std::vector<Instance>& instances) {
+  m_count = static_cast<GLsizei>(instances.size());
+  if (m_count == 0) return;
+
+  auto offset{streamBuffer.push(instances)};
+  setupInstanceAttributes(streamBuffer.getBuffer(), offset);
+}
+
+void Discs::paintGL(float scale) {
+  if (m_count == 0) return;
+
+  glUseProgram(m_program);
+  glBindVertexArray(m_vao);
+
+  glUniform1f(m_scaleLoc, scale);
+
+  glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, numVertices, m_count);
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+}
+
+void Discs::terminateGL() {
+  glDeleteBuffers(1, &m_instanceVBO);
+  glDeleteVertexArrays(1, &m_vao);
+  m_instanceVBO = 0;
+  m_vao = 0;
+  m_count = 0;
+  m_capacity = 0;
+}
+
+// Per-instance attributes advance once per disc instead of once per vertex.
+// OpenGL 4.1 has no base instance, so the attributes point to the offset of
+// the first instance
+void Discs::setupInstanceAttributes(GLuint buffer, std::size_t offset) {
+  glBindVertexArray(m_vao);
+
+  glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  auto setInstanceAttribute{[offset](GLint attribute, GLint size,
+                                     std::size_t attributeOffset) {
+    glEnableVertexAttribArray(attribute);
+    glVertexAttribPointer(attribute, size, GL_FLOAT, GL_FALSE,
+                          sizeof(Instance),
+                          reinterpret_cast<void*>(offset + attributeOffset));
+    glVertexAttribDivisor(attribute, 1);
+  }};
+  setInstanceAttribute(m_translationAttribute, 2,
+                       offsetof(Instance, translation));
+  setInstanceAttribute(m_colorAttribute, 4, offsetof(Instance, color));
+  setInstanceAttribute(m_arcAttribute, 2, offsetof(Instance, arc));
+  setInstanceAttribute(m_hiddenAttribute, 1, offsetof(Instance, hidden));
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glBindVertexArray(0);
+}
@@ -0,0 +1,52 @@
+#ifndef DISCS_HPP_
+#define DISCS_HPP_
+
+#include <vector>
+
+#include "abcg.hpp"
+
+// Batch of discs drawn with a single instanced draw call. All batches share
+// the same unit circle, created once with createCircle(), and each one has
+// its own buffer of per-instance attributes, or pushes them every frame to a
+// stream buffer
+class Discs {
+ public:
+  struct Instance {
+    glm::vec2 translation{};
+    glm::vec4 color{1};
+    // Start and end angles of the sector drawn, in radians
+    glm::vec2 arc{0.0f, 2.0f * static_cast<float>(M_PI)};
+    // Non-zero if the disc is not drawn
+    float hidden{};
+  };
+
+  // Center, 360 points on the circle and the first one again to close the
+  // triangle fan
+  static constexpr GLsizei numVertices{362};
+  static GLuint createCircle();
+
+  void initializeGL(GLuint program, GLuint circleVBO);
+  void update(const std::vector<Instance>& instances);
+  void update(abcg::StreamBuffer& streamBuffer,
+              const std::vector<Instance>& instances);
+  void paintGL(float scale);
+  void terminateGL();
+
+ private:
+  GLuint m_program{};
+  GLint m_scaleLoc{};
+  GLint m_translationAttribute{};
+  GLint m_colorAttribute{};
+  GLint m_arcAttribute{};
+  GLint m_hiddenAttribute{};
+
+  GLuint m_vao{};
+  GLuint m_instanceVBO{};
+
+  GLsizei m_count{};
+  std::size_t m_capacity{};
+
+  void setupInstanceAttributes(GLuint buffer, std::size_t offset);
+};
+
+#endif
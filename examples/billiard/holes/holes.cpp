@@ -3,13 +3,10 @@
 #include <cppitertools/itertools.hpp>
 #include <glm/gtx/fast_trigonometry.hpp>
 
-void Holes::initializeGL(GLuint program) {
+void Holes::initializeGL(GLuint program, GLuint circleVBO) {
   terminateGL();
 
-  m_program = program;
-  m_colorLoc = glGetUniformLocation(m_program, "color");
-  m_scaleLoc = glGetUniformLocation(m_program, "scale");
-  m_translationLoc = glGetUniformLocation(m_program, "translation");
+  m_discs.initializeGL(program, circleVBO);
   radius = 0.08f;
   
   // Create Holes
@@ -38,78 +35,29 @@ void Holes::initializeGL(GLuint program) {
     m_holes.emplace_back(
     createHole(glm::vec2(0.0f, -0.48f), 0.0f, M_PI)
   );
-}
-
-void Holes::paintGL() {
-  glUseProgram(m_program);
 
+  // Holes never move, so their instances are uploaded once
+  std::vector<Discs::Instance> instances;
   for (auto &hole : m_holes) {
-    glBindVertexArray(hole.m_vao);
-
-    glUniform4fv(m_colorLoc, 1, &hole.m_color.r);
-    glUniform1f(m_scaleLoc, radius);
-
-    glUniform2f(m_translationLoc, hole.position.x, hole.position.y);
-
-    glDrawArrays(GL_TRIANGLE_FAN, 0, hole.numVertices);
-
-    glBindVertexArray(0);
+    instances.push_back({.translation = hole.position,
+                         .color = hole.m_color,
+                         .arc = hole.arc,
+                         .hidden = 0.0f});
   }
-
-  glUseProgram(0);
+  m_discs.update(instances);
 }
 
-void Holes::terminateGL() {
-  for (auto hole : m_holes) {
-    glDeleteBuffers(1, &hole.m_vbo);
-    glDeleteVertexArrays(1, &hole.m_vao);
-  }
-}
+void Holes::paintGL() { m_discs.paintGL(radius); }
 
-Holes::Hole Holes::createHole(glm::vec2 translation, double start, double end) {
-  auto step{M_PI * 2 / 180};
+void Holes::terminateGL() { m_discs.terminateGL(); }
 
+Holes::Hole Holes::createHole(glm::vec2 translation, double start, double end) {
   Hole hole {
     .m_color = glm::vec4(0.15f, 0.15f, 0.15f, 1),
     .position = translation,
+    .arc = glm::vec2(start, end),
   };
 
-  // Create geometry
-  std::vector<glm::vec2> positions(0);
-  positions.emplace_back(0, 0);
-  
-  
-  for (auto angle : iter::range(start, end, step)) {
-    positions.emplace_back(std::cos(angle), std::sin(angle));
-  }
-  positions.push_back(positions.at(1));
-
-  hole.numVertices = positions.size();
-
-  // Generate VBO
-  glGenBuffers(1, &hole.m_vbo);
-  glBindBuffer(GL_ARRAY_BUFFER, hole.m_vbo);
-  glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec2),
-               positions.data(), GL_STATIC_DRAW);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // Get location of attributes in the program
-  GLint positionAttribute{glGetAttribLocation(m_program, "inPosition")};
-
-  // Create VAO
-  glGenVertexArrays(1, &hole.m_vao);
-
-  // Bind vertex attributes to current VAO
-  glBindVertexArray(hole.m_vao);
-
-  glBindBuffer(GL_ARRAY_BUFFER, hole.m_vbo);
-  glEnableVertexAttribArray(positionAttribute);
-  glVertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-
-  // End of binding to current VAO
-  glBindVertexArray(0);
-
   return hole;
 }
 
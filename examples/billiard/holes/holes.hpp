@@ -7,34 +7,32 @@
 #include "abcg.hpp"
 #include "../gamedata.hpp"
 #include "../balls/balls.hpp"
+#include "../discs/discs.hpp"
 
 class OpenGLWindow;
 
 class Holes {
  public:
-  void initializeGL(GLuint program);
+  void initializeGL(GLuint program, GLuint circleVBO);
   void paintGL();
   void terminateGL();
   void isPocketed(Balls::Ball* ball);
   struct Hole {
-    GLuint m_vao{};
-    GLuint m_vbo{};
-
     glm::vec4 m_color { 1 };
     glm::vec2 position{glm::vec2(0)};
-    int numVertices;
+    // Start and end angles of the visible sector
+    glm::vec2 arc{glm::vec2(0)};
   };
   
  private:
   friend OpenGLWindow;
 
-  GLuint m_program{};
-  GLint m_colorLoc{};
-  GLint m_translationLoc{};
-  GLint m_scaleLoc{};
   float radius{};
 
   std::list<Hole> m_holes;
+
+  // All holes are drawn with one instanced draw call
+  Discs m_discs;
   Hole createHole(glm::vec2 translation, double start, double end);
 };
 
@@ -41,6 +41,12 @@ void OpenGLWindow::initializeGL() {
   m_objectsProgram = createProgramFromFile(getAssetsPath() + "objects.vert",
                                            getAssetsPath() + "objects.frag");
 
+  // Create program to render the balls and holes as instances of a circle
+  m_discsProgram = createProgramFromFile(getAssetsPath() + "discs.vert",
+                                         getAssetsPath() + "objects.frag");
+  m_circleVBO = Discs::createCircle();
+  m_streamBuffer.create(64 * 1024);
+
   glClearColor(0.0f, 0.0f, 0.0f, 1);
 
 #if !defined(__EMSCRIPTEN__)
@@ -58,8 +64,8 @@ void OpenGLWindow::restart() {
   m_gameData.m_state = State::Playable;
 
   m_board.initializeGL(m_objectsProgram);
-  m_balls.initializeGL(m_objectsProgram);
-  m_holes.initializeGL(m_objectsProgram);
+  m_balls.initializeGL(m_discsProgram, m_circleVBO);
+  m_holes.initializeGL(m_discsProgram, m_circleVBO);
   m_stick.initializeGL(m_stickProgram);
 }
 
@@ -102,12 +108,16 @@ void OpenGLWindow::paintGL() {
   glClear(GL_COLOR_BUFFER_BIT);
   glViewport(0, 0, m_viewportWidth, m_viewportHeight);
 
+  m_streamBuffer.begin();
+
   //m_starLayers.paintGL();
   m_board.paintBackground();
   m_holes.paintGL();
   m_board.paintGL();
-  m_balls.paintGL();
+  m_balls.paintGL(m_streamBuffer);
   m_stick.paintGL();
+
+  m_streamBuffer.end();
   
 }
 
@@ -145,8 +155,12 @@ void OpenGLWindow::resizeGL(int width, int height) {
 void OpenGLWindow::terminateGL() {
   glDeleteProgram(m_stickProgram);
   glDeleteProgram(m_objectsProgram);
+  glDeleteProgram(m_discsProgram);
 
   m_balls.terminateGL();
+  m_holes.terminateGL();
+  glDeleteBuffers(1, &m_circleVBO);
+  m_streamBuffer.destroy();
 }
 
 void OpenGLWindow::checkCollisions() {
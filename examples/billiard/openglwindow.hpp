@@ -25,6 +25,13 @@ class OpenGLWindow : public abcg::OpenGLWindow {
  private:
   GLuint m_stickProgram{};
   GLuint m_objectsProgram{};
+  GLuint m_discsProgram{};
+
+  // Unit circle shared by the balls and the holes
+  GLuint m_circleVBO{};
+
+  // Per-frame data, such as the instances of the balls
+  abcg::StreamBuffer m_streamBuffer;
 
   int m_viewportWidth{};
   int m_viewportHeight{};
@@ -0,0 +1,9 @@
+#version 410
+
+out vec4 outColor;
+
+void main() {
+  // Color writes are disabled; only the samples passing the depth test
+  // matter
+  outColor = vec4(1.0);
+}
@@ -0,0 +1,17 @@
+#version 410
+
+uniform mat4 viewProjMatrix;
+
+// Bounding box in world space
+uniform vec3 boxMin;
+uniform vec3 boxMax;
+
+void main() {
+  // Corners of the box as a triangle strip of 14 vertices covering the 6
+  // faces, from the bits of gl_VertexID
+  int bit = 1 << gl_VertexID;
+  vec3 corner = vec3((0x287a & bit) != 0, (0x02af & bit) != 0,
+                     (0x31e3 & bit) != 0);
+
+  gl_Position = viewProjMatrix * vec4(mix(boxMin, boxMax, corner), 1.0);
+}
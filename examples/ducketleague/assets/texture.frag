@@ -14,8 +14,9 @@ uniform vec4 Ia, Id, Is;
 uniform vec4 Ka, Kd, Ks;
 uniform float shininess;
 
-// Diffuse texture sampler
-uniform sampler2D diffuseTex;
+// Diffuse texture array and layer of the current material (-1 if none)
+uniform mediump sampler2DArray diffuseTex;
+uniform int diffuseLayer;
 
 out vec4 outColor;
 
@@ -36,7 +37,10 @@ vec4 BlinnPhong(vec3 N, vec3 L, vec3 V, vec2 texCoord) {
     specular = pow(angle, shininess);
   }
 
-  vec4 map_Kd = texture(diffuseTex, texCoord);
+  vec4 map_Kd = vec4(1.0);
+  if (diffuseLayer >= 0) {
+    map_Kd = texture(diffuseTex, vec3(texCoord, float(diffuseLayer)));
+  }
   vec4 map_Ka = map_Kd;
 
   vec4 diffuseColor = map_Kd * Kd * Id * lambertian;
@@ -0,0 +1,61 @@
+#version 430
+#extension GL_ARB_shader_draw_parameters : require
+
+// As texture.vert, but the model and normal matrices and the material of
+// each object drawn by abcg::GPUCuller are read from a storage buffer at
+// the base instance of the draw. The normal matrix is in world space
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+
+struct Draw {
+  mat4 modelMatrix;
+  mat3 normalMatrix;
+  vec4 Ka, Kd, Ks;
+  float shininess;
+  int diffuseLayer;
+};
+
+layout(std430, binding = 0) readonly buffer Draws { Draw draws[]; };
+
+uniform mat4 viewMatrix;
+uniform mat4 projMatrix;
+
+uniform vec4 lightDirWorldSpace;
+
+out vec3 fragV;
+out vec3 fragL;
+out vec3 fragN;
+out vec2 fragTexCoord;
+out vec3 fragPObj;
+out vec3 fragNObj;
+
+flat out vec4 fragKa;
+flat out vec4 fragKd;
+flat out vec4 fragKs;
+flat out float fragShininess;
+flat out int fragDiffuseLayer;
+
+void main() {
+  Draw draw = draws[gl_BaseInstanceARB];
+
+  vec3 P = (viewMatrix * draw.modelMatrix * vec4(inPosition, 1.0)).xyz;
+  vec3 N = mat3(viewMatrix) * draw.normalMatrix * inNormal;
+  vec3 L = -(viewMatrix * lightDirWorldSpace).xyz;
+
+  fragL = L;
+  fragV = -P;
+  fragN = N;
+  fragTexCoord = inTexCoord;
+  fragPObj = inPosition;
+  fragNObj = inNormal;
+
+  fragKa = draw.Ka;
+  fragKd = draw.Kd;
+  fragKs = draw.Ks;
+  fragShininess = draw.shininess;
+  fragDiffuseLayer = draw.diffuseLayer;
+
+  gl_Position = projMatrix * vec4(P, 1.0);
+}
@@ -0,0 +1,64 @@
+#version 430
+
+// As texture.frag, but with the material passed by texture_indirect.vert
+
+in vec3 fragN;
+in vec3 fragL;
+in vec3 fragV;
+in vec2 fragTexCoord;
+in vec3 fragPObj;
+in vec3 fragNObj;
+
+flat in vec4 fragKa;
+flat in vec4 fragKd;
+flat in vec4 fragKs;
+flat in float fragShininess;
+flat in int fragDiffuseLayer;
+
+// Light properties
+uniform vec4 Ia, Id, Is;
+
+// Diffuse texture array
+uniform mediump sampler2DArray diffuseTex;
+
+out vec4 outColor;
+
+// Blinn-Phong reflection model
+vec4 BlinnPhong(vec3 N, vec3 L, vec3 V, vec2 texCoord) {
+  N = normalize(N);
+  L = normalize(L);
+
+  // Compute lambertian term
+  float lambertian = max(dot(N, L), 0.0);
+
+  // Compute specular term
+  float specular = 0.0;
+  if (lambertian > 0.0) {
+    V = normalize(V);
+    vec3 H = normalize(L + V);
+    float angle = max(dot(H, N), 0.0);
+    specular = pow(angle, fragShininess);
+  }
+
+  vec4 map_Kd = vec4(1.0);
+  if (fragDiffuseLayer >= 0) {
+    map_Kd = texture(diffuseTex, vec3(texCoord, float(fragDiffuseLayer)));
+  }
+  vec4 map_Ka = map_Kd;
+
+  vec4 diffuseColor = map_Kd * fragKd * Id * lambertian;
+  vec4 specularColor = fragKs * Is * specular;
+  vec4 ambientColor = map_Ka * fragKa * Ia;
+
+  return ambientColor + diffuseColor + specularColor;
+}
+
+void main() {
+  vec4 color = BlinnPhong(fragN, fragL, fragV, fragTexCoord);
+
+  if (gl_FrontFacing) {
+    outColor = color;
+  } else {
+    outColor = vec4(0.15, 0.15, 0.15, 1.0);
+  }
+}
@@ -9,16 +9,16 @@ class Ball {
 
   void loadModelFromFile(std::string_view path);
 
-  std::vector<Vertex> m_vertices;
-  std::vector<GLuint> m_indices;
-
   [[nodiscard]] int getNumTriangles() const {
-    return static_cast<int>(m_indices.size()) / 3;
+    return m_mesh.getNumTriangles();
   }
 
+  [[nodiscard]] abcg::Mesh& getMesh() { return m_mesh; }
+
   void update(float deltaTime);
-  void paintGL(Camera m_camera);
-  void initializeGL(GLuint program);
+  void submit(abcg::RenderQueue& queue);
+  void initializeGL(GLuint program, abcg::GeometryPool& pool);
+  void terminateGL();
   float x();
   float y();
   float z();
@@ -30,36 +30,11 @@ class Ball {
   glm::mat4 position{1.0f};
 
  private:
-  GLuint m_VAO{};
-  GLuint m_VBO{};
-  GLuint m_EBO{};
+  abcg::Mesh m_mesh;
   GLuint m_program{};
 
-  glm::vec4 m_Ka;
-  glm::vec4 m_Kd;
-  glm::vec4 m_Ks;
-  float m_shininess;
-  GLuint m_diffuseTexture{};
-  GLuint m_normalTexture{};
-
-  bool m_hasNormals{false};
-  bool m_hasTexCoords{false};
-  
   glm::vec3 gravity{0.0f, -50.0f, 0.0f};
 
-  void loadDiffuseTexture(std::string_view path);
-  void loadNormalTexture(std::string_view path);
-
-  void computeNormals();
-  void computeTangents();
-
-  void setupVAO();
-
-  void render();
-
-  void createBuffers();
-  void standardize();
-
   void x(float value);
   void y(float value);
   void z(float value);
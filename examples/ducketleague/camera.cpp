@@ -1,38 +1,6 @@
 #include "camera.hpp"
 
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/matrix_inverse.hpp>
-
-void Camera::init(GLuint m_program, glm::mat4 position) {
-  GLint viewMatrixLoc{glGetUniformLocation(m_program, "viewMatrix")};
-  GLint projMatrixLoc{glGetUniformLocation(m_program, "projMatrix")};
-  GLint normalMatrixLoc{glGetUniformLocation(m_program, "normalMatrix")};
-  GLint lightDirLoc{glGetUniformLocation(m_program, "lightDirWorldSpace")};
-  GLint IaLoc{glGetUniformLocation(m_program, "Ia")};
-  GLint IdLoc{glGetUniformLocation(m_program, "Id")};
-  GLint IsLoc{glGetUniformLocation(m_program, "Is")};
-
-  // Set uniform variables for viewMatrix and projMatrix
-  // These matrices are used for every scene object
-  glUniformMatrix4fv(viewMatrixLoc, 1, GL_FALSE, &m_viewMatrix[0][0]);
-  glUniformMatrix4fv(projMatrixLoc, 1, GL_FALSE, &m_projMatrix[0][0]);
-
-  glm::vec4 m_lightDir{-1.0f, -1.0f, -1.0f, 0.0f};
-  glm::mat4 m_rotation{1.0f};
-  auto lightDirRotated{m_rotation * m_lightDir};
-  glm::vec4 m_Ia{1.0f};
-  glm::vec4 m_Id{1.0f};
-  glm::vec4 m_Is{1.0f};
-
-  glUniform4fv(lightDirLoc, 1, &lightDirRotated.x);
-  glUniform4fv(IaLoc, 1, &m_Ia.x);
-  glUniform4fv(IdLoc, 1, &m_Id.x);
-  glUniform4fv(IsLoc, 1, &m_Is.x);
-
-  auto modelViewMatrix{glm::mat3(m_viewMatrix * position)};
-  glm::mat3 normalMatrix{glm::inverseTranspose(modelViewMatrix)};
-  glUniformMatrix3fv(normalMatrixLoc, 1, GL_FALSE, &normalMatrix[0][0]);
-}
 
 void Camera::lookAtCar(glm::vec3 carPosition, glm::vec3 ballPosition) {
   m_at = (ballPosition + carPosition) / 2.0f;
@@ -45,6 +13,14 @@ void Camera::lookAtCar(glm::vec3 carPosition, glm::vec3 ballPosition) {
   computeViewMatrix();
 }
 
+// Height in pixels of a sphere seen by the camera
+float Camera::getProjectedSize(glm::vec3 center, float diameter,
+                               int viewportHeight) const {
+  auto distance{std::max(glm::distance(m_eye, center), 0.001f)};
+  return diameter * m_projMatrix[1][1] * static_cast<float>(viewportHeight) /
+         (2.0f * distance);
+}
+
 void Camera::computeProjectionMatrix(int width, int height) {
   m_projMatrix = glm::mat4(1.0f);
   auto aspect{static_cast<float>(width) / static_cast<float>(height)};
@@ -8,24 +8,9 @@
 
 class OpenGLWindow;
 
-struct Vertex {
-  glm::vec3 position{};
-  glm::vec3 normal{};
-  glm::vec2 texCoord{};
-  glm::vec4 tangent{};
-
-  bool operator==(const Vertex& other) const noexcept {
-    static const auto epsilon{std::numeric_limits<float>::epsilon()};
-    return glm::all(glm::epsilonEqual(position, other.position, epsilon)) &&
-           glm::all(glm::epsilonEqual(normal, other.normal, epsilon)) &&
-           glm::all(glm::epsilonEqual(texCoord, other.texCoord, epsilon));
-  }
-};
-
 class Camera {
  public:
 
-  void init(GLuint m_program, glm::mat4 position);
   void computeViewMatrix();
   void computeProjectionMatrix(int width, int height);
 
@@ -35,6 +20,12 @@ class Camera {
 
   void lookAtCar(glm::vec3 carPosition, glm::vec3 ballPosition);
 
+  [[nodiscard]] float getProjectedSize(glm::vec3 center, float diameter,
+                                       int viewportHeight) const;
+
+  [[nodiscard]] const glm::mat4& getViewMatrix() const { return m_viewMatrix; }
+  [[nodiscard]] const glm::mat4& getProjMatrix() const { return m_projMatrix; }
+
  private:
   friend OpenGLWindow;
 
@@ -10,16 +10,32 @@ class Duck {
 
   void loadModelFromFile(std::string_view path);
 
-  std::vector<Vertex> m_vertices;
-  std::vector<GLuint> m_indices;
-
   [[nodiscard]] int getNumTriangles() const {
-    return static_cast<int>(m_indices.size()) / 3;
+    return m_mesh.getNumTriangles();
   }
 
+  // Level of detail drawn in the last frame
+  [[nodiscard]] int getLOD() const { return m_lod; }
+
+  // Vertex cache efficiency of the indices before and after optimization.
+  // Zero if the optimized mesh was read from the cache
+  [[nodiscard]] const abcg::VertexCacheStatistics& getCacheStatisticsBefore()
+      const {
+    return m_cacheStatisticsBefore;
+  }
+  [[nodiscard]] const abcg::VertexCacheStatistics& getCacheStatisticsAfter()
+      const {
+    return m_cacheStatisticsAfter;
+  }
+
+  [[nodiscard]] abcg::Mesh& getMesh() { return m_mesh; }
+  [[nodiscard]] const glm::mat4& getModelMatrix() const { return position; }
+
   void update(Ball* ball);
-  void paintGL();
-  void initializeGL(GLuint program);
+  void submit(abcg::RenderQueue& queue, const Camera& camera,
+              int viewportHeight);
+  void initializeGL(GLuint program, abcg::GeometryPool& pool);
+  void terminateGL();
   
   float x();
   float y();
@@ -32,33 +48,18 @@ class Duck {
   float speed { 0.0f };
 
  private:
-  GLuint m_VAO{};
-  GLuint m_VBO{};
-  GLuint m_EBO{};
+  abcg::Mesh m_mesh;
   GLuint m_program{};
 
-  glm::mat4 position{1.0f};
+  // Level of detail drawn in the last frame
+  int m_lod{};
 
-  glm::vec3 lookDirection{ 1.0f, 0.0f, 0.0f };
-
-  glm::vec4 m_Ka;
-  glm::vec4 m_Kd;
-  glm::vec4 m_Ks;
-  float m_shininess;
-  GLuint m_diffuseTexture{};
-  GLuint m_normalTexture{};
-
-  bool m_hasNormals{false};
-  bool m_hasTexCoords{false};
+  abcg::VertexCacheStatistics m_cacheStatisticsBefore;
+  abcg::VertexCacheStatistics m_cacheStatisticsAfter;
 
-  void createBuffers();
-  void standardize();
-
-  void loadDiffuseTexture(std::string_view path);
-  void loadNormalTexture(std::string_view path);
+  glm::mat4 position{1.0f};
 
-  void computeNormals();
-  void computeTangents();
+  glm::vec3 lookDirection{ 1.0f, 0.0f, 0.0f };
 
   void x(float value);
   void y(float value);
@@ -9,43 +9,23 @@ class Field {
 
   void loadModelFromFile(std::string_view path, float offset, float scale = 1.0f);
 
-  std::vector<Vertex> m_vertices;
-  std::vector<GLuint> m_indices;
-
   [[nodiscard]] int getNumTriangles() const {
-    return static_cast<int>(m_indices.size()) / 3;
+    return m_mesh.getNumTriangles();
   }
 
-  void paintGL();
-  void initializeGL(GLuint program);
+  [[nodiscard]] abcg::Mesh& getMesh() { return m_mesh; }
+  [[nodiscard]] glm::mat4 getModelMatrix() const;
+
+  void submit(abcg::RenderQueue& queue,
+              const std::vector<std::size_t>& chunks);
+  void initializeGL(GLuint program, abcg::GeometryPool& pool);
+  void terminateGL();
 
  private:
-  float m_yoffset;
   float m_scale { 1.0f };
 
-  GLuint m_VAO{};
-  GLuint m_VBO{};
-  GLuint m_EBO{};
+  abcg::Mesh m_mesh;
   GLuint m_program{};
-
-  glm::vec4 m_Ka;
-  glm::vec4 m_Kd;
-  glm::vec4 m_Ks;
-  float m_shininess;
-  GLuint m_diffuseTexture{};
-  GLuint m_normalTexture{};
-
-  bool m_hasNormals{false};
-  bool m_hasTexCoords{false};
-
-  void standardize();
-
-  void loadDiffuseTexture(std::string_view path);
-  void loadNormalTexture(std::string_view path);
-
-  void computeNormals();
-  void computeTangents();
-  
 };
 
 #endif
\ No newline at end of file
@@ -2,26 +2,22 @@
 
 #include <fmt/core.h>
 #include <imgui.h>
-#include <tiny_obj_loader.h>
 
+#include <algorithm>
 #include <cppitertools/itertools.hpp>
 #include <glm/gtx/fast_trigonometry.hpp>
-#include <glm/gtx/hash.hpp>
-#include <unordered_map>
 
 #include "ball/ball.hpp"
 #include "field/field.hpp"
 
-// Custom specialization of std::hash injected in namespace std
-namespace std {
-  template <>
-  struct hash<Vertex> {
-    size_t operator()(Vertex const& vertex) const noexcept {
-      std::size_t h1{std::hash<glm::vec3>()(vertex.position)};
-      return h1;
-    }
-  };
-}  // namespace std
+namespace {
+// Box that bounds a mesh after a model transformation
+abcg::AABB getWorldBox(const abcg::Mesh& mesh, const glm::mat4& modelMatrix) {
+  return abcg::AABB{.boundsMin = mesh.getBoundsMin(),
+                    .boundsMax = mesh.getBoundsMax()}
+      .transform(modelMatrix);
+}
+}  // namespace
 
 void OpenGLWindow::handleEvent(SDL_Event& ev) {
   if (ev.type == SDL_KEYDOWN) {
@@ -67,18 +63,89 @@ void OpenGLWindow::initializeGL() {
     getAssetsPath() + "texture.vert",
     getAssetsPath() + "texture.frag"
   );
+  if (abcg::RenderQueue::isIndirectSupported()) {
+    m_indirectProgram =
+        createProgramFromFile(getAssetsPath() + "texture_indirect.vert",
+                              getAssetsPath() + "texture_indirect.frag");
+  }
+  m_occlusionProgram = createProgramFromFile(
+      getAssetsPath() + "occlusion.vert", getAssetsPath() + "occlusion.frag");
+  m_occlusionCuller.initializeGL(m_occlusionProgram);
+  if (abcg::GPUCuller::isSupported()) {
+    m_gpuCullProgram =
+        createComputeProgramFromFile(getAssetsPath() + "cull.comp");
+    m_depthPyramidProgram =
+        createComputeProgramFromFile(getAssetsPath() + "depthpyramid.comp");
+    m_gpuCulledProgram =
+        createProgramFromFile(getAssetsPath() + "texture_gpuculled.vert",
+                              getAssetsPath() + "texture_indirect.frag");
+    m_gpuCuller.initializeGL(m_gpuCullProgram);
+    m_depthPyramid.initializeGL(m_depthPyramidProgram);
+  }
 
   ball.loadModelFromFile(getAssetsPath() + "ball/ball.obj");
-  ball.initializeGL(m_program);
+  ball.initializeGL(m_program, m_geometryPool);
   
   duck.loadModelFromFile(getAssetsPath() + "duck/duck.obj");
-  duck.initializeGL(m_program);
+  duck.initializeGL(m_program, m_geometryPool);
 
   ground.loadModelFromFile(getAssetsPath() + "ground/field-ground.obj", -0.079f, 0.975f);
-  ground.initializeGL(m_program);
+  ground.initializeGL(m_program, m_geometryPool);
 
   field.loadModelFromFile(getAssetsPath() + "stadium/stadium.obj", -0.01f);
-  field.initializeGL(m_program);
+  field.initializeGL(m_program, m_geometryPool);
+
+  // Pack the diffuse textures into a single texture array so that the whole
+  // scene is drawn with one texture binding
+  std::vector<std::string> texturePaths;
+  for (auto* mesh : {&ball.getMesh(), &duck.getMesh(), &ground.getMesh(),
+                     &field.getMesh()}) {
+    for (auto& material : mesh->getMaterials()) {
+      const auto& path{material.diffuseTexturePath};
+      if (path.empty()) continue;
+      auto it{std::find(texturePaths.begin(), texturePaths.end(), path)};
+      material.diffuseLayer =
+          static_cast<int>(std::distance(texturePaths.begin(), it));
+      if (it == texturePaths.end()) texturePaths.push_back(path);
+    }
+  }
+
+  // The array is streamed within a memory budget. It samples as white until
+  // its first levels are decoded
+  m_textureStreamer.clear();
+  m_diffuseTextures = 0;
+  m_textureStreamer.setBudget(static_cast<std::size_t>(m_streamingBudget) *
+                              1024 * 1024);
+  if (!texturePaths.empty()) {
+    m_diffuseTextures = m_textureStreamer.loadArray(texturePaths, 1024);
+  }
+  m_sampler = abcg::opengl::getSampler({.maxAnisotropy = 8.0f});
+
+  buildSceneTree();
+
+  // The GPU culler keeps the chunks and materials it needs, so it is set
+  // up before the CPU data is released
+  if (m_gpuCullProgram != 0) {
+    m_gpuCuller.addMesh(ground.getMesh(), ground.getModelMatrix());
+    m_gpuCuller.addMesh(field.getMesh(), field.getModelMatrix());
+  }
+
+  // The geometry is only needed in the GPU buffers from now on
+  for (auto* mesh : {&ball.getMesh(), &duck.getMesh(), &ground.getMesh(),
+                     &field.getMesh()}) {
+    mesh->releaseCPUData();
+  }
+
+  // All objects share the buffers and the VAO of the pool, so drawing
+  // them needs no VAO switches
+  m_geometryPool.setupVAO(m_program);
+
+  for (auto program : {m_program, m_indirectProgram, m_gpuCulledProgram}) {
+    if (program == 0) continue;
+    glUseProgram(program);
+    glUniform1i(glGetUniformLocation(program, "diffuseTex"), 0);
+  }
+  glUseProgram(0);
   
   resizeGL(getWindowSettings().width, getWindowSettings().height);
 }
@@ -86,18 +153,187 @@ void OpenGLWindow::initializeGL() {
 void OpenGLWindow::paintGL() {
   update();
 
+  const auto viewProjMatrix{m_camera.getProjMatrix() *
+                            m_camera.getViewMatrix()};
+
+  // The draw commands of the chunks are written before the textures of
+  // the scene are bound, as culling uses texture unit 0
+  if (m_gpuCulling) m_gpuCuller.cull(viewProjMatrix, &m_depthPyramid);
+
   // Clear color buffer and depth buffer
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
   glViewport(0, 0, m_viewportWidth, m_viewportHeight);
 
-  ground.paintGL();
-  field.paintGL();
-  duck.paintGL();
-  ball.paintGL(m_camera); 
+  // Binding the texture array marks it as used by the streamer
+  m_textureStreamer.bind(0, m_diffuseTextures);
+  glBindSampler(0, m_sampler);
+
+  // Light properties, shared by all objects
+  glm::vec4 lightDir{-1.0f, -1.0f, -1.0f, 0.0f};
+  glm::vec4 Ia{1.0f};
+  glm::vec4 Id{1.0f};
+  glm::vec4 Is{1.0f};
+  for (auto program : {m_program, m_indirectProgram, m_gpuCulledProgram}) {
+    if (program == 0) continue;
+    glUseProgram(program);
+    glUniform4fv(glGetUniformLocation(program, "lightDirWorldSpace"), 1,
+                 &lightDir.x);
+    glUniform4fv(glGetUniformLocation(program, "Ia"), 1, &Ia.x);
+    glUniform4fv(glGetUniformLocation(program, "Id"), 1, &Id.x);
+    glUniform4fv(glGetUniformLocation(program, "Is"), 1, &Is.x);
+  }
+  glUseProgram(0);
+
+  if (m_gpuCulling) {
+    glUseProgram(m_gpuCulledProgram);
+    glUniformMatrix4fv(glGetUniformLocation(m_gpuCulledProgram, "viewMatrix"),
+                       1, GL_FALSE, &m_camera.getViewMatrix()[0][0]);
+    glUniformMatrix4fv(glGetUniformLocation(m_gpuCulledProgram, "projMatrix"),
+                       1, GL_FALSE, &m_camera.getProjMatrix()[0][0]);
+    m_gpuCuller.draw();
+    glUseProgram(0);
+  }
+
+  // With the indirect program, all opaque objects of the pool that share a
+  // VAO are drawn by one call, whatever their number
+  m_renderQueue.setIndirectProgram(
+      m_program, m_multiDrawIndirect ? m_indirectProgram : 0);
+
+  // The objects queue their draw calls, which are then sorted to change
+  // less state and to draw the nearest objects first
+  m_renderQueue.begin(m_camera.getViewMatrix(), m_camera.getProjMatrix());
+
+  // Only the objects and chunks whose boxes are in the view frustum are
+  // drawn. The tree only changes when the duck or the ball leave the
+  // margins of their boxes
+  m_sceneTree.move(m_sceneProxies.at(DuckObject),
+                   getWorldBox(duck.getMesh(), duck.getModelMatrix()));
+  m_sceneTree.move(m_sceneProxies.at(BallObject),
+                   getWorldBox(ball.getMesh(), ball.position));
+  m_sceneTree.query(abcg::Frustum{viewProjMatrix}, m_visibleObjects);
+  m_occlusionCuller.begin(viewProjMatrix);
+
+  m_visibleGroundChunks.clear();
+  m_visibleFieldChunks.clear();
+  auto duckVisible{false};
+  auto ballVisible{false};
+  for (auto object : m_visibleObjects) {
+    // The chunks are already drawn if culled on the GPU
+    if (m_gpuCulling && object >= FirstChunk) continue;
+    if (m_occlusionCulling && !m_occlusionCuller.isVisible(object)) continue;
+    if (object == DuckObject) {
+      duckVisible = true;
+    } else if (object == BallObject) {
+      ballVisible = true;
+    } else {
+      auto [owner, chunk]{m_sceneChunks.at(object - FirstChunk)};
+      (owner == &ground ? m_visibleGroundChunks : m_visibleFieldChunks)
+          .push_back(chunk);
+    }
+  }
+
+  // Chunks are drawn in the order of the index buffer
+  std::sort(m_visibleGroundChunks.begin(), m_visibleGroundChunks.end());
+  std::sort(m_visibleFieldChunks.begin(), m_visibleFieldChunks.end());
+  ground.submit(m_renderQueue, m_visibleGroundChunks);
+  field.submit(m_renderQueue, m_visibleFieldChunks);
+  if (duckVisible) duck.submit(m_renderQueue, m_camera, m_viewportHeight);
+  if (ballVisible) ball.submit(m_renderQueue);
+  m_renderQueue.flush();
+
+  // The boxes of all objects in the frustum, including those skipped, are
+  // tested against the depth buffer of this frame. The results are used
+  // in later frames
+  if (m_occlusionCulling) {
+    for (auto object : m_visibleObjects) {
+      if (m_gpuCulling && object >= FirstChunk) continue;
+      m_occlusionCuller.test(
+          object, m_sceneTree.getFatBox(m_sceneProxies.at(object)));
+    }
+  }
+  m_occlusionCuller.end();
+
+  glBindSampler(0, 0);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  // The depth of this frame is what the chunks are culled against in the
+  // next one
+  if (m_gpuCulling) m_depthPyramid.update(viewProjMatrix);
+
+  // Streams in the next levels of the textures used in this frame
+  m_textureStreamer.update();
 }
 
 void OpenGLWindow::paintUI() { 
   abcg::OpenGLWindow::paintUI(); 
+
+  {
+    ImGui::SetNextWindowPos(ImVec2(5, 5));
+    ImGui::SetNextWindowSize(ImVec2(220, 335));
+    ImGui::Begin("Culling", nullptr, ImGuiWindowFlags_NoDecoration);
+
+    ImGui::Checkbox("Occlusion culling", &m_occlusionCulling);
+    const auto& statistics{m_occlusionCuller.getStatistics()};
+    ImGui::Text("%zu objects in frustum", m_visibleObjects.size());
+    ImGui::Text("%zu occluded, %zu queries", statistics.occluded,
+                statistics.queries);
+
+    if (m_indirectProgram != 0) {
+      ImGui::Checkbox("Multi-draw indirect", &m_multiDrawIndirect);
+    } else {
+      ImGui::Text("Multi-draw indirect: no GL 4.3");
+    }
+    const auto& queueStatistics{m_renderQueue.getStatistics()};
+    ImGui::Text("%zu draw calls, %zu indirect", queueStatistics.drawCalls,
+                queueStatistics.indirectDraws);
+
+    if (m_gpuCullProgram != 0) {
+      // A pyramid left from an earlier frame would hide chunks wrongly
+      if (ImGui::Checkbox("GPU culling", &m_gpuCulling)) {
+        m_depthPyramid.resize(m_viewportWidth, m_viewportHeight);
+      }
+      ImGui::Text("%zu chunks, %zu indirect calls",
+                  m_gpuCuller.getNumObjects(), m_gpuCuller.getNumDrawCalls());
+    } else {
+      ImGui::Text("GPU culling: no GL 4.3");
+    }
+
+    ImGui::Text("Duck LOD %d/%d, %d triangles", duck.getLOD(),
+                duck.getMesh().getNumLODs() - 1,
+                duck.getMesh().getNumTriangles(duck.getLOD()));
+    ImGui::Text("Duck: %zu meshlets", duck.getMesh().getMeshlets().size());
+    const auto& before{duck.getCacheStatisticsBefore()};
+    const auto& after{duck.getCacheStatisticsAfter()};
+    if (after.acmr > 0.0f) {
+      ImGui::Text("Duck ACMR: %.3f -> %.3f", before.acmr, after.acmr);
+      ImGui::Text("Duck ATVR: %.3f -> %.3f", before.atvr, after.atvr);
+    } else {
+      ImGui::Text("Duck: optimized mesh cached");
+    }
+
+    // What is left of the meshes in CPU memory after the upload
+    std::size_t cpuMemory{};
+    std::size_t gpuMemory{};
+    for (const auto* mesh : {&ball.getMesh(), &duck.getMesh(),
+                             &ground.getMesh(), &field.getMesh()}) {
+      cpuMemory += mesh->getCPUMemoryUsage();
+      gpuMemory += mesh->getVertexBufferSize() + mesh->getIndexBufferSize();
+    }
+    ImGui::Text("Meshes: %zu KiB CPU, %zu KiB GPU", cpuMemory / 1024,
+                gpuMemory / 1024);
+    ImGui::Text("Pool: %zu layouts, %zu KiB", m_geometryPool.getNumArenas(),
+                m_geometryPool.getBufferSize() / 1024);
+
+    // A lower budget evicts the finest levels of the textures
+    if (ImGui::SliderInt("MiB", &m_streamingBudget, 1, 64)) {
+      m_textureStreamer.setBudget(
+          static_cast<std::size_t>(m_streamingBudget) * 1024 * 1024);
+    }
+    ImGui::Text("Textures: %zu KiB resident",
+                m_textureStreamer.getResidentBytes() / 1024);
+
+    ImGui::End();
+  }
 }
 
 void OpenGLWindow::resizeGL(int width, int height) {
@@ -105,15 +341,56 @@ void OpenGLWindow::resizeGL(int width, int height) {
   m_viewportHeight = height;
 
   m_camera.computeProjectionMatrix(width, height);
+  if (m_depthPyramidProgram != 0) m_depthPyramid.resize(width, height);
 }
 
 void OpenGLWindow::terminateGL() {
+  ball.terminateGL();
+  duck.terminateGL();
+  ground.terminateGL();
+  field.terminateGL();
+  m_geometryPool.destroy();
+  m_occlusionCuller.terminateGL();
+  glDeleteProgram(m_occlusionProgram);
+  m_gpuCuller.terminateGL();
+  m_depthPyramid.terminateGL();
+  glDeleteProgram(m_gpuCulledProgram);
+  glDeleteProgram(m_depthPyramidProgram);
+  glDeleteProgram(m_gpuCullProgram);
+  m_textureStreamer.clear();
+  m_diffuseTextures = 0;
+  abcg::opengl::destroySamplers();
+  m_renderQueue.destroy();
+  glDeleteProgram(m_indirectProgram);
   glDeleteProgram(m_program);
   glDeleteBuffers(1, &m_EBO);
   glDeleteBuffers(1, &m_VBO);
   glDeleteVertexArrays(1, &m_VAO);
 }
 
+void OpenGLWindow::buildSceneTree() {
+  m_sceneTree.clear();
+  m_sceneProxies.clear();
+  m_sceneChunks.clear();
+  m_sceneProxies.push_back(m_sceneTree.insert(
+      getWorldBox(duck.getMesh(), duck.getModelMatrix()), DuckObject));
+  m_sceneProxies.push_back(m_sceneTree.insert(
+      getWorldBox(ball.getMesh(), ball.position), BallObject));
+
+  // The ground and the stadium don't move, so their chunks are inserted
+  // once
+  for (auto* owner : {&ground, &field}) {
+    const auto modelMatrix{owner->getModelMatrix()};
+    const auto& chunks{owner->getMesh().getChunks()};
+    for (auto chunk : iter::range(chunks.size())) {
+      m_sceneProxies.push_back(
+          m_sceneTree.insert(chunks.at(chunk).transform(modelMatrix),
+                             FirstChunk + m_sceneChunks.size()));
+      m_sceneChunks.emplace_back(owner, chunk);
+    }
+  }
+}
+
 void OpenGLWindow::update() {
   float deltaTime { static_cast<float>(getDeltaTime()) };
 
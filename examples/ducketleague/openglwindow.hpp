@@ -21,11 +21,24 @@ class OpenGLWindow : public abcg::OpenGLWindow {
   GLuint m_VBO{};
   GLuint m_EBO{};
   GLuint m_program{};
+  // Variant of m_program drawing the opaque objects with a single
+  // glMultiDrawElementsIndirect call. 0 if OpenGL 4.3 is not available
+  GLuint m_indirectProgram{};
+  bool m_multiDrawIndirect{true};
+
+  // Diffuse textures of all objects, one layer per texture, streamed by
+  // m_textureStreamer within a budget of m_streamingBudget MiB
+  GLuint m_diffuseTextures{};
+  GLuint m_sampler{};
+  abcg::TextureStreamer m_textureStreamer;
+  int m_streamingBudget{32};
 
   int m_viewportWidth{};
   int m_viewportHeight{};
 
   Camera m_camera;
+  abcg::GeometryPool m_geometryPool;
+  abcg::RenderQueue m_renderQueue;
   float m_dollySpeed{0.0f};
   float m_truckSpeed{0.0f};
   float m_panSpeed{0.0f};
@@ -37,6 +50,37 @@ class OpenGLWindow : public abcg::OpenGLWindow {
   Field ground;
   Duck duck;
 
+  // Bounding boxes of the scene in world space, culled against the view
+  // frustum every frame. The user data of the duck and the ball are
+  // DuckObject and BallObject, and those of the chunks of the ground and
+  // the stadium are their index in m_sceneChunks plus FirstChunk. The
+  // proxies are indexed by user data
+  enum SceneObject : std::size_t { DuckObject, BallObject, FirstChunk };
+  abcg::AABBTree m_sceneTree;
+  std::vector<std::size_t> m_sceneProxies;
+  std::vector<std::pair<Field*, std::size_t>> m_sceneChunks;
+  std::vector<std::size_t> m_visibleObjects;
+  std::vector<std::size_t> m_visibleGroundChunks;
+  std::vector<std::size_t> m_visibleFieldChunks;
+
+  // Objects in the view frustum are also skipped if their boxes were
+  // hidden behind the walls in the previous frame
+  GLuint m_occlusionProgram{};
+  abcg::OcclusionCuller m_occlusionCuller;
+  bool m_occlusionCulling{true};
+
+  // Alternatively, the chunks of the ground and the stadium are culled by
+  // a compute shader against the frustum and the depth of the previous
+  // frame, and drawn without the CPU knowing which ones are visible. The
+  // programs are 0 if OpenGL 4.3 is not available
+  GLuint m_gpuCullProgram{};
+  GLuint m_depthPyramidProgram{};
+  GLuint m_gpuCulledProgram{};
+  abcg::GPUCuller m_gpuCuller;
+  abcg::DepthPyramid m_depthPyramid;
+  bool m_gpuCulling{false};
+
+  void buildSceneTree();
   void update();
 };
 
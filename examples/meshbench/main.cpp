@@ -0,0 +1,210 @@
+// Times the normal and tangent generation of abcg::Mesh on an OBJ file
+// against a serial scalar reference, the implementation abcg::Mesh used
+// before it was vectorized and parallelized.
+//
+// Usage: meshbench file.obj [runs]
+//
+// Each function is run the given number of times (100 by default) and the
+// best time is reported, as it is the least affected by other processes.
+// The largest angle between the vectors of both implementations is
+// reported too.
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cppitertools/itertools.hpp>
+#include <glm/gtc/constants.hpp>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "abcg.hpp"
+
+namespace {
+template <typename Function>
+double measureBest(int runs, Function function) {
+  auto best{std::numeric_limits<double>::max()};
+  for ([[maybe_unused]] auto run : iter::range(runs)) {
+    const auto start{std::chrono::steady_clock::now()};
+    function();
+    const std::chrono::duration<double, std::milli> elapsed{
+        std::chrono::steady_clock::now() - start};
+    best = std::min(best, elapsed.count());
+  }
+  return best;
+}
+
+// Serial scalar reference of abcg::Mesh::computeNormals()
+void computeNormalsScalar(std::vector<abcg::Vertex> &vertices,
+                          const std::vector<GLuint> &indices,
+                          std::size_t indexCount) {
+  // Clear previous vertex normals
+  for (auto &vertex : vertices) {
+    vertex.normal = glm::zero<glm::vec3>();
+  }
+
+  // Compute face normals
+  for (const auto offset : iter::range<std::size_t>(0, indexCount, 3)) {
+    // Get face vertices
+    auto &a{vertices.at(indices.at(offset + 0))};
+    auto &b{vertices.at(indices.at(offset + 1))};
+    auto &c{vertices.at(indices.at(offset + 2))};
+
+    // Compute normal
+    const auto edge1{b.position - a.position};
+    const auto edge2{c.position - b.position};
+    const glm::vec3 normal{glm::cross(edge1, edge2)};
+
+    // Accumulate on vertices
+    a.normal += normal;
+    b.normal += normal;
+    c.normal += normal;
+  }
+
+  // Normalize
+  for (auto &vertex : vertices) {
+    vertex.normal = glm::normalize(vertex.normal);
+  }
+}
+
+// Serial scalar reference of abcg::Mesh::computeTangents()
+void computeTangentsScalar(std::vector<abcg::Vertex> &vertices,
+                           const std::vector<GLuint> &indices,
+                           std::size_t indexCount) {
+  for (auto &vertex : vertices) {
+    vertex.tangent = glm::zero<glm::vec4>();
+  }
+  std::vector<glm::vec3> bitangents(vertices.size(), glm::vec3(0));
+
+  // Compute face tangents and bitangents
+  for (const auto offset : iter::range<std::size_t>(0, indexCount, 3)) {
+    // Get face indices
+    const auto i1{indices.at(offset + 0)};
+    const auto i2{indices.at(offset + 1)};
+    const auto i3{indices.at(offset + 2)};
+
+    // Get face vertices
+    auto &v1{vertices.at(i1)};
+    auto &v2{vertices.at(i2)};
+    auto &v3{vertices.at(i3)};
+
+    const auto e1{v2.position - v1.position};
+    const auto e2{v3.position - v1.position};
+    const auto delta1{v2.texCoord - v1.texCoord};
+    const auto delta2{v3.texCoord - v1.texCoord};
+
+    // clang-format off
+    glm::mat2 M;
+    M[0][0] =  delta2.t;
+    M[0][1] = -delta1.t;
+    M[1][0] = -delta2.s;
+    M[1][1] =  delta1.s;
+    M *= (1.0f / (delta1.s * delta2.t - delta2.s * delta1.t));
+
+    const auto tangent{glm::vec4(M[0][0] * e1.x + M[0][1] * e2.x,
+                                 M[0][0] * e1.y + M[0][1] * e2.y,
+                                 M[0][0] * e1.z + M[0][1] * e2.z, 0.0f)};
+
+    const auto bitangent{glm::vec3(M[1][0] * e1.x + M[1][1] * e2.x,
+                                   M[1][0] * e1.y + M[1][1] * e2.y,
+                                   M[1][0] * e1.z + M[1][1] * e2.z)};
+    // clang-format on
+
+    // Accumulate on vertices
+    v1.tangent += tangent;
+    v2.tangent += tangent;
+    v3.tangent += tangent;
+
+    bitangents.at(i1) += bitangent;
+    bitangents.at(i2) += bitangent;
+    bitangents.at(i3) += bitangent;
+  }
+
+  for (auto &&[i, vertex] : iter::enumerate(vertices)) {
+    const auto &n{vertex.normal};
+    const auto &t{glm::vec3(vertex.tangent)};
+
+    // Orthogonalize t with respect to n
+    const auto tangent{t - n * glm::dot(n, t)};
+    vertex.tangent = glm::vec4(glm::normalize(tangent), 0);
+
+    // Compute handedness of re-orthogonalized basis
+    const auto b{glm::cross(n, t)};
+    const auto handedness{glm::dot(b, bitangents.at(i))};
+    vertex.tangent.w = (handedness < 0.0f) ? -1.0f : 1.0f;
+  }
+}
+
+// Largest angle in degrees between corresponding vectors. Vectors that are
+// not finite in both, such as normals of degenerate faces, are skipped
+template <typename Getter>
+float maxAngle(const std::vector<abcg::Vertex> &reference,
+               const std::vector<abcg::Vertex> &result, Getter getter) {
+  auto largest{0.0f};
+  for (auto &&[a, b] : iter::zip(reference, result)) {
+    const auto cosine{glm::dot(getter(a), getter(b))};
+    if (!std::isfinite(cosine)) continue;
+    largest = std::max(
+        largest, glm::degrees(std::acos(std::clamp(cosine, -1.0f, 1.0f))));
+  }
+  return largest;
+}
+
+void report(std::string_view name, double reference, double result,
+            float angle) {
+  fmt::print("{}: {:.3f} ms serial scalar, {:.3f} ms abcg::Mesh, {:.2f}x, "
+             "max difference {:.4f} degrees\n",
+             name, reference, result, reference / result, angle);
+}
+}  // namespace
+
+int main(int argc, char **argv) {
+  if (argc < 2) {
+    fmt::print(stderr, "Usage: {} file.obj [runs]\n", argv[0]);
+    return -1;
+  }
+
+  try {
+    const auto runs{argc > 2 ? std::max(std::stoi(argv[2]), 1) : 100};
+
+    abcg::Mesh mesh;
+    // Parse the file every time so that no cache is written next to it
+    mesh.loadObj(argv[1], false);
+    fmt::print("{}: {} triangles, {} vertices\n", argv[1],
+               mesh.getNumTriangles(), mesh.getVertices().size());
+
+    // The levels of detail, if any, are not included
+    const auto &indices{mesh.getIndices()};
+    const auto indexCount{static_cast<std::size_t>(mesh.getNumTriangles()) *
+                          3};
+    auto reference{mesh.getVertices()};
+
+    const auto normalsReference{measureBest(
+        runs, [&] { computeNormalsScalar(reference, indices, indexCount); })};
+    const auto normals{measureBest(runs, [&] { mesh.computeNormals(); })};
+    report("computeNormals", normalsReference, normals,
+           maxAngle(reference, mesh.getVertices(),
+                    [](const auto &vertex) { return vertex.normal; }));
+
+    // Both start from the normals of abcg::Mesh
+    reference = mesh.getVertices();
+    const auto tangentsReference{measureBest(
+        runs, [&] { computeTangentsScalar(reference, indices, indexCount); })};
+    const auto tangents{measureBest(runs, [&] { mesh.computeTangents(); })};
+    report("computeTangents", tangentsReference, tangents,
+           maxAngle(reference, mesh.getVertices(), [](const auto &vertex) {
+             return glm::vec3(vertex.tangent);
+           }));
+    std::size_t flips{};
+    for (auto &&[a, b] : iter::zip(reference, mesh.getVertices())) {
+      if (a.tangent.w != b.tangent.w) ++flips;
+    }
+    fmt::print("Handedness differences: {}\n", flips);
+  } catch (std::exception &exception) {
+    fmt::print(stderr, "{}\n", exception.what());
+    return -1;
+  }
+  return 0;
+}
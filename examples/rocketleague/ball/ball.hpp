@@ -9,16 +9,16 @@ class Ball {
 
   void loadModelFromFile(std::string_view path);
 
-  std::vector<Vertex> m_vertices;
-  std::vector<GLuint> m_indices;
-
   [[nodiscard]] int getNumTriangles() const {
-    return static_cast<int>(m_indices.size()) / 3;
+    return m_mesh.getNumTriangles();
   }
 
   void update(float deltaTime);
-  void paintGL(Camera m_camera);
+  [[nodiscard]] abcg::AABB getWorldBox() const;
+
+  void paintGL();
   void initializeGL(GLuint program);
+  void terminateGL();
   float x();
   float y();
   float z();
@@ -30,16 +30,10 @@ class Ball {
   glm::mat4 position{1.0f};
 
  private:
-  GLuint m_VAO{};
-  GLuint m_VBO{};
-  GLuint m_EBO{};
+  abcg::Mesh m_mesh;
   GLuint m_program{};
-  
-  
-  glm::vec3 gravity{0.0f, -50.0f, 0.0f};
 
-  void createBuffers();
-  void standardize();
+  glm::vec3 gravity{0.0f, -50.0f, 0.0f};
 
   void x(float value);
   void y(float value);
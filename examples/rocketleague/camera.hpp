@@ -8,17 +8,6 @@
 
 class OpenGLWindow;
 
-struct Vertex {
-  glm::vec3 position{};
-  glm::vec3 normal{};
-
-  bool operator==(const Vertex& other) const noexcept {
-    static const auto epsilon{std::numeric_limits<float>::epsilon()};
-    return glm::all(glm::epsilonEqual(position, other.position, epsilon)) &&
-           glm::all(glm::epsilonEqual(normal, other.normal, epsilon));
-  }
-};
-
 class Camera {
  public:
 
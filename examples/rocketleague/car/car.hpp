@@ -11,16 +11,16 @@ class Car {
   void loadModelFromFile(std::string_view path);
   //void setupVAO(GLuint program);
 
-  std::vector<Vertex> m_vertices;
-  std::vector<GLuint> m_indices;
-
   [[nodiscard]] int getNumTriangles() const {
-    return static_cast<int>(m_indices.size()) / 3;
+    return m_mesh.getNumTriangles();
   }
 
+  [[nodiscard]] abcg::AABB getWorldBox() const;
+
   void update(Ball* ball);
   void paintGL();
   void initializeGL(GLuint program);
+  void terminateGL();
   
   float x();
   float y();
@@ -33,18 +33,13 @@ class Car {
   float speed { 0.0f };
 
  private:
-  GLuint m_VAO{};
-  GLuint m_VBO{};
-  GLuint m_EBO{};
+  abcg::Mesh m_mesh;
   GLuint m_program{};
   glm::mat4 position{1.0f};
 
   glm::vec3 lookDirection{ 1.0f, 0.0f, 0.0f };
   
 
-  void createBuffers();
-  void standardize();
-
   void x(float value);
   void y(float value);
   void z(float value);
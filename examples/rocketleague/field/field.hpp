@@ -9,25 +9,23 @@ class Field {
 
   void loadModelFromFile(std::string_view path);
 
-  std::vector<Vertex> m_vertices;
-  std::vector<GLuint> m_indices;
-
   [[nodiscard]] int getNumTriangles() const {
-    return static_cast<int>(m_indices.size()) / 3;
+    return m_mesh.getNumTriangles();
   }
 
+  [[nodiscard]] glm::mat4 getModelMatrix() const;
+  [[nodiscard]] abcg::AABB getWorldBox() const;
+
   void paintGL();
   void initializeGL(GLuint program);
+  void terminateGL();
 
  private:
-  GLuint m_VAO{};
-  GLuint m_VBO{};
-  GLuint m_EBO{};
+  abcg::Mesh m_mesh;
   GLuint m_program{};
 
   glm::vec4 color { 58/255.0f, 95/255.0f, 11/255.0f, 1.0f};
 
-  void standardize();
   
 };
 
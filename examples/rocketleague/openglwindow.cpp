@@ -2,27 +2,13 @@
 
 #include <fmt/core.h>
 #include <imgui.h>
-#include <tiny_obj_loader.h>
 
 #include <cppitertools/itertools.hpp>
 #include <glm/gtx/fast_trigonometry.hpp>
-#include <glm/gtx/hash.hpp>
-#include <unordered_map>
 
 #include "ball/ball.hpp"
 #include "field/field.hpp"
 
-// Custom specialization of std::hash injected in namespace std
-namespace std {
-template <>
-struct hash<Vertex> {
-  size_t operator()(Vertex const& vertex) const noexcept {
-    std::size_t h1{std::hash<glm::vec3>()(vertex.position)};
-    return h1;
-  }
-};
-}  // namespace std
-
 void OpenGLWindow::handleEvent(SDL_Event& ev) {
   if (ev.type == SDL_KEYDOWN) {
     if (ev.key.keysym.sym == SDLK_UP || ev.key.keysym.sym == SDLK_w)
@@ -86,9 +72,20 @@ void OpenGLWindow::paintGL() {
 
   glViewport(0, 0, m_viewportWidth, m_viewportHeight);
 
-  field.paintGL();
-  car.paintGL();
-  ball.paintGL(m_camera); 
+  // The view and projection matrices are set here rather than by the ball,
+  // which may be culled
+  glUseProgram(m_program);
+  m_camera.init(m_program);
+  glUseProgram(0);
+
+  // Objects whose bounding boxes are outside the view frustum are skipped
+  const abcg::Frustum frustum{m_camera.m_projMatrix * m_camera.m_viewMatrix};
+  auto isVisible{[&](const abcg::AABB& box) {
+    return frustum.intersectsBox(box.boundsMin, box.boundsMax);
+  }};
+  if (isVisible(field.getWorldBox())) field.paintGL();
+  if (isVisible(car.getWorldBox())) car.paintGL();
+  if (isVisible(ball.getWorldBox())) ball.paintGL();
 }
 
 void OpenGLWindow::paintUI() { 
@@ -103,6 +100,9 @@ void OpenGLWindow::resizeGL(int width, int height) {
 }
 
 void OpenGLWindow::terminateGL() {
+  ball.terminateGL();
+  car.terminateGL();
+  field.terminateGL();
   glDeleteProgram(m_program);
   glDeleteBuffers(1, &m_EBO);
   glDeleteBuffers(1, &m_VBO);
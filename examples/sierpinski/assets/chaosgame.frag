@@ -0,0 +1,6 @@
+#version 410
+
+out vec4 outColor;
+
+// Each point adds one hit to the density texture
+void main() { outColor = vec4(1); }
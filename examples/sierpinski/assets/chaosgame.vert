@@ -0,0 +1,31 @@
+#version 410
+
+// Seed of the frame, so that each frame draws new points
+uniform uint seed;
+
+const vec2 vertices[3] = vec2[3](vec2(0, 1), vec2(-1, -1), vec2(1, -1));
+
+// After n steps, the point is closer than 2^-n to the attractor, so 24 steps
+// reach the precision of a float whatever the starting point
+const int iterations = 24;
+
+// PCG hash (Jarzynski and Olano, 2020)
+uint pcgHash(uint value) {
+  uint state = value * 747796405u + 2891336453u;
+  uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+  return (word >> 22u) ^ word;
+}
+
+void main() {
+  // Each vertex plays its own chaos game with its own random sequence
+  uint state = pcgHash(uint(gl_VertexID) ^ pcgHash(seed));
+
+  vec2 position = vec2(0);
+  for (int i = 0; i < iterations; ++i) {
+    state = pcgHash(state);
+    position = (position + vertices[state % 3u]) * 0.5;
+  }
+
+  gl_PointSize = 1.0;
+  gl_Position = vec4(position, 0, 1);
+}
@@ -0,0 +1,15 @@
+#version 410
+
+precision highp float;
+
+// Number of hits per pixel
+uniform highp sampler2D density;
+// Exposure divided by the mean number of hits per pixel
+uniform float scale;
+
+out vec4 outColor;
+
+void main() {
+  float hits = texelFetch(density, ivec2(gl_FragCoord.xy), 0).r;
+  outColor = vec4(vec3(1.0 - exp(-hits * scale)), 1);
+}
@@ -28,6 +28,21 @@ void OpenGLWindow::initializeGL() {
   // Create shader program
   m_program = createProgramFromString(vertexShader, fragmentShader);
 
+  // Create OpenGL buffers for the point drawn in each frame
+  setupModel();
+
+  // Create programs of the accumulation mode
+  m_chaosGameProgram =
+      createProgramFromFile(getAssetsPath() + "chaosgame.vert",
+                            getAssetsPath() + "chaosgame.frag");
+  m_toneMappingProgram =
+      createProgramFromFile(getAssetsPath() + "tonemapping.vert",
+                            getAssetsPath() + "tonemapping.frag");
+  m_seedLoc = glGetUniformLocation(m_chaosGameProgram, "seed");
+  m_densityLoc = glGetUniformLocation(m_toneMappingProgram, "density");
+  m_scaleLoc = glGetUniformLocation(m_toneMappingProgram, "scale");
+  glGenVertexArrays(1, &m_emptyVAO);
+
   // Clear window
   glClearColor(0, 0, 0, 1);
   glClear(GL_COLOR_BUFFER_BIT);
@@ -50,8 +65,15 @@ void OpenGLWindow::initializeGL() {
 }
 
 void OpenGLWindow::paintGL() {
-  // Create OpenGL buffers for the single point at m_P
-  setupModel();
+  if (m_mode == Mode::Accumulation) {
+    paintAccumulation();
+    return;
+  }
+
+  // Copy the point at m_P to the stream buffer. As the offset is a multiple
+  // of the size of a point, it gives the index of the vertex to draw
+  m_streamBuffer.begin();
+  auto offset{m_streamBuffer.push(m_P)};
 
   // Set the viewport
   glViewport(0, 0, m_viewportWidth, m_viewportHeight);
@@ -62,12 +84,14 @@ void OpenGLWindow::paintGL() {
   glBindVertexArray(m_vao);
 
   // Draw a single point
-  glDrawArrays(GL_POINTS, 0, 1);
+  glDrawArrays(GL_POINTS, static_cast<GLint>(offset / sizeof(m_P)), 1);
 
   // End using VAO
   glBindVertexArray(0);
   // End using the shader program
   glUseProgram(0);
+
+  m_streamBuffer.end();
   
   // Randomly choose a triangle vertex index
   std::uniform_int_distribution<int> intDistribution(0, m_points.size() - 1);
@@ -81,19 +105,70 @@ void OpenGLWindow::paintGL() {
   // fmt::print("({:+.2f}, {:+.2f})\n", m_P.x, m_P.y);
 }
 
-void OpenGLWindow::setupModel() {
-  // Release previous VBO and VAO
-  glDeleteBuffers(1, &m_vboVertices);
+void OpenGLWindow::paintUI() {
+  abcg::OpenGLWindow::paintUI();
+
+  {
+    ImGui::SetNextWindowPos(ImVec2(5, 81));
+    ImGui::Begin(" ", nullptr, ImGuiWindowFlags_NoDecoration);
+
+    auto mode{static_cast<int>(m_mode)};
+    ImGui::RadioButton("Single point", &mode,
+                       static_cast<int>(Mode::SinglePoint));
+    if (m_accumulationSupported) {
+      ImGui::RadioButton("Accumulation", &mode,
+                         static_cast<int>(Mode::Accumulation));
+    } else {
+      ImGui::Text("Float render targets not supported");
+    }
+    if (mode != static_cast<int>(m_mode)) {
+      m_mode = static_cast<Mode>(mode);
+      glClear(GL_COLOR_BUFFER_BIT);
+      clearAccumulation();
+    }
+
+    if (m_mode == Mode::Accumulation) {
+      ImGui::PushItemWidth(150);
+      ImGui::SliderInt("Points/frame", &m_pointsPerFrameLog2, 10, 24,
+                       "2^%d");
+      ImGui::SliderFloat("Exposure", &m_exposure, 0.01f, 1.0f, "%.2f");
+      ImGui::PopItemWidth();
+      ImGui::Text("%.1f M points/s", m_pointsPerSecond / 1e6);
+      ImGui::Text("%.1f M points", m_accumulatedPoints / 1e6);
+    }
+
+    if (ImGui::Button("Clear window", ImVec2(150, 30))) {
+      glClear(GL_COLOR_BUFFER_BIT);
+      clearAccumulation();
+    }
+
+    ImGui::End();
+  }
+}
+
+void OpenGLWindow::resizeGL(int width, int height) {
+  m_viewportWidth = width;
+  m_viewportHeight = height;
+
+  glClear(GL_COLOR_BUFFER_BIT);
+  setupAccumulation();
+}
+
+void OpenGLWindow::terminateGL() {
+  glDeleteProgram(m_program);
+  glDeleteProgram(m_chaosGameProgram);
+  glDeleteProgram(m_toneMappingProgram);
+  m_streamBuffer.destroy();
   glDeleteVertexArrays(1, &m_vao);
+  glDeleteVertexArrays(1, &m_emptyVAO);
+  glDeleteFramebuffers(1, &m_densityFramebuffer);
+  glDeleteTextures(1, &m_densityTexture);
+}
 
-  // Generate a new VBO and get the associated ID
-  glGenBuffers(1, &m_vboVertices);
-  // Bind VBO in order to use it
-  glBindBuffer(GL_ARRAY_BUFFER, m_vboVertices);
-  // Upload data to VBO
-  glBufferData(GL_ARRAY_BUFFER, sizeof(m_P), &m_P, GL_STATIC_DRAW);
-  // Unbinding the VBO is allowed (data can be released now)
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
+void OpenGLWindow::setupModel() {
+  // Create a stream buffer with room for one point per frame. It is never
+  // reallocated, so the VAO is set up only once
+  m_streamBuffer.create(sizeof(m_P));
 
   // Get location of attributes in the program
   GLint positionAttribute = glGetAttribLocation(m_program, "inPosition");
@@ -105,10 +180,102 @@ void OpenGLWindow::setupModel() {
   glBindVertexArray(m_vao);
 
   glEnableVertexAttribArray(positionAttribute);
-  glBindBuffer(GL_ARRAY_BUFFER, m_vboVertices);
+  glBindBuffer(GL_ARRAY_BUFFER, m_streamBuffer.getBuffer());
   glVertexAttribPointer(positionAttribute, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
   glBindBuffer(GL_ARRAY_BUFFER, 0);
 
   // End of binding to current VAO
   glBindVertexArray(0);
-}
\ No newline at end of file
+}
+
+void OpenGLWindow::setupAccumulation() {
+  // Release previous texture and framebuffer
+  glDeleteFramebuffers(1, &m_densityFramebuffer);
+  glDeleteTextures(1, &m_densityTexture);
+  m_densityFramebuffer = 0;
+  m_densityTexture = 0;
+  if (!m_accumulationSupported) return;
+
+  // Counts are exact up to 2^24 hits per pixel. WebGL 2 needs
+  // EXT_color_buffer_float and EXT_float_blend to render to this texture
+  glGenTextures(1, &m_densityTexture);
+  glBindTexture(GL_TEXTURE_2D, m_densityTexture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_R32F, m_viewportWidth, m_viewportHeight,
+               0, GL_RED, GL_FLOAT, nullptr);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glGenFramebuffers(1, &m_densityFramebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, m_densityFramebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         m_densityTexture, 0);
+  auto status{glCheckFramebufferStatus(GL_FRAMEBUFFER)};
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    m_accumulationSupported = false;
+    m_mode = Mode::SinglePoint;
+    setupAccumulation();
+    return;
+  }
+
+  clearAccumulation();
+}
+
+void OpenGLWindow::clearAccumulation() {
+  m_accumulatedPoints = 0;
+  if (m_densityFramebuffer == 0) return;
+
+  const std::array<GLfloat, 4> zero{};
+  glBindFramebuffer(GL_FRAMEBUFFER, m_densityFramebuffer);
+  glClearBufferfv(GL_COLOR, 0, zero.data());
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+void OpenGLWindow::paintAccumulation() {
+  if (m_densityFramebuffer == 0) return;
+
+  // Add the hits of this frame to the density texture
+  auto pointsPerFrame{GLsizei{1} << m_pointsPerFrameLog2};
+  glBindFramebuffer(GL_FRAMEBUFFER, m_densityFramebuffer);
+  glViewport(0, 0, m_viewportWidth, m_viewportHeight);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE);
+
+  glUseProgram(m_chaosGameProgram);
+  glBindVertexArray(m_emptyVAO);
+  glUniform1ui(m_seedLoc, static_cast<GLuint>(m_randomEngine()));
+  glDrawArrays(GL_POINTS, 0, pointsPerFrame);
+
+  glDisable(GL_BLEND);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+  m_accumulatedPoints += static_cast<std::uint64_t>(pointsPerFrame);
+
+  // Map the hits to intensities, relative to the mean number of hits per
+  // pixel so that the image doesn't saturate as points accumulate
+  auto pixels{static_cast<double>(m_viewportWidth) * m_viewportHeight};
+  auto scale{m_exposure * pixels / static_cast<double>(m_accumulatedPoints)};
+
+  glUseProgram(m_toneMappingProgram);
+  glActiveTexture(GL_TEXTURE0);
+  glBindTexture(GL_TEXTURE_2D, m_densityTexture);
+  glUniform1i(m_densityLoc, 0);
+  glUniform1f(m_scaleLoc, static_cast<float>(scale));
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  glBindVertexArray(0);
+  glUseProgram(0);
+
+  // Points per second over the last second. The draw calls are
+  // asynchronous, but the frame rate follows the GPU when it is the
+  // bottleneck
+  m_throughputPoints += static_cast<std::uint64_t>(pointsPerFrame);
+  if (auto elapsed{m_throughputTimer.elapsed()}; elapsed >= 1.0) {
+    m_pointsPerSecond = static_cast<double>(m_throughputPoints) / elapsed;
+    m_throughputPoints = 0;
+    m_throughputTimer.restart();
+  }
+}
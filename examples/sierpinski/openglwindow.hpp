@@ -2,6 +2,7 @@
 #define OPENGLWINDOW_HPP_
 
 #include <array>
+#include <cstdint>
 #include <glm/vec2.hpp>
 #include <random>
 
@@ -16,10 +17,18 @@ class OpenGLWindow : public abcg::OpenGLWindow {
   void terminateGL() override;
 
  private:
+  // SinglePoint draws one point per frame on top of the previous frames.
+  // Accumulation plays the chaos game on the GPU, counting the hits of each
+  // pixel in a float texture
+  enum class Mode { SinglePoint, Accumulation };
+  Mode m_mode{Mode::SinglePoint};
+
   GLuint m_vao{};
-  GLuint m_vboVertices{};
   GLuint m_program{};
 
+  // Holds the point drawn in each frame
+  abcg::StreamBuffer m_streamBuffer;
+
   int m_viewportWidth{};
   int m_viewportHeight{};
 
@@ -32,6 +41,31 @@ class OpenGLWindow : public abcg::OpenGLWindow {
   };
   glm::vec2 m_P{};
 
+  GLuint m_chaosGameProgram{};
+  GLuint m_toneMappingProgram{};
+  GLint m_seedLoc{};
+  GLint m_densityLoc{};
+  GLint m_scaleLoc{};
+  // Both programs generate their vertices from gl_VertexID
+  GLuint m_emptyVAO{};
+
+  // Number of hits per pixel. Not created if float render targets are not
+  // supported
+  GLuint m_densityTexture{};
+  GLuint m_densityFramebuffer{};
+  bool m_accumulationSupported{true};
+
+  int m_pointsPerFrameLog2{20};
+  float m_exposure{0.1f};
+  std::uint64_t m_accumulatedPoints{};
+
+  abcg::ElapsedTimer m_throughputTimer;
+  std::uint64_t m_throughputPoints{};
+  double m_pointsPerSecond{};
+
   void setupModel();
+  void setupAccumulation();
+  void clearAccumulation();
+  void paintAccumulation();
 };
 #endif
\ No newline at end of file